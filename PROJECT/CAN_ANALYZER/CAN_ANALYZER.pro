@@ -0,0 +1,44 @@
+TARGET_SOURCE = $${PWD}/../../SOURCE
+
+TARGET = can_analyzer
+
+QT       += core concurrent
+QT       -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    $${TARGET_SOURCE}/ANALYZER/main.cpp \
+    $${TARGET_SOURCE}/ANALYZER/analyzer.cpp \
+    $${TARGET_SOURCE}/ANALYZER/benchmark.cpp \
+    $${TARGET_SOURCE}/ANALYZER/converter.cpp \
+    $${TARGET_SOURCE}/TRACE/capturereader.cpp \
+    $${TARGET_SOURCE}/TRACE/capturewriter.cpp \
+    $${TARGET_SOURCE}/TRACE/logformat.cpp \
+    $${TARGET_SOURCE}/STATISTICS/latency.cpp \
+    $${TARGET_SOURCE}/CAN/bulktransfer.cpp \
+    $${TARGET_SOURCE}/CAN/busload.cpp \
+
+HEADERS += \
+    $${TARGET_SOURCE}/ANALYZER/analyzer.h \
+    $${TARGET_SOURCE}/ANALYZER/benchmark.h \
+    $${TARGET_SOURCE}/ANALYZER/converter.h \
+    $${TARGET_SOURCE}/TRACE/capturereader.h \
+    $${TARGET_SOURCE}/TRACE/capturewriter.h \
+    $${TARGET_SOURCE}/TRACE/logformat.h \
+    $${TARGET_SOURCE}/STATISTICS/latency.h \
+    $${TARGET_SOURCE}/TRACE/capturefile.h \
+    $${TARGET_SOURCE}/CAN/bulktransfer.h \
+    $${TARGET_SOURCE}/CAN/busload.h \
+
+# Aggiunge tutti i path di progetto
+INCLUDEPATH += \
+    $${TARGET_SOURCE}/ANALYZER \
+    $${TARGET_SOURCE}/STATISTICS \
+    $${TARGET_SOURCE}/TRACE \
+    $${TARGET_SOURCE}/CAN \
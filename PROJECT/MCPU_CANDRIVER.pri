@@ -1,7 +1,14 @@
 
-QT       += core gui
+QT       += core
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+# Headless target (CONFIG += headless): no QtWidgets and no debug window
+headless {
+    QT      -= gui
+    DEFINES += HEADLESS
+} else {
+    QT      += gui
+    greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+}
 
 CONFIG += c++11
 
@@ -9,28 +16,46 @@ CONFIG += c++11
 # In order to do so, uncomment the following line.
 DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Log levels compiled in the release build (see asynclog.h)
+CONFIG(release, debug|release): DEFINES += LOG_MIN_LEVEL=1
+
 #Include supporto per Qt Network (moduli TCP/IP)
 QT += network
 
-FORMS += \
-    $${TARGET_SOURCE}/WINDOW/window.ui \
-
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
 
-LIBS += -L$${TARGET_SOURCE}/DLL/ -lvs_can_api
+# VSCAN-free target (CONFIG += novscan): the device library is not linked,
+# only the replay backend is available (deterministic replay on any host)
+novscan {
+    DEFINES += NO_VSCAN
+} else {
+    LIBS += -L$${TARGET_SOURCE}/DLL/ -lvs_can_api
+}
 
 DISTFILES +=
 
 SOURCES += \
     $${TARGET_SOURCE}/main.cpp \
     $${SHARED}/APPLOG/applog.cpp \
+    $${TARGET_SOURCE}/LOG/asynclog.cpp \
     $${TARGET_SOURCE}/SERVER/server.cpp \
     $${TARGET_SOURCE}/CAN/can_driver.cpp \
-    $${TARGET_SOURCE}/WINDOW/window.cpp \
+    $${TARGET_SOURCE}/CAN/isotp.cpp \
+    $${TARGET_SOURCE}/CAN/bulktransfer.cpp \
+    $${TARGET_SOURCE}/CAN/busload.cpp \
+    $${TARGET_SOURCE}/CAN/replay.cpp \
+    $${TARGET_SOURCE}/CAN/cantap.cpp \
+    $${TARGET_SOURCE}/STATISTICS/latency.cpp \
+    $${TARGET_SOURCE}/STATISTICS/metrics.cpp \
+    $${TARGET_SOURCE}/TRACE/flightrecorder.cpp \
+    $${TARGET_SOURCE}/TRACE/capture.cpp \
+    $${TARGET_SOURCE}/TRACE/capturereader.cpp \
+    $${TARGET_SOURCE}/TRACE/logformat.cpp \
+    $${TARGET_SOURCE}/TRACE/candumptap.cpp \
     $${SHARED}/APPLICATION_INTERFACE/applicationInterface.cpp \
     $${TARGET_SOURCE}/INTERFACE/interface.cpp \
     $${SHARED}/CONFIGFILE/configfile.cpp \
@@ -38,9 +63,24 @@ SOURCES += \
 HEADERS += \
     $${TARGET_SOURCE}/application.h \
     $${SHARED}/APPLOG/applog.h \
+    $${TARGET_SOURCE}/LOG/asynclog.h \
     $${TARGET_SOURCE}/SERVER/server.h \
     $${TARGET_SOURCE}/CAN/can_driver.h \
-    $${TARGET_SOURCE}/WINDOW/window.h \
+    $${TARGET_SOURCE}/CAN/isotp.h \
+    $${TARGET_SOURCE}/CAN/bulktransfer.h \
+    $${TARGET_SOURCE}/CAN/busload.h \
+    $${TARGET_SOURCE}/CAN/replay.h \
+    $${TARGET_SOURCE}/CAN/cantap.h \
+    $${TARGET_SOURCE}/STATISTICS/latency.h \
+    $${TARGET_SOURCE}/STATISTICS/counters.h \
+    $${TARGET_SOURCE}/STATISTICS/metrics.h \
+    $${TARGET_SOURCE}/TRACE/flightrecorder.h \
+    $${TARGET_SOURCE}/TRACE/capturefile.h \
+    $${TARGET_SOURCE}/TRACE/capture.h \
+    $${TARGET_SOURCE}/TRACE/capturereader.h \
+    $${TARGET_SOURCE}/TRACE/logformat.h \
+    $${TARGET_SOURCE}/TRACE/candumptap.h \
+    $${TARGET_SOURCE}/configuration.h \
     $${TARGET_SOURCE}/DLL/vs_can_api.h \
     $${SHARED}/APPLICATION_INTERFACE/applicationInterface.h \
     $${TARGET_SOURCE}/INTERFACE/interface.h \
@@ -52,8 +92,10 @@ INCLUDEPATH += \
     $${TARGET_SOURCE}/DLL \
     $${TARGET_SOURCE}/SERVER \
     $${TARGET_SOURCE}/CAN \
-    $${TARGET_SOURCE}/WINDOW \
+    $${TARGET_SOURCE}/STATISTICS \
+    $${TARGET_SOURCE}/TRACE \
     $${SHARED}/APPLOG \
+    $${TARGET_SOURCE}/LOG \
     $${TARGET_SOURCE} \
     $${SHARED}/APPLICATION_INTERFACE \
     $${TARGET_SOURCE}/INTERFACE \
@@ -62,5 +104,19 @@ INCLUDEPATH += \
 DEPENDPATH += \
     $${TARGET_SOURCE}/DLL \
 
+# Optional debug window (-win option)
+!headless {
+    FORMS += \
+        $${TARGET_SOURCE}/WINDOW/window.ui \
+
+    SOURCES += \
+        $${TARGET_SOURCE}/WINDOW/window.cpp \
+        $${TARGET_SOURCE}/WINDOW/trafficmodel.cpp \
 
+    HEADERS += \
+        $${TARGET_SOURCE}/WINDOW/window.h \
+        $${TARGET_SOURCE}/WINDOW/trafficmodel.h \
 
+    INCLUDEPATH += \
+        $${TARGET_SOURCE}/WINDOW \
+}
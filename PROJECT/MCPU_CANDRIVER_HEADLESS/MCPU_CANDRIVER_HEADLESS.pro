@@ -0,0 +1,11 @@
+
+# Headless target: QCoreApplication only, the debug window is not built
+CONFIG += headless console
+# Add CONFIG+=novscan on the qmake command line for a replay-only build without the VSCAN library
+
+TARGET_SOURCE = $${PWD}/../../SOURCE
+TARGET_RESOURCE = $${PWD}/../../RESOURCES
+SHARED = $${PWD}/../../MCPU_SHARED_MODULES/MODULES
+include($${PWD}/../MCPU_CANDRIVER.pri)
+
+
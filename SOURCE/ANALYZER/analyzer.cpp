@@ -0,0 +1,370 @@
+#include "analyzer.h"
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QDir>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+
+/**
+ * @brief This function adds an inter-arrival interval to the statistics of a canId
+ *
+ * @param s: the canId statistics
+ * @param dt: the interval (ns)
+ * @param gapNs: the gap threshold (ns)
+ */
+static inline void addInterval(captureAnalyzer::idStatistics* s, qint64 dt, qint64 gapNs){
+    if(dt < 0) return;
+    double us = dt / 1000.0;
+    s->intervals++;
+    s->sum += us;
+    s->sumSq += us * us;
+    if(dt > s->maxInterval) s->maxInterval = dt;
+    if(dt > gapNs) s->gaps++;
+}
+
+static inline void recordRtt(captureAnalyzer::deviceStatistics* dev, qint64 dt){
+    qint64 us = dt / 1000;
+    if(us < 0) us = 0;
+    if(us > 0xFFFFFFFF) us = 0xFFFFFFFF;
+    dev->answers++;
+    dev->rtt.record((quint32) us);
+}
+
+/**
+ * @brief captureAnalyzer class constructor
+ */
+captureAnalyzer::captureAnalyzer(){
+    gapNs = (qint64) DEFAULT_GAP * 1000000;
+    records = 0;
+    elapsed = 0;
+    result = new chunkResult;
+    clearResult(result);
+}
+
+captureAnalyzer::~captureAnalyzer(){
+    for(int i=0; i<files.size(); i++){
+        files[i].file->close();
+        delete files[i].file;
+    }
+    delete result;
+}
+
+void captureAnalyzer::clearResult(chunkResult* res){
+    res->records = nullptr;
+    res->count = 0;
+    res->first = 0;
+    res->last = 0;
+    res->busGaps = 0;
+    res->maxSilence = 0;
+    res->disordered = 0;
+    res->hasRequest = false;
+    res->leading.valid = false;
+    res->trailing.valid = false;
+    memset(res->ids, 0, sizeof(res->ids));
+    for(uint i=0; i<MAX_DEVICES; i++){
+        res->devices[i].requests = 0;
+        res->devices[i].answers = 0;
+        res->devices[i].timeouts = 0;
+        res->devices[i].rtt.reset();
+    }
+}
+
+/**
+ * @brief This function maps the capture files
+ *
+ * The files shall belong to the same capture (same header startTime):
+ * they are sorted by the header fileIndex.
+ *
+ * @param paths: the capture files
+ * @return true in case of success; see getError() otherwise
+ */
+bool captureAnalyzer::open(const QStringList& paths){
+    for(int i=0; i<paths.size(); i++){
+        mappedFile f;
+        f.file = new QFile(paths[i]);
+
+        if(!f.file->open(QIODevice::ReadOnly)){
+            error = QString("unable to open %1").arg(paths[i]);
+            delete f.file;
+            return false;
+        }
+
+        qint64 size = f.file->size();
+        uchar* map = (size >= (qint64) sizeof(captureFileHeader)) ? f.file->map(0, size) : nullptr;
+        f.header = (const captureFileHeader*) map;
+        if((!map) || (memcmp(f.header->magic, CAPTURE_MAGIC, 8)) || (f.header->version != CAPTURE_VERSION) || (f.header->recordSize != sizeof(captureRecord))){
+            error = QString("%1 is not a valid capture file").arg(paths[i]);
+            f.file->close();
+            delete f.file;
+            return false;
+        }
+
+        if((files.size()) && (f.header->startTime != files[0].header->startTime)){
+            error = QString("%1 belongs to a different capture").arg(paths[i]);
+            f.file->close();
+            delete f.file;
+            return false;
+        }
+
+        // A file not closed (capture interrupted) can be longer than the valid records
+        f.records = (const captureRecord*) (map + sizeof(captureFileHeader));
+        f.count = (size - sizeof(captureFileHeader)) / sizeof(captureRecord);
+        if(f.header->records < f.count) f.count = f.header->records;
+
+        int pos = 0;
+        while((pos < files.size()) && (files[pos].header->fileIndex < f.header->fileIndex)) pos++;
+        files.insert(pos, f);
+        records += f.count;
+    }
+
+    return true;
+}
+
+/**
+ * @brief This function computes the partial statistics of a chunk
+ *
+ * This function is executed in parallel by the worker threads:
+ * it accesses only the chunk records and the chunk result.
+ *
+ * @param chunk: the chunk to be processed
+ */
+void captureAnalyzer::processChunk(chunkResult* chunk){
+    p2pEvent pending;
+    pending.valid = false;
+
+    qint64 prev = 0;
+    for(quint64 i=0; i<chunk->count; i++){
+        const captureRecord* r = &chunk->records[i];
+        qint64 ts = r->timestamp;
+
+        // Bus silences
+        if(i){
+            qint64 dt = ts - prev;
+            if(dt < 0) chunk->disordered++;
+            else{
+                if(dt > chunk->maxSilence) chunk->maxSilence = dt;
+                if(dt > chunk->gapNs) chunk->busGaps++;
+            }
+        }else chunk->first = ts;
+        prev = ts;
+
+        // canId statistics
+        uint id = r->id & (MAX_IDS - 1);
+        idStatistics* s = &chunk->ids[id];
+        if(s->rx + s->tx) addInterval(s, ts - s->last, chunk->gapNs);
+        else s->first = ts;
+        s->last = ts;
+        if(r->direction == _CAPTURE_TX) s->tx++;
+        else s->rx++;
+
+        // Point to Point transactions
+        if(r->client == CAPTURE_NO_CLIENT) continue;
+
+        if(r->direction == _CAPTURE_TX){
+            uchar dev = id & (MAX_DEVICES - 1);
+            chunk->devices[dev].requests++;
+            if(pending.valid) chunk->devices[pending.device].timeouts++;
+            pending.valid = true;
+            pending.timestamp = ts;
+            pending.client = r->client;
+            pending.device = dev;
+            chunk->hasRequest = true;
+        }else if(pending.valid){
+            if(r->client != pending.client) continue;
+            recordRtt(&chunk->devices[pending.device], ts - pending.timestamp);
+            pending.valid = false;
+        }else if((!chunk->hasRequest) && (!chunk->leading.valid)){
+            // The request is in a previous chunk
+            chunk->leading.valid = true;
+            chunk->leading.timestamp = ts;
+            chunk->leading.client = r->client;
+            chunk->leading.device = 0;
+        }
+    }
+
+    chunk->last = prev;
+    chunk->trailing = pending;
+}
+
+/**
+ * @brief This function merges the partial statistics of a chunk in the result
+ *
+ * The chunks shall be merged in timestamp order.
+ *
+ * @param dst: the result
+ * @param src: the chunk to be merged
+ * @param pending: the request not yet answered at the end of the result
+ */
+void captureAnalyzer::mergeChunk(chunkResult* dst, chunkResult* src, p2pEvent* pending){
+    if(!src->count) return;
+
+    // Bus silence across the boundary
+    if(dst->count){
+        qint64 dt = src->first - dst->last;
+        if(dt < 0) dst->disordered++;
+        else{
+            if(dt > dst->maxSilence) dst->maxSilence = dt;
+            if(dt > gapNs) dst->busGaps++;
+        }
+    }else dst->first = src->first;
+
+    if(src->maxSilence > dst->maxSilence) dst->maxSilence = src->maxSilence;
+    dst->busGaps += src->busGaps;
+    dst->disordered += src->disordered;
+    dst->count += src->count;
+    dst->last = src->last;
+
+    // canId statistics: the interval across the boundary is added
+    for(uint i=0; i<MAX_IDS; i++){
+        idStatistics* s = &src->ids[i];
+        idStatistics* d = &dst->ids[i];
+        if(!(s->rx + s->tx)) continue;
+
+        if(d->rx + d->tx) addInterval(d, s->first - d->last, gapNs);
+        else d->first = s->first;
+
+        d->last = s->last;
+        d->rx += s->rx;
+        d->tx += s->tx;
+        d->intervals += s->intervals;
+        d->sum += s->sum;
+        d->sumSq += s->sumSq;
+        d->gaps += s->gaps;
+        if(s->maxInterval > d->maxInterval) d->maxInterval = s->maxInterval;
+    }
+
+    for(uint i=0; i<MAX_DEVICES; i++){
+        dst->devices[i].requests += src->devices[i].requests;
+        dst->devices[i].answers += src->devices[i].answers;
+        dst->devices[i].timeouts += src->devices[i].timeouts;
+        dst->devices[i].rtt.merge(src->devices[i].rtt);
+    }
+
+    // Request pending across the boundary
+    if(pending->valid){
+        if((src->leading.valid) && (src->leading.client == pending->client)){
+            recordRtt(&dst->devices[pending->device], src->leading.timestamp - pending->timestamp);
+            pending->valid = false;
+        }else if(src->hasRequest){
+            dst->devices[pending->device].timeouts++;
+            pending->valid = false;
+        }
+    }
+    if(src->hasRequest) *pending = src->trailing;
+}
+
+/**
+ * @brief This function processes the capture
+ *
+ * @param threads: max number of worker threads (0 = all the cores)
+ */
+void captureAnalyzer::run(uint threads){
+    QElapsedTimer timer;
+    timer.start();
+
+    if(threads) QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    // Splits the files in chunks: a chunk never crosses a file boundary
+    QList<chunkResult*> chunks;
+    for(int i=0; i<files.size(); i++){
+        for(quint64 offset = 0; offset < files[i].count; offset += CHUNK_RECORDS){
+            chunkResult* chunk = new chunkResult;
+            clearResult(chunk);
+            chunk->records = files[i].records + offset;
+            chunk->count = files[i].count - offset;
+            if(chunk->count > CHUNK_RECORDS) chunk->count = CHUNK_RECORDS;
+            chunk->gapNs = gapNs;
+            chunks.append(chunk);
+        }
+    }
+
+    QtConcurrent::blockingMap(chunks, [](chunkResult* chunk){ processChunk(chunk); });
+
+    clearResult(result);
+    p2pEvent pending;
+    pending.valid = false;
+    for(int i=0; i<chunks.size(); i++){
+        mergeChunk(result, chunks[i], &pending);
+        delete chunks[i];
+    }
+
+    elapsed = timer.elapsed();
+}
+
+/**
+ * @brief This function writes the CSV summaries
+ *
+ * @param dir: the output directory
+ * @return true in case of success; see getError() otherwise
+ */
+bool captureAnalyzer::writeCsv(const QString& dir){
+    QDir().mkpath(dir);
+
+    QFile idFile(QDir(dir).filePath("ids.csv"));
+    if(!idFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)){
+        error = QString("unable to create %1").arg(idFile.fileName());
+        return false;
+    }
+
+    QTextStream ids(&idFile);
+    ids << "id,rx,tx,fps,mean_us,jitter_us,max_us,gaps\n";
+    for(uint i=0; i<MAX_IDS; i++){
+        idStatistics* s = &result->ids[i];
+        quint64 frames = s->rx + s->tx;
+        if(!frames) continue;
+
+        double span = (s->last - s->first) / 1e9;
+        double fps = (span > 0) ? (frames - 1) / span : 0;
+        double mean = (s->intervals) ? s->sum / s->intervals : 0;
+        double var = (s->intervals) ? s->sumSq / s->intervals - mean * mean : 0;
+        double jitter = (var > 0) ? sqrt(var) : 0;
+
+        ids << QString("0x%1,%2,%3,%4,%5,%6,%7,%8\n").arg(i, 3, 16, QChar('0')).arg(s->rx).arg(s->tx)
+               .arg(fps, 0, 'f', 2).arg(mean, 0, 'f', 1).arg(jitter, 0, 'f', 1).arg(s->maxInterval / 1000).arg(s->gaps);
+    }
+    idFile.close();
+
+    QFile devFile(QDir(dir).filePath("devices.csv"));
+    if(!devFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)){
+        error = QString("unable to create %1").arg(devFile.fileName());
+        return false;
+    }
+
+    QTextStream devs(&devFile);
+    devs << "device,requests,answers,timeouts,rtt_min_us,rtt_avg_us,rtt_p50_us,rtt_p90_us,rtt_p99_us,rtt_max_us\n";
+    for(uint i=0; i<MAX_DEVICES; i++){
+        deviceStatistics* d = &result->devices[i];
+        if(!d->requests) continue;
+
+        devs << QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,%10\n").arg(i).arg(d->requests).arg(d->answers).arg(d->timeouts)
+                .arg(d->rtt.getMin()).arg(d->rtt.getAvg()).arg(d->rtt.getPercentile(50))
+                .arg(d->rtt.getPercentile(90)).arg(d->rtt.getPercentile(99)).arg(d->rtt.getMax());
+    }
+    devFile.close();
+    return true;
+}
+
+/**
+ * @brief This function prints the capture summary
+ */
+void captureAnalyzer::printSummary(void){
+    quint64 requests = 0, answers = 0, timeouts = 0;
+    for(uint i=0; i<MAX_DEVICES; i++){
+        requests += result->devices[i].requests;
+        answers += result->devices[i].answers;
+        timeouts += result->devices[i].timeouts;
+    }
+
+    double mbytes = (double) records * sizeof(captureRecord) / 1048576.0;
+    printf("FILES: %d\n", (int) files.size());
+    printf("RECORDS: %llu (%.1f MB)\n", (unsigned long long) records, mbytes);
+    printf("DURATION: %.3f s\n", (result->last - result->first) / 1e9);
+    printf("BUS GAPS: %llu, MAX SILENCE: %lld us\n", (unsigned long long) result->busGaps, (long long) (result->maxSilence / 1000));
+    printf("DISORDERED RECORDS: %llu\n", (unsigned long long) result->disordered);
+    printf("P2P REQUESTS: %llu, ANSWERS: %llu, TIMEOUTS: %llu\n", (unsigned long long) requests, (unsigned long long) answers, (unsigned long long) timeouts);
+    printf("PROCESSED IN %lld ms (%.0f MB/s, %d threads)\n", (long long) elapsed,
+           (elapsed) ? mbytes * 1000.0 / elapsed : 0.0, QThreadPool::globalInstance()->maxThreadCount());
+}
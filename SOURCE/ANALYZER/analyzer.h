@@ -0,0 +1,144 @@
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+/*!
+ * \defgroup  analyzerModule Capture Analyzer Module.
+ *
+ * This Module implements the offline analysis of the capture files
+ * (see the @ref captureModule).
+ *
+ * # ANALYSIS
+ *
+ * The analyzer computes:
+ * - for every canId: received and sent frames, rate, inter-arrival time (mean, jitter, max)
+ *   and the number of gaps (inter-arrival time greater than the gap threshold);
+ * - for every device (Device ID = request canId & 0x3F): Point to Point requests,
+ *   answers, timeouts and the RTT distribution;
+ * - for the whole bus: the number of gaps and the longest silence;
+ *
+ * A Point to Point request is a sent frame with a valid client field:
+ * - the RTT is the time between the request and the next answer of the same Client;
+ * - a request followed by another request before any answer is a timeout
+ *   (the device didn't answer or the driver sent the request again).
+ *
+ * # PARALLEL PROCESSING
+ *
+ * The capture files are memory mapped and split in chunks of captureAnalyzer::CHUNK_RECORDS records.
+ * The chunks are processed in parallel with QtConcurrent, every chunk producing
+ * independent partial statistics (captureAnalyzer::chunkResult).
+ *
+ * The partial statistics are then merged in timestamp order: the intervals and the
+ * pending Point to Point requests crossing the chunk boundaries are completed in the merge,
+ * so that the result doesn't depend on the number of chunks.
+ *
+ * # CSV OUTPUT
+ *
+ * - ids.csv: id,rx,tx,fps,mean_us,jitter_us,max_us,gaps
+ * - devices.csv: device,requests,answers,timeouts,rtt_min_us,rtt_avg_us,rtt_p50_us,rtt_p90_us,rtt_p99_us,rtt_max_us
+ *
+ */
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QFile>
+#include "capturefile.h"
+#include "latency.h"
+
+/**
+ * @brief This class implements the capture analyzer
+ *
+ * \ingroup analyzerModule
+ */
+class captureAnalyzer
+{
+public:
+
+    captureAnalyzer();
+    ~captureAnalyzer();
+
+    static const quint64 CHUNK_RECORDS = 1 << 22;   //!< Max records of a processing chunk (96MB)
+    static const uint MAX_IDS = 2048;               //!< Number of standard canId
+    static const uint MAX_DEVICES = 64;             //!< Max number of remote devices (Device ID = canId & 0x3F)
+    static const uint DEFAULT_GAP = 100;            //!< Default gap threshold (ms)
+
+    /// This is the statistics of a canId
+    typedef struct{
+        quint64 rx;             //!< Received frames
+        quint64 tx;             //!< Sent frames
+        qint64  first;          //!< Timestamp of the first frame (ns)
+        qint64  last;           //!< Timestamp of the last frame (ns)
+        quint64 intervals;      //!< Measured inter-arrival intervals
+        double  sum;            //!< Sum of the intervals (us)
+        double  sumSq;          //!< Sum of the squared intervals (us^2)
+        qint64  maxInterval;    //!< Max interval (ns)
+        quint64 gaps;           //!< Intervals greater than the gap threshold
+    }idStatistics;
+
+    /// This is the Point to Point statistics of a device
+    typedef struct{
+        quint64 requests;       //!< Requests sent (retries included)
+        quint64 answers;        //!< Answers received
+        quint64 timeouts;       //!< Requests not answered
+        latencyHistogram rtt;   //!< RTT distribution (us)
+    }deviceStatistics;
+
+    /// This is a Point to Point frame at the chunk boundaries
+    typedef struct{
+        bool    valid;
+        qint64  timestamp;      //!< Frame timestamp (ns)
+        quint16 client;         //!< Client of the transaction
+        uchar   device;         //!< Device of the request
+    }p2pEvent;
+
+    /// This is the partial result of a chunk
+    typedef struct{
+        const captureRecord* records;   //!< First record of the chunk
+        quint64         count;          //!< Records of the chunk
+        qint64          gapNs;          //!< Gap threshold (ns)
+
+        qint64          first;          //!< Timestamp of the first record
+        qint64          last;           //!< Timestamp of the last record
+        quint64         busGaps;        //!< Bus silences greater than the gap threshold
+        qint64          maxSilence;     //!< Longest bus silence (ns)
+        quint64         disordered;     //!< Records with a timestamp lower than the previous one
+
+        bool            hasRequest;     //!< At least a request is present in the chunk
+        p2pEvent        leading;        //!< Answer received before the first request of the chunk
+        p2pEvent        trailing;       //!< Request not answered at the end of the chunk
+
+        idStatistics    ids[MAX_IDS];
+        deviceStatistics devices[MAX_DEVICES];
+    }chunkResult;
+
+    bool open(const QStringList& files); //!< Maps the capture files
+    void run(uint threads); //!< Processes the capture
+    bool writeCsv(const QString& dir); //!< Writes the CSV summaries
+    void printSummary(void); //!< Prints the capture summary
+
+    inline void setGap(uint ms){gapNs = (qint64) ms * 1000000;}
+    inline const QString& getError(void){return error;}
+
+private:
+
+    /// This is a mapped capture file
+    typedef struct{
+        QFile*                  file;
+        const captureFileHeader* header;
+        const captureRecord*    records;
+        quint64                 count;
+    }mappedFile;
+
+    QList<mappedFile>   files;      //!< Files sorted by index
+    QString             error;      //!< Description of the last error
+    qint64              gapNs;      //!< Gap threshold (ns)
+    quint64             records;    //!< Total records
+    chunkResult*        result;     //!< Merged result
+    qint64              elapsed;    //!< Processing time (ms)
+
+    static void processChunk(chunkResult* chunk); //!< Computes the partial statistics of a chunk
+    static void clearResult(chunkResult* res);
+    void mergeChunk(chunkResult* dst, chunkResult* src, p2pEvent* pending); //!< Merges a chunk in the result
+};
+
+#endif // ANALYZER_H
@@ -0,0 +1,276 @@
+#include "benchmark.h"
+#include "capturereader.h"
+#include "bulktransfer.h"
+#include "busload.h"
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <cstdio>
+
+static const uint BENCH_SEEKS = 1000;      //!< Random seeks with the index
+static const uint BENCH_SCAN_SEEKS = 20;   //!< Random seeks with the linear scan
+
+/**
+ * @brief This function returns the least frequent canId of a file
+ *
+ * @param reader: the capture reader
+ * @return the canId
+ */
+static quint16 rarestId(const captureReader& reader){
+    static quint64 counts[2048];
+    for(uint i=0; i<2048; i++) counts[i] = 0;
+    for(quint64 i=0; i<reader.getCount(); i++) counts[reader.getRecord(i)->id & 0x7FF]++;
+
+    quint16 id = 0;
+    quint64 min = 0;
+    for(uint i=0; i<2048; i++){
+        if(!counts[i]) continue;
+        if((!min) || (counts[i] < min)){
+            min = counts[i];
+            id = i;
+        }
+    }
+    return id;
+}
+
+/**
+ * @brief This function runs the index benchmark on the capture files
+ *
+ * @param files: the capture files
+ */
+void runIndexBenchmark(const QStringList& files){
+    QRandomGenerator rng(1);
+    QElapsedTimer timer;
+
+    printf("%-40s %10s %8s %6s %12s %12s %6s %8s %12s %12s\n", "FILE", "RECORDS", "MB", "INDEX",
+           "SEEK_IDX_us", "SEEK_SCAN_us", "ID", "FRAMES", "ID_IDX_us", "ID_SCAN_us");
+
+    for(int f=0; f<files.size(); f++){
+        captureReader reader;
+        if(!reader.open(files[f])){
+            printf("%-40s NOT A VALID CAPTURE FILE\n", qPrintable(files[f]));
+            continue;
+        }
+        if(!reader.getCount()) continue;
+
+        qint64 first = reader.getRecord(0)->timestamp;
+        qint64 span = reader.getRecord(reader.getCount() - 1)->timestamp - first + 1;
+        volatile quint64 sink = 0;
+
+        // Seek with the index
+        timer.start();
+        for(uint i=0; i<BENCH_SEEKS; i++) sink += reader.seek(first + (qint64) (rng.generate64() % span));
+        double seekIndex = timer.nsecsElapsed() / 1000.0 / BENCH_SEEKS;
+
+        // Seek with the linear scan
+        timer.start();
+        for(uint i=0; i<BENCH_SCAN_SEEKS; i++){
+            qint64 t = first + (qint64) (rng.generate64() % span);
+            quint64 pos = 0;
+            while((pos < reader.getCount()) && (reader.getRecord(pos)->timestamp < t)) pos++;
+            sink += pos;
+        }
+        double seekScan = timer.nsecsElapsed() / 1000.0 / BENCH_SCAN_SEEKS;
+
+        // canId query with the index
+        quint16 id = rarestId(reader);
+        quint64 frames = 0;
+        timer.start();
+        for(quint64 pos = 0; reader.findNext(id, &pos); pos++) frames++;
+        double idIndex = timer.nsecsElapsed() / 1000.0;
+
+        // canId query with the linear scan
+        timer.start();
+        for(quint64 pos = 0; pos < reader.getCount(); pos++){
+            if(reader.getRecord(pos)->id == id) sink += pos;
+        }
+        double idScan = timer.nsecsElapsed() / 1000.0;
+
+        printf("%-40s %10llu %8.1f %6s %12.2f %12.1f  0x%03X %8llu %12.1f %12.1f\n", qPrintable(files[f]),
+               (unsigned long long) reader.getCount(), reader.getCount() * sizeof(captureRecord) / 1048576.0,
+               reader.isIndexFile() ? "FILE" : "BUILT", seekIndex, seekScan, id, (unsigned long long) frames, idIndex, idScan);
+    }
+}
+
+static const uint BENCH_SLOT_US = 1000;     //!< Scheduling slot of the driver (us)
+static const uint BENCH_BITRATE = 1000000;  //!< Simulated bus bitrate (bit/s)
+static const uint BENCH_CLIENT_RTT = 200;   //!< Round trip of the simulated Client of the per-frame approach (us)
+static const uint BENCH_P2P_TMO = 10;       //!< Point to Point timeout of the driver (ms, canDriver::P2P_MIN_TMO)
+
+static quint64 simSlot = 0;                 //!< Current slot of the simulation
+
+/**
+ * @brief Simulated clock (ms) driving the timeouts of both approaches
+ */
+static qint64 simClock(void){
+    return (qint64) (simSlot * BENCH_SLOT_US / 1000);
+}
+
+/**
+ * @brief This function simulates the per-frame download
+ *
+ * Every segment is a D request of the simulated Client:
+ * - the driver sends the request in the first slot after its arrival;
+ * - the device answers in the same slot, the driver reads the answer at the next slot;
+ * - the next request reaches the driver BENCH_CLIENT_RTT us after the answer;
+ * - a lost answer is detected by the driver after BENCH_P2P_TMO ms
+ *   and the request is sent again at the next slot.
+ *
+ * @param segments: the number of segments
+ * @param loss: the probability of a lost answer
+ * @param rng: the random generator of the losses
+ * @param retries: the number of requests sent again
+ * @return the download time (ms)
+ */
+static double perFrameTime(uint segments, double loss, QRandomGenerator* rng, uint* retries){
+    qint64 arrival = 0;     // Arrival time of the next request at the driver (us)
+    qint64 txTime = 0;      // Transmission of the pending request (ms)
+    bool waiting = false;
+    bool answered = false;
+    uint done = 0;
+
+    simSlot = 0;
+    *retries = 0;
+    while(done < segments){
+        simSlot++;
+        qint64 t = (qint64) simSlot * BENCH_SLOT_US;
+
+        if(waiting){
+            if(answered){
+                done++;
+                waiting = false;
+                arrival = t + BENCH_CLIENT_RTT;
+            }else if(simClock() - txTime >= BENCH_P2P_TMO){
+                waiting = false;
+                arrival = t + 1;
+                (*retries)++;
+            }
+            continue;
+        }
+
+        if(arrival <= t){
+            waiting = true;
+            txTime = simClock();
+            answered = (rng->generateDouble() >= loss);
+        }
+    }
+
+    return (double) simSlot * BENCH_SLOT_US / 1000.0;
+}
+
+/**
+ * @brief This function runs a Bulk transfer job on the simulated bus
+ *
+ * The engine runs with the simulated clock (see bulkTransfer::setClock()),
+ * so its acknowledge timeout and the go-back-N retransmissions are exercised:
+ * - the device acknowledges every ackEvery segments and the last segment,
+ *   and it repeats the cumulative acknowledge when it receives a segment out of sequence;
+ * - the acknowledge is read by the driver at the next slot, unless it is lost;
+ * - the frames of a slot are limited by MAX_FRAMES_PER_SLOT and by the bus time of the slot.
+ *
+ * @param job: the job descriptor
+ * @param block: the data block
+ * @param loss: the probability of a lost acknowledge
+ * @param rng: the random generator of the losses
+ * @param cpuNs: the CPU time of the engine (ns)
+ * @param retransmissions: the segments sent again
+ * @return the download time (ms), or a negative value if the job failed
+ */
+static double bulkTime(const bulkTransfer::jobDescriptor& job, const QByteArray& block, double loss, QRandomGenerator* rng, qint64* cpuNs, uint* retransmissions){
+    uchar segment[8];
+    uchar segData[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    uchar ack[2] = {job.ackCode, 0};
+    uint segBits = busLoad::frameBits(job.reqCanId, segData, job.segSize + 1);
+    uint ackBits = busLoad::frameBits(job.ackCanId, ack, 2);
+    uint slotBits = (uint) ((quint64) BENCH_BITRATE * BENCH_SLOT_US / 1000000);
+
+    bulkTransfer engine;
+    engine.setClock(simClock);
+    simSlot = 0;
+
+    QElapsedTimer cpu;
+    cpu.start();
+    engine.start(job, block);
+
+    uint received = 0;      // Segments received by the device
+    bool ackPending = false;
+
+    while(engine.isBusy()){
+        simSlot++;
+        uint bits = 0;
+
+        // Acknowledge sent by the device in the previous slot
+        if(ackPending){
+            ackPending = false;
+            bits += ackBits;
+            if(rng->generateDouble() >= loss){
+                ack[1] = (received - 1) & 0xFF;
+                engine.rxFrame(ack, 2);
+                if(!engine.isBusy()) break;
+            }
+        }
+
+        uchar len;
+        for(uint n=0; (n < bulkTransfer::MAX_FRAMES_PER_SLOT) && (bits + segBits <= slotBits); n++){
+            if(!engine.getTxFrame(segment, &len)) break;
+            bits += segBits;
+
+            // The device receives the segments in order (go-back-N)
+            if(segment[0] == (received & 0xFF)){
+                received++;
+                if(((received % job.ackEvery) == 0) || (received == engine.getSegments())) ackPending = true;
+            }else if(received) ackPending = true;
+        }
+    }
+
+    *cpuNs = cpu.nsecsElapsed();
+    *retransmissions = engine.getRetransmissions();
+    if(engine.getResult() != bulkTransfer::_BULK_OK) return -1;
+    return (double) simSlot * BENCH_SLOT_US / 1000.0;
+}
+
+/**
+ * @brief This function runs the Bulk transfer benchmark on the simulated bus
+ */
+void runBulkBenchmark(void){
+    static const uint sizes[] = {1024, 16384, 262144, bulkTransfer::MAX_PAYLOAD};
+    static const uchar windows[] = {8, 32, 127};
+    static const double losses[] = {0, 0.01, 0.05};
+
+    printf("%10s %6s %6s %6s %9s %14s %9s %12s %9s %8s %12s\n", "BYTES", "WINDOW", "ACK", "LOSS%", "SEGMENTS",
+           "PER_FRAME_ms", "P2P_RETRY", "BULK_ms", "BULK_RETX", "SPEEDUP", "CPU_ns/seg");
+
+    for(uint s=0; s<sizeof(sizes)/sizeof(sizes[0]); s++){
+        QByteArray block(sizes[s], 0x55);
+        for(uint l=0; l<sizeof(losses)/sizeof(losses[0]); l++){
+
+            // The same seed for every run: the results are reproducible
+            QRandomGenerator rng(1);
+            uint segments = (sizes[s] + 6) / 7;
+            uint retries = 0;
+            double frame = perFrameTime(segments, losses[l], &rng, &retries);
+
+            for(uint w=0; w<sizeof(windows)/sizeof(windows[0]); w++){
+                bulkTransfer::jobDescriptor job;
+                job.reqCanId = 0x600;
+                job.ackCanId = 0x580;
+                job.segSize = 7;
+                job.window = windows[w];
+                job.ackEvery = (windows[w] > 8) ? 8 : windows[w];
+                job.ackCode = 0x30;
+
+                qint64 cpuNs = 0;
+                uint retransmissions = 0;
+                rng.seed(1);
+                double bulk = bulkTime(job, block, losses[l], &rng, &cpuNs, &retransmissions);
+
+                if(bulk < 0){
+                    printf("%10u %6u %6u %6.1f %9u %14.1f %9u %12s %9u\n", sizes[s], (uint) job.window, (uint) job.ackEvery,
+                           losses[l] * 100, segments, frame, retries, "FAILED", retransmissions);
+                    continue;
+                }
+                printf("%10u %6u %6u %6.1f %9u %14.1f %9u %12.1f %9u %8.1f %12.1f\n", sizes[s], (uint) job.window, (uint) job.ackEvery,
+                       losses[l] * 100, segments, frame, retries, bulk, retransmissions, frame / bulk, (double) cpuNs / segments);
+            }
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+/*!
+ * \addtogroup  analyzerModule
+ *
+ * # INDEX BENCHMARK
+ *
+ * With the -bench option, the analyzer measures for every capture file
+ * the query time with the sidecar index (see captureReader) and with a linear scan:
+ * - seek: the first record at or after a random timestamp (average of BENCH_SEEKS queries);
+ * - id query: all the records of the least frequent canId of the file;
+ *
+ * The results are printed in a table, one line per file, so that the query
+ * times can be compared against the file size.
+ *
+ * # BULK TRANSFER BENCHMARK
+ *
+ * With the -bulkbench option, the analyzer compares the download time of a data block
+ * with the Bulk transfer job (see the @ref bulkModule) and with one D request per segment.
+ * Both approaches are simulated slot by slot on a 1 Mbit/s bus, with the same simulated
+ * clock of the 1 ms scheduling slot, and with the same rate of lost device frames (LOSS%):
+ * - per-frame: every segment waits the device answer (read at the next slot)
+ *   and the round trip of the simulated Client (BENCH_CLIENT_RTT us) before the next
+ *   request can be scheduled; a lost answer is sent again after the driver timeout;
+ * - bulk: the bulkTransfer engine runs with the simulated clock against a simulated device
+ *   acknowledging every ackEvery segments; a lost acknowledge exercises the acknowledge
+ *   timeout and the go-back-N retransmissions of the engine. The frames of a slot are limited
+ *   by MAX_FRAMES_PER_SLOT and by the bus time of the slot (segments and acknowledges).
+ *
+ * The table reports, for every block size, loss rate and window, the simulated download times,
+ * the requests and segments sent again, the speedup and the CPU time of the engine per segment.
+ * The losses use a fixed seed: the results are reproducible.
+ */
+
+#include <QStringList>
+
+void runIndexBenchmark(const QStringList& files); //!< Runs the index benchmark on the capture files
+void runBulkBenchmark(void); //!< Runs the Bulk transfer benchmark on the simulated bus
+
+#endif // BENCHMARK_H
@@ -0,0 +1,175 @@
+#include "converter.h"
+#include "capturereader.h"
+#include "capturewriter.h"
+#include <QDateTime>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * @brief This function converts capture files in a text trace
+ *
+ * The files shall belong to the same capture and they shall be sorted by index.
+ *
+ * @param files: the capture files
+ * @param format: the text format
+ * @param out: the output file
+ * @param error: the error description
+ * @return true in case of success
+ */
+bool converter::exportCapture(const QStringList& files, logFormat::_Format format, const QString& out, QString* error){
+    FILE* fp = fopen(out.toLocal8Bit().constData(), "wb");
+    if(!fp){
+        *error = QString("unable to create %1").arg(out);
+        return false;
+    }
+
+    char* buffer = new char[IO_BUFFER];
+    int len = 0;
+    bool header = false;
+    captureReader reader;
+
+    for(int f=0; f<files.size(); f++){
+        if(!reader.open(files[f])){
+            *error = QString("%1 is not a valid capture file").arg(files[f]);
+            delete[] buffer;
+            fclose(fp);
+            return false;
+        }
+
+        qint64 startNs = reader.getHeader()->startTime * 1000000;
+        if((format == logFormat::_FORMAT_ASC) && (!header)){
+            len += logFormat::formatAscHeader(buffer + len, reader.getHeader()->startTime);
+            header = true;
+        }
+
+        for(quint64 i=0; i<reader.getCount(); i++){
+            const captureRecord* rec = reader.getRecord(i);
+            if(format == logFormat::_FORMAT_CANDUMP) len += logFormat::formatCandump(buffer + len, startNs + rec->timestamp, "can0", rec);
+            else len += logFormat::formatAsc(buffer + len, rec->timestamp, rec);
+
+            if(len > IO_BUFFER - logFormat::MAX_HEADER){
+                fwrite(buffer, 1, len, fp);
+                len = 0;
+            }
+        }
+    }
+
+    if(format == logFormat::_FORMAT_ASC) len += logFormat::formatAscFooter(buffer + len);
+    fwrite(buffer, 1, len, fp);
+
+    bool ok = (ferror(fp) == 0);
+    if(!ok) *error = QString("write error on %1").arg(out);
+    fclose(fp);
+    delete[] buffer;
+    return ok;
+}
+
+/**
+ * @brief This function converts a text trace in a capture file
+ *
+ * - candump: the capture start is the time of the first frame;
+ * - ASC: the capture start is the date of the header (0 if not present);
+ *
+ * The lines not representing a valid frame are skipped.
+ *
+ * @param in: the text trace
+ * @param format: the text format
+ * @param out: the capture file (the index file is written with it)
+ * @param error: the error description
+ * @return true in case of success
+ */
+bool converter::importCapture(const QString& in, logFormat::_Format format, const QString& out, QString* error){
+    FILE* fp = fopen(in.toLocal8Bit().constData(), "rb");
+    if(!fp){
+        *error = QString("unable to open %1").arg(in);
+        return false;
+    }
+
+    captureWriter writer;
+    bool opened = false;
+    qint64 startNs = 0;
+    qint64 startMs = 0;
+    quint64 skipped = 0;
+
+    char* buffer = new char[IO_BUFFER];
+    int len = 0;
+    bool eof = false;
+
+    while(!eof){
+        int n = (int) fread(buffer + len, 1, IO_BUFFER - len, fp);
+        if(n <= 0) eof = true;
+        len += (n > 0) ? n : 0;
+
+        // Parses the complete lines (the last line at the end of file)
+        char* line = buffer;
+        char* end = buffer + len;
+        for(;;){
+            char* nl = (char*) memchr(line, '\n', end - line);
+            if(!nl){
+                if((!eof) || (line >= end)) break;
+                nl = end;
+            }
+
+            char* lineEnd = nl;
+            if((lineEnd > line) && (lineEnd[-1] == '\r')) lineEnd--;
+
+            captureRecord rec;
+            qint64 ns;
+            bool valid;
+            if(format == logFormat::_FORMAT_CANDUMP) valid = logFormat::parseCandump(line, lineEnd, &ns, &rec);
+            else{
+                valid = logFormat::parseAsc(line, lineEnd, &ns, &rec);
+                if((!valid) && (!opened) && (lineEnd - line > 5) && (!strncmp(line, "date ", 5))){
+                    QDateTime date = QDateTime::fromString(QString::fromLatin1(line + 5, lineEnd - line - 5), "ddd MMM dd hh:mm:ss.zzz ap yyyy");
+                    if(date.isValid()) startMs = date.toMSecsSinceEpoch();
+                }
+            }
+
+            if(valid){
+                if(!opened){
+                    if(format == logFormat::_FORMAT_CANDUMP){
+                        startMs = ns / 1000000;
+                        startNs = startMs * 1000000;
+                    }
+                    if(!writer.open(out, startMs, 0)){
+                        *error = QString("unable to create %1").arg(out);
+                        delete[] buffer;
+                        fclose(fp);
+                        return false;
+                    }
+                    opened = true;
+                }
+                rec.timestamp = ns - startNs;
+                writer.write(&rec);
+            }else skipped++;
+
+            line = nl + 1;
+            if(line > end) line = end;
+        }
+
+        // Moves the partial line at the buffer start
+        len = (int) (end - line);
+        if(len >= IO_BUFFER){
+            // A line longer than the buffer is discarded
+            len = 0;
+            skipped++;
+        }
+        memmove(buffer, line, len);
+    }
+
+    fclose(fp);
+    delete[] buffer;
+
+    if(!opened){
+        *error = QString("no valid frame in %1").arg(in);
+        return false;
+    }
+
+    if(!writer.close()){
+        *error = QString("write error on %1").arg(out);
+        return false;
+    }
+
+    printf("IMPORTED %llu FRAMES, %llu LINES SKIPPED\n", (unsigned long long) writer.getRecords(), (unsigned long long) skipped);
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef CONVERTER_H
+#define CONVERTER_H
+
+/*!
+ * \addtogroup  analyzerModule
+ *
+ * # FORMAT CONVERSION
+ *
+ * The analyzer converts the captures from/to the standard text formats (see logFormat):
+ * - -export candump|asc out: the capture files are written in a single text file;
+ * - -import candump|asc out.cap: a text trace is written in a capture file and its index;
+ *
+ * The conversion is streamed with converter::IO_BUFFER bytes buffers:
+ * the lines are formatted and parsed in place, without memory allocation.
+ */
+
+#include <QString>
+#include <QStringList>
+#include "logformat.h"
+
+/**
+ * @brief This namespace implements the capture format conversion
+ *
+ * \ingroup analyzerModule
+ */
+namespace converter {
+    static const int IO_BUFFER = 1 << 20; //!< Size of the I/O buffers
+
+    bool exportCapture(const QStringList& files, logFormat::_Format format, const QString& out, QString* error); //!< Converts capture files in a text trace
+    bool importCapture(const QString& in, logFormat::_Format format, const QString& out, QString* error); //!< Converts a text trace in a capture file
+}
+
+#endif // CONVERTER_H
@@ -0,0 +1,128 @@
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QDir>
+#include <cstdio>
+#include "analyzer.h"
+#include "benchmark.h"
+#include "converter.h"
+
+/**
+ * @brief This function expands a command line file argument
+ *
+ * - a directory is expanded with all its capture files;
+ * - a name with wildcards is expanded with the matching files;
+ *
+ * @param arg: the command line argument
+ * @return the list of files
+ */
+static QStringList expandArgument(const QString& arg){
+    QFileInfo info(arg);
+    if(info.isDir()){
+        QDir dir(arg);
+        QStringList list;
+        QStringList names = dir.entryList(QStringList(QString("*%1").arg(CAPTURE_EXTENSION)), QDir::Files, QDir::Name);
+        for(int i=0; i<names.size(); i++) list.append(dir.filePath(names[i]));
+        return list;
+    }
+
+    if((!arg.contains('*')) && (!arg.contains('?'))) return QStringList(arg);
+
+    QDir dir = info.dir();
+    QStringList list;
+    QStringList names = dir.entryList(QStringList(info.fileName()), QDir::Files, QDir::Name);
+    for(int i=0; i<names.size(); i++) list.append(dir.filePath(names[i]));
+    return list;
+}
+
+/**
+ * @brief Capture analyzer entry point
+ *
+ * Usage: can_analyzer [-o outdir] [-gap ms] [-j threads] [-bench] [-bulkbench] [-export candump|asc out] [-import candump|asc out.cap] files..
+ *
+ * - -o: directory of the CSV summaries (no CSV output if not present);
+ * - -gap: gap threshold in ms (default captureAnalyzer::DEFAULT_GAP);
+ * - -j: max number of worker threads (default: all the cores);
+ * - -bench: runs the index benchmark instead of the analysis;
+ * - -bulkbench: runs the Bulk transfer benchmark on the simulated bus (no files);
+ * - -export: converts the capture files in a candump or ASC trace instead of the analysis;
+ * - -import: converts a candump or ASC trace (the first file argument) in a capture file;
+ * - files: the capture files, a capture directory or a wildcard name (basename_*.cap);
+ *
+ * \ingroup analyzerModule
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList args = a.arguments();
+
+    QString outDir;
+    uint gap = captureAnalyzer::DEFAULT_GAP;
+    uint threads = 0;
+    bool bench = false;
+    bool bulkBench = false;
+    QString exportFile, importFile;
+    logFormat::_Format exportFormat = logFormat::_FORMAT_CANDUMP;
+    logFormat::_Format importFormat = logFormat::_FORMAT_CANDUMP;
+    QStringList files;
+
+    for(int i=1; i<args.size(); i++){
+        if((args[i] == "-o") && (i + 1 < args.size())) outDir = args[++i];
+        else if((args[i] == "-gap") && (i + 1 < args.size())) gap = args[++i].toUInt();
+        else if((args[i] == "-j") && (i + 1 < args.size())) threads = args[++i].toUInt();
+        else if(args[i] == "-bench") bench = true;
+        else if(args[i] == "-bulkbench") bulkBench = true;
+        else if((args[i] == "-export") && (i + 2 < args.size()) && (logFormat::getFormat(args[i + 1], &exportFormat))){
+            exportFile = args[i + 2];
+            i += 2;
+        }else if((args[i] == "-import") && (i + 2 < args.size()) && (logFormat::getFormat(args[i + 1], &importFormat))){
+            importFile = args[i + 2];
+            i += 2;
+        }
+        else files.append(expandArgument(args[i]));
+    }
+
+    if(bulkBench){
+        runBulkBenchmark();
+        return 0;
+    }
+
+    if(files.isEmpty()){
+        printf("usage: can_analyzer [-o outdir] [-gap ms] [-j threads] [-bench] [-bulkbench] [-export candump|asc out] [-import candump|asc out.cap] files..\n");
+        return 1;
+    }
+
+    QString error;
+    if(!importFile.isEmpty()){
+        if(converter::importCapture(files.at(0), importFormat, importFile, &error)) return 0;
+        printf("ERROR: %s\n", qPrintable(error));
+        return 1;
+    }
+
+    if(!exportFile.isEmpty()){
+        if(converter::exportCapture(files, exportFormat, exportFile, &error)) return 0;
+        printf("ERROR: %s\n", qPrintable(error));
+        return 1;
+    }
+
+    if(bench){
+        runIndexBenchmark(files);
+        return 0;
+    }
+
+    captureAnalyzer analyzer;
+    analyzer.setGap(gap);
+    if(!analyzer.open(files)){
+        printf("ERROR: %s\n", qPrintable(analyzer.getError()));
+        return 1;
+    }
+
+    analyzer.run(threads);
+    analyzer.printSummary();
+
+    if((!outDir.isEmpty()) && (!analyzer.writeCsv(outDir))){
+        printf("ERROR: %s\n", qPrintable(analyzer.getError()));
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include "bulktransfer.h"
+
+/**
+ * @brief bulkTransfer class constructor
+ */
+bulkTransfer::bulkTransfer(){
+    busy = false;
+    result = _BULK_OK;
+    nSegments = 0;
+    baseSeg = 0;
+    nextSeg = 0;
+    nRetransmissions = 0;
+    retry = 0;
+    ackPending = false;
+    ackTime = 0;
+    progressTime = 0;
+    startTime = 0;
+    clock = nullptr;
+    monotonic.start();
+    desc.reqCanId = 0;
+    desc.ackCanId = 0;
+    desc.segSize = 7;
+    desc.window = 1;
+    desc.ackEvery = 1;
+    desc.ackCode = 0;
+}
+
+/**
+ * @brief This function verifies the job descriptor parameters
+ *
+ * @param job: the job descriptor
+ * @return true if the parameters are valid
+ */
+bool bulkTransfer::isValid(const jobDescriptor& job){
+    if((job.segSize == 0) || (job.segSize > 7)) return false;
+    if((job.window == 0) || (job.window > 127)) return false;
+    if((job.ackEvery == 0) || (job.ackEvery > job.window)) return false;
+    if(job.reqCanId == job.ackCanId) return false;
+    return true;
+}
+
+/**
+ * @brief This function starts a new job
+ *
+ * @param job: this is the job descriptor
+ * @param block: this is the data block to be downloaded
+ */
+void bulkTransfer::start(const jobDescriptor& job, const QByteArray& block){
+    desc = job;
+    txData = block;
+    baseSeg = 0;
+    nextSeg = 0;
+    nRetransmissions = 0;
+    retry = 0;
+    ackPending = false;
+    result = _BULK_OK;
+    busy = true;
+    startTime = now();
+    progressTime = startTime;
+    ackTime = startTime;
+
+    if((!isValid(desc)) || (txData.size() == 0) || ((uint) txData.size() > MAX_PAYLOAD)){
+        nSegments = 0;
+        terminate(_BULK_INVALID);
+        return;
+    }
+
+    nSegments = (txData.size() + desc.segSize - 1) / desc.segSize;
+}
+
+/**
+ * @brief This function terminates the current job
+ */
+void bulkTransfer::abort(void){
+    busy = false;
+}
+
+void bulkTransfer::terminate(_Result res){
+    result = res;
+    busy = false;
+}
+
+/**
+ * @brief This function returns true if the device acknowledges a segment
+ *
+ * The device acknowledges every ackEvery segments and the last segment.
+ *
+ * @param seg: the segment number
+ */
+bool bulkTransfer::isAckSegment(uint seg){
+    return (((seg + 1) % desc.ackEvery) == 0) || (seg + 1 == nSegments);
+}
+
+/**
+ * @brief This function updates the acknowledge timeout after an acknowledge
+ *
+ * The timeout runs only while a segment acknowledged by the device
+ * (see isAckSegment()) has been sent and not yet acknowledged.
+ */
+void bulkTransfer::updateAckPending(void){
+    uint seg = ((baseSeg / desc.ackEvery) + 1) * desc.ackEvery - 1;
+    if(seg >= nSegments) seg = nSegments - 1;
+    ackPending = (baseSeg < nextSeg) && (seg < nextSeg);
+    if(ackPending) ackTime = now();
+}
+
+uint bulkTransfer::ackBytes(void){
+    uint bytes = baseSeg * desc.segSize;
+    if(bytes > (uint) txData.size()) bytes = txData.size();
+    return bytes;
+}
+
+/**
+ * @brief This function returns true when a progress notification shall be sent.
+ *
+ * @return true every PROGRESS_PERIOD ms
+ */
+bool bulkTransfer::isProgressTime(void){
+    qint64 t = now();
+    if(t - progressTime < PROGRESS_PERIOD) return false;
+    progressTime = t;
+    return true;
+}
+
+/**
+ * @brief This function returns the next segment to be sent on the bus.
+ *
+ * The canDriver calls this function every scheduling slot, until
+ * the function returns false.
+ *
+ * The function verifies also the acknowledge timeout:
+ * in case of timeout the not acknowledged segments are sent again.
+ * The timeout is measured from the transmission of the first segment
+ * the device shall acknowledge (every ackEvery segments), so that the
+ * segments of an incomplete acknowledge group never time out.
+ *
+ * @param data: pointer to the 8 bytes frame to be filled
+ * @param len: pointer to the frame length
+ * @return true if a frame shall be sent
+ */
+bool bulkTransfer::getTxFrame(uchar* data, uchar* len){
+    if(!busy) return false;
+
+    // Acknowledge timeout: go back to the first segment not acknowledged
+    if((ackPending) && (now() - ackTime > ACK_TMO)){
+        retry++;
+        if(retry > MAX_RETRY){
+            terminate(_BULK_TIMEOUT);
+            return false;
+        }
+        nRetransmissions += nextSeg - baseSeg;
+        nextSeg = baseSeg;
+        ackPending = false;
+    }
+
+    // Window full or all the segments sent
+    if(nextSeg >= nSegments) return false;
+    if(nextSeg - baseSeg >= desc.window) return false;
+
+    uint index = nextSeg * desc.segSize;
+    uchar size = desc.segSize;
+    if(index + size > (uint) txData.size()) size = txData.size() - index;
+
+    for(int i=0; i<8; i++) data[i] = 0;
+    data[0] = nextSeg & 0xFF;
+    for(uchar i=0; i<size; i++) data[1+i] = txData.at(index + i);
+    *len = size + 1;
+
+    if((!ackPending) && (isAckSegment(nextSeg))){
+        ackPending = true;
+        ackTime = now();
+    }
+    nextSeg++;
+    return true;
+}
+
+/**
+ * @brief This function handles a frame received from the device
+ *
+ * The frame shall be already filtered by the canDriver
+ * with the job acknowledge canId.
+ *
+ * @param data: this is the frame content
+ * @param len: this is the frame length
+ */
+void bulkTransfer::rxFrame(const uchar* data, uchar len){
+    if(!busy) return;
+    if(!len) return;
+
+    if(data[0] != desc.ackCode){
+        terminate(_BULK_REJECTED);
+        return;
+    }
+    if(len < 2) return;
+
+    // Finds the acknowledged segment inside the sent segments window
+    for(uint seg = baseSeg; seg < nextSeg; seg++){
+        if((seg & 0xFF) != data[1]) continue;
+
+        baseSeg = seg + 1;
+        retry = 0;
+        updateAckPending();
+        break;
+    }
+
+    if(baseSeg >= nSegments) terminate(_BULK_OK);
+}
@@ -0,0 +1,136 @@
+#ifndef BULKTRANSFER_H
+#define BULKTRANSFER_H
+
+/*!
+ * \defgroup  bulkModule Bulk Transfer Module.
+ *
+ * This Module implements the segmented download of a large data block
+ * (firmware, parameter tables) to a remote device.
+ *
+ * # PROTOCOL OVERVIEW
+ *
+ * The Client submits the whole data block with a job descriptor (see bulkTransfer::jobDescriptor):
+ * - reqCanId: the canId of the segment frames sent to the device;
+ * - ackCanId: the canId of the acknowledge frames sent by the device;
+ * - segSize: the number of data bytes in every segment (1 to 7);
+ * - window: the max number of segments sent and not yet acknowledged (1 to 127);
+ * - ackEvery: the device acknowledges every ackEvery segments (and the last one);
+ * - ackCode: the first byte of a valid acknowledge frame;
+ *
+ * The segment frame format is:
+ * - Byte 0: segment sequence number (modulo 256);
+ * - Byte 1 to segSize: segment data;
+ *
+ * The acknowledge frame format is:
+ * - Byte 0: ackCode;
+ * - Byte 1: sequence number of the last segment received (cumulative acknowledge);
+ *
+ * Any frame received with the ackCanId and a Byte 0 different from the ackCode
+ * is handled as a device rejection and the job terminates in error.
+ *
+ * The segments are sent with a sliding window. The acknowledge timeout starts
+ * when the first segment the device shall acknowledge (every ackEvery segments and the last one)
+ * is sent: if no acknowledge is received in bulkTransfer::ACK_TMO ms, the segments are sent again
+ * starting from the first not acknowledged segment (go-back-N),
+ * up to bulkTransfer::MAX_RETRY times.
+ *
+ * # PERFORMANCES
+ *
+ * With the per-frame approach, every segment costs a Client round trip
+ * and a scheduling slot (at least 1ms per segment).
+ *
+ * With the bulk transfer job, the driver sends up to bulkTransfer::MAX_FRAMES_PER_SLOT
+ * segments every scheduling slot, limited only by the window and the device acknowledge rate.
+ * The job reports the elapsed time at the completion so that the
+ * two approaches can be compared on the field.
+ *
+ * The timings of the job (acknowledge timeout, progress period, elapsed time) are measured
+ * with the monotonic clock; a simulation can replace it with bulkTransfer::setClock()
+ * (see the Bulk transfer benchmark of the analyzer).
+ *
+ */
+
+#include <QByteArray>
+#include <QElapsedTimer>
+
+/**
+ * @brief This class implements a single bulk transfer job
+ *
+ * \ingroup bulkModule
+ */
+class bulkTransfer
+{
+public:
+
+    bulkTransfer();
+
+    static const uint  MAX_PAYLOAD = 1048576;   //!< Max accepted data block length
+    static const uint  ACK_TMO = 50;            //!< Max time in ms waiting for an acknowledge
+    static const uchar MAX_RETRY = 3;           //!< Max number of consecutive retransmissions
+    static const uchar MAX_FRAMES_PER_SLOT = 8; //!< Max number of frames sent in a single scheduling slot
+    static const uint  PROGRESS_PERIOD = 100;   //!< Period in ms of the progress notifications
+
+    /// This is the job descriptor
+    typedef struct{
+        uint16_t reqCanId;  //!< canId of the segment frames
+        uint16_t ackCanId;  //!< canId of the device acknowledge frames
+        uchar    segSize;   //!< Data bytes per segment (1 to 7)
+        uchar    window;    //!< Max number of segments not yet acknowledged (1 to 127)
+        uchar    ackEvery;  //!< The device acknowledges every ackEvery segments
+        uchar    ackCode;   //!< First byte of a valid acknowledge frame
+    }jobDescriptor;
+
+    /// This enumeration defines the job result
+    typedef enum{
+        _BULK_OK = 0,       //!< The data block has been completelly acknowledged
+        _BULK_TIMEOUT,      //!< No acknowledge after MAX_RETRY retransmissions
+        _BULK_REJECTED,     //!< The device rejected the data block
+        _BULK_INVALID       //!< Invalid job descriptor or data block
+    }_Result;
+
+    typedef qint64 (*clockFunction)(void); //!< Time source (ms)
+
+    static bool isValid(const jobDescriptor& job); //!< Verifies the job descriptor parameters
+
+    inline void setClock(clockFunction function){clock = function;} //!< Replaces the monotonic clock (nullptr: monotonic clock)
+
+    void start(const jobDescriptor& job, const QByteArray& block); //!< Starts a new job
+    void abort(void); //!< Terminates the current job
+    bool getTxFrame(uchar* data, uchar* len); //!< Returns the next segment to be sent on the bus
+    void rxFrame(const uchar* data, uchar len); //!< Handles an acknowledge frame received from the device
+    bool isProgressTime(void); //!< Returns true when a progress notification shall be sent
+
+    inline bool isBusy(void){return busy;}
+    inline _Result getResult(void){return result;}
+    inline uint getAckBytes(void){return ackBytes();}
+    inline uint getTotalBytes(void){return (uint) txData.size();}
+    inline uint getSegments(void){return nSegments;}
+    inline uint getRetransmissions(void){return nRetransmissions;}
+    inline qint64 getElapsed(void){return now() - startTime;}
+
+private:
+    jobDescriptor   desc;
+    QByteArray      txData;         //!< Data block
+    bool            busy;
+    _Result         result;
+    uint            nSegments;      //!< Total number of segments
+    uint            baseSeg;        //!< First segment not yet acknowledged
+    uint            nextSeg;        //!< Next segment to be sent
+    uint            nRetransmissions; //!< Number of retransmitted segments
+    uchar           retry;          //!< Consecutive retransmissions without progress
+    bool            ackPending;     //!< A segment to be acknowledged by the device has been sent (ackTime valid)
+    qint64          ackTime;        //!< Start of the acknowledge timeout (ms)
+    qint64          progressTime;   //!< Last progress notification (ms)
+    qint64          startTime;      //!< Job start (ms)
+    clockFunction   clock;          //!< Time source, nullptr for the monotonic clock
+    QElapsedTimer   monotonic;      //!< Monotonic clock
+
+    inline qint64 now(void){return (clock) ? clock() : monotonic.elapsed();}
+
+    uint ackBytes(void);
+    bool isAckSegment(uint seg); //!< Returns true if the device acknowledges the segment
+    void updateAckPending(void); //!< Updates the acknowledge timeout after an acknowledge
+    void terminate(_Result res);
+};
+
+#endif // BULKTRANSFER_H
@@ -0,0 +1,124 @@
+#include "busload.h"
+
+/**
+ * @brief busLoad class constructor
+ */
+busLoad::busLoad(){
+    bitrate = 1000000;
+    for(uint i=0; i<NUM_BUCKETS; i++){
+        bits[i] = 0;
+        bucketId[i] = -1;
+    }
+    clock.start();
+}
+
+/**
+ * @brief This function sets the bus bitrate
+ *
+ * @param bps: the bitrate in bit/s
+ */
+void busLoad::setBitrate(uint bps){
+    if(bps) bitrate = bps;
+}
+
+/**
+ * @brief This function returns the length in bits of a standard data frame on the bus
+ *
+ * The stuffed region (SOF to CRC15) is built bit by bit:
+ * the CRC15 is calculated on the fly and the stuff bits are counted.
+ *
+ * @param canId: the 11 bit identifier
+ * @param data: the frame content
+ * @param dlc: the frame length (0 to 8)
+ * @return the frame length in bits, including the Intermission
+ */
+uint busLoad::frameBits(ushort canId, const uchar* data, uchar dlc){
+    uchar stream[19 + 64 + 15];
+    uint  n = 0;
+    if(dlc > 8) dlc = 8;
+
+    // SOF, Identifier, RTR, IDE, r0, DLC and Data fields
+    stream[n++] = 0;
+    for(int i=10; i>=0; i--) stream[n++] = (canId >> i) & 1;
+    stream[n++] = 0;
+    stream[n++] = 0;
+    stream[n++] = 0;
+    for(int i=3; i>=0; i--) stream[n++] = (dlc >> i) & 1;
+    for(uchar b=0; b<dlc; b++){
+        for(int i=7; i>=0; i--) stream[n++] = (data[b] >> i) & 1;
+    }
+
+    // CRC15 (polynomial 0x4599)
+    ushort crc = 0;
+    for(uint i=0; i<n; i++){
+        uchar crcnxt = stream[i] ^ ((crc >> 14) & 1);
+        crc = (crc << 1) & 0x7FFF;
+        if(crcnxt) crc ^= 0x4599;
+    }
+    for(int i=14; i>=0; i--) stream[n++] = (crc >> i) & 1;
+
+    // Stuff bits: a complementary bit after 5 consecutive bits of the same value
+    uint stuff = 0;
+    uint run = 1;
+    uchar last = stream[0];
+    for(uint i=1; i<n; i++){
+        if(stream[i] == last){
+            run++;
+            if(run == 5){
+                stuff++;
+                last = !last; // The stuff bit starts a new run
+                run = 1;
+            }
+        }else{
+            last = stream[i];
+            run = 1;
+        }
+    }
+
+    // CRC delimiter, ACK slot, ACK delimiter, EOF and Intermission
+    return n + stuff + 13;
+}
+
+/**
+ * @brief This function accounts a frame transmitted or received on the bus
+ *
+ * @param canId: the 11 bit identifier
+ * @param data: the frame content
+ * @param dlc: the frame length
+ */
+void busLoad::addFrame(ushort canId, const uchar* data, uchar dlc){
+    qint64 id = clock.elapsed() / BUCKET_MS;
+    uint slot = id % NUM_BUCKETS;
+
+    if(bucketId[slot] != id){
+        bucketId[slot] = id;
+        bits[slot] = 0;
+    }
+    bits[slot] += frameBits(canId, data, dlc);
+}
+
+/**
+ * @brief This function returns the bus load of a time window
+ *
+ * Only the completed buckets are accounted: the window ends with
+ * the last completed bucket.
+ *
+ * @param windowMs: the window width in ms (BUCKET_MS to NUM_BUCKETS * BUCKET_MS)
+ * @return the bus load percentage
+ */
+double busLoad::getLoad(uint windowMs){
+    uint nbuckets = windowMs / BUCKET_MS;
+    if(nbuckets == 0) nbuckets = 1;
+    if(nbuckets >= NUM_BUCKETS) nbuckets = NUM_BUCKETS - 1;
+
+    qint64 current = clock.elapsed() / BUCKET_MS;
+    quint64 total = 0;
+    for(uint i=1; i<=nbuckets; i++){
+        qint64 id = current - i;
+        if(id < 0) break;
+        uint slot = id % NUM_BUCKETS;
+        if(bucketId[slot] == id) total += bits[slot];
+    }
+
+    return (100.0 * total * 1000) / ((double) bitrate * nbuckets * BUCKET_MS);
+}
@@ -0,0 +1,60 @@
+#ifndef BUSLOAD_H
+#define BUSLOAD_H
+
+/*!
+ * \defgroup  busloadModule Bus Load Estimator Module.
+ *
+ * This Module estimates the real-time load of the CAN bus.
+ *
+ * # FRAME LENGTH
+ *
+ * Every frame transmitted or received by the driver is measured in bits
+ * on the bus, for the standard 11 bit data frame format:
+ * - SOF, Identifier, RTR, IDE, r0, DLC, Data and CRC15 fields are subject to bit stuffing:
+ *   the actual CRC15 is calculated and a stuff bit is counted after
+ *   every 5 consecutive bits of the same value;
+ * - CRC delimiter, ACK slot, ACK delimiter, End Of Frame and Intermission (13 bits)
+ *   are not subject to bit stuffing;
+ *
+ * # SLIDING WINDOWS
+ *
+ * The bits are accumulated in busLoad::BUCKET_MS ms buckets (see busLoad::NUM_BUCKETS), covering the last
+ * 10 s plus the bucket under measurement.
+ *
+ * The load of a window is the ratio between the bits measured in the
+ * completed buckets of the window and the bits the bus can transfer
+ * in the same time with the configured bitrate.
+ *
+ */
+
+#include <QElapsedTimer>
+
+/**
+ * @brief This class implements the bus load estimator
+ *
+ * \ingroup busloadModule
+ */
+class busLoad
+{
+public:
+
+    busLoad();
+
+    static const uint BUCKET_MS = 10;       //!< Time width of a bucket in ms
+    static const uint NUM_BUCKETS = 1001;   //!< Number of buckets (10 s plus the current bucket)
+
+    void setBitrate(uint bps); //!< Sets the bus bitrate
+    void addFrame(ushort canId, const uchar* data, uchar dlc); //!< Accounts a frame on the bus
+    double getLoad(uint windowMs); //!< Returns the bus load percentage of a time window
+    static uint frameBits(ushort canId, const uchar* data, uchar dlc); //!< Returns the length in bits of a frame on the bus
+
+    inline uint getBitrate(void){return bitrate;}
+
+private:
+    uint            bitrate;                //!< Bus bitrate (bit/s)
+    QElapsedTimer   clock;                  //!< Time base of the buckets
+    uint            bits[NUM_BUCKETS];      //!< Bits measured in every bucket
+    qint64          bucketId[NUM_BUCKETS];  //!< Bucket number assigned to every bucket slot
+};
+
+#endif // BUSLOAD_H
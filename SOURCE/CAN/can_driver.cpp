@@ -1,5 +1,6 @@
 #include "application.h"
-#include <QApplication>
+#include <QCoreApplication>
+#include <cstring>
 
 /**
  * @brief canDriver class constructor
@@ -10,6 +11,120 @@ canDriver::canDriver(){
     connect(&canTimer, SIGNAL(timeout()), this, SLOT(canTimerEvent()), Qt::UniqueConnection);
     for(int i=0; i<8; i++)    rxCanData.append((uchar) 0);
     handle = 0;
+    p2p_tmo = 0;
+    p2p_rxCanId = 0;
+    p2p_clientId = 0;
+    job_type = _TX_P2P_FRAME;
+    job_rxCanId = 0;
+    job_txCanId = 0;
+    jobSlots = 0;
+    jobTxCount = 0;
+    p2p_attempt = 0;
+    p2p_txTime = 0;
+    selfReception = false;
+    busFlags = 0;
+    replay = nullptr;
+    opener = nullptr;
+    openResult = false;
+    openLoopback = false;
+    openBR = _CAN_1000K;
+    openTime = -1;
+    openRetryDelay = OPEN_RETRY_MIN_MS;
+    openFailures = 0;
+    openRetryTimer.setSingleShot(true);
+    connect(&openRetryTimer, SIGNAL(timeout()), this, SLOT(openRetryHandler()));
+    driverClock.start();
+    resetDeviceStatistics();
+    resetCounters();
+}
+
+/**
+ * @brief This function clears the statistics of all the remote devices
+ */
+void canDriver::resetDeviceStatistics(void){
+    for(int i=0; i<MAX_DEVICES; i++){
+        devStats[i].requests = 0;
+        devStats[i].timeouts = 0;
+        devStats[i].retries = 0;
+        devStats[i].recovered = 0;
+        devStats[i].failures = 0;
+        devStats[i].lateReplies = 0;
+        devStats[i].srtt = 0;
+        devStats[i].rttvar = 0;
+        devStats[i].tmo = P2P_MIN_TMO;
+    }
+}
+
+/**
+ * @brief This function clears the diagnostic counters
+ */
+void canDriver::resetCounters(void){
+    counters.rxFrames.reset();
+    counters.txFrames.reset();
+    counters.rxFps.reset();
+    counters.txFps.reset();
+    counters.p2pRequests.reset();
+    counters.p2pAnswers.reset();
+    counters.p2pTimeouts.reset();
+    counters.lateAnswers.reset();
+    counters.asyncFrames.reset();
+    counters.busErrors.reset();
+    counters.errPassive.reset();
+    counters.errWarning.reset();
+    counters.overruns.reset();
+    counters.ticks.reset();
+    counters.jitterSum.reset();
+    counters.jitterMax.reset();
+    lastTick = 0;
+    fpsTime = driverClock.elapsed();
+    fpsRx = 0;
+    fpsTx = 0;
+    flagsTime = fpsTime;
+}
+
+/**
+ * @brief This function updates the tick statistics
+ *
+ * The function is called at the beginning of every scheduling tick:
+ * - the tick jitter is the difference between the measured tick period and TICK_PERIOD;
+ * - the frame rates are updated every second;
+ * - the controller error flags are polled every FLAGS_PERIOD ms:
+ *   a condition is counted when its flag is set.
+ */
+void canDriver::tickStatistics(void){
+    qint64 now = driverClock.nsecsElapsed();
+    if(lastTick){
+        qint64 jitter = (now - lastTick) / 1000 - TICK_PERIOD;
+        if(jitter < 0) jitter = -jitter;
+        counters.jitterSum.inc(jitter);
+        counters.jitterMax.max(jitter);
+    }
+    lastTick = now;
+    counters.ticks.inc();
+
+    qint64 ms = now / 1000000;
+    if(ms - fpsTime >= 1000){
+        quint64 rx = counters.rxFrames.get();
+        quint64 tx = counters.txFrames.get();
+        counters.rxFps.set(((rx - fpsRx) * 1000) / (ms - fpsTime));
+        counters.txFps.set(((tx - fpsTx) * 1000) / (ms - fpsTime));
+        fpsRx = rx;
+        fpsTx = tx;
+        fpsTime = ms;
+    }
+
+    if(ms - flagsTime >= FLAGS_PERIOD){
+        flagsTime = ms;
+        DWORD flags = 0;
+        if(!busGetFlags(&flags)) return;
+
+        DWORD set = flags & ~busFlags;
+        busFlags = flags;
+        if(set & VSCAN_IOCTL_FLAG_BUS_ERROR) counters.busErrors.inc();
+        if(set & VSCAN_IOCTL_FLAG_ERR_PASSIVE) counters.errPassive.inc();
+        if(set & VSCAN_IOCTL_FLAG_ERR_WARNING) counters.errWarning.inc();
+        if(set & (VSCAN_IOCTL_FLAG_DATA_OVERRUN | VSCAN_IOCTL_FLAG_RX_FIFO_FULL)) counters.overruns.inc();
+    }
 }
 
 /**
@@ -32,6 +147,139 @@ canDriver::canDriver(){
  * @return true in case of activation success
  */
 bool canDriver::driverOpen(_CanBR BR, bool loopback){
+    if(opener) return false;
+    if(!deviceSetup(BR, loopback)) return false;
+    startScheduling(BR, loopback);
+    return true;
+}
+
+/**
+ * @brief This function opens the device driver in a background thread
+ *
+ * The device open (see driverOpen()) can take seconds with the open retries:
+ * the Server and the Interface can listen in the meantime.
+ * Until the device is ready canDriver::isDeviceOpen() returns false
+ * and the Client requests are queued by the Server.
+ *
+ * When the device is ready the scheduling starts in the driver thread
+ * and the open time, retries included, is available with getOpenTime().
+ * A failed attempt is retried with an exponential backoff (see openCompletedHandler()).
+ *
+ * @param BR: this is the baudarate of the CAN communication;
+ * @param loopback: this activated the loopback mode if true.
+ * @return true if the open has been started
+ */
+bool canDriver::driverOpenAsync(_CanBR BR, bool loopback){
+    if((opener) || (deviceOpen)) return false;
+
+    openRetryTimer.stop();
+    openBR = BR;
+    openLoopback = loopback;
+    openTime = -1;
+    openRetryDelay = OPEN_RETRY_MIN_MS;
+    openFailures = 0;
+    openTimer.start();
+
+    startOpener();
+    return true;
+}
+
+/**
+ * @brief This function starts the background open thread
+ */
+void canDriver::startOpener(void){
+    openResult = false;
+    opener = QThread::create([this](){ openResult = deviceSetup(openBR, openLoopback); });
+    connect(opener, SIGNAL(finished()), this, SLOT(openCompletedHandler()), Qt::QueuedConnection);
+    opener->start();
+}
+
+/**
+ * @brief This function completes the background device open
+ *
+ * The function is called in the driver thread when the open thread terminates.
+ *
+ * In case of failure the device handle is released and a new attempt
+ * is scheduled after openRetryDelay: the delay is doubled at every failure,
+ * up to OPEN_RETRY_MAX_MS.
+ */
+void canDriver::openCompletedHandler(void){
+    if(!opener) return;
+    opener->wait();
+    opener->deleteLater();
+    opener = nullptr;
+
+    if(!openResult){
+#ifndef NO_VSCAN
+        if(handle > 0) VSCAN_Close(handle);
+#endif
+        handle = 0;
+        openFailures++;
+        LOG_ERROR("CAN DRIVER: DEVICE OPEN FAILED (ATTEMPT %u), RETRY IN %u ms", openFailures, openRetryDelay);
+        openRetryTimer.start(openRetryDelay);
+        openRetryDelay = (openRetryDelay * 2 > OPEN_RETRY_MAX_MS) ? OPEN_RETRY_MAX_MS : openRetryDelay * 2;
+        return;
+    }
+
+    openTime = openTimer.elapsed();
+    startScheduling(openBR, openLoopback);
+    LOG_INFO("CAN DRIVER: DEVICE READY IN %lld ms", (long long) openTime);
+}
+
+/**
+ * @brief This function starts a new background open attempt after a failure
+ */
+void canDriver::openRetryHandler(void){
+    if((opener) || (deviceOpen)) return;
+    startOpener();
+}
+
+/**
+ * @brief This function starts the scheduling of an open device
+ *
+ * @param BR: this is the baudarate of the CAN communication;
+ * @param loopback: the loopback mode is active.
+ */
+void canDriver::startScheduling(_CanBR BR, bool loopback){
+    busload.setBitrate(bitrateOf(BR));
+    selfReception = loopback;
+
+    // Start the Can Tx/Rx every 1ms
+    canTimer.stop();
+    rxEvent = false;
+    canTimer.start(1);
+
+    deviceOpen = true;
+}
+
+/**
+ * @brief This function returns the bitrate of a baudrate code
+ *
+ * @param BR: the baudrate code
+ * @return the bitrate (bit/s)
+ */
+uint canDriver::bitrateOf(_CanBR BR){
+    static const uint bitrates[] = {1000000, 800000, 500000, 250000, 125000, 100000, 50000, 20000};
+    return bitrates[BR];
+}
+
+/**
+ * @brief This function opens and configures the device
+ *
+ * The function only accesses the device handle and the device descriptors:
+ * it can be executed in the background open thread.
+ *
+ * @param BR: this is the baudarate of the CAN communication;
+ * @param loopback: this activated the loopback mode if true.
+ * @return true in case of success
+ */
+bool canDriver::deviceSetup(_CanBR BR, bool loopback){
+#ifdef NO_VSCAN
+    Q_UNUSED(BR);
+    Q_UNUSED(loopback);
+    qDebug() << "CAN DRIVER: VSCAN NOT AVAILABLE IN THIS BUILD, USE THE -replay OPTION";
+    return false;
+#else
     VSCAN_STATUS status;
     char string[33];
 
@@ -145,6 +393,35 @@ bool canDriver::driverOpen(_CanBR BR, bool loopback){
     //VSCAN_Ioctl(NULL, VSCAN_IOCTL_SET_DEBUG_MODE, VSCAN_DEBUG_MODE_CONSOLE);
     //VSCAN_Ioctl(NULL, VSCAN_IOCTL_SET_DEBUG, VSCAN_DEBUG_HIGH);
     qDebug() << "VSCAN DRIVER READY";
+    return true;
+#endif
+}
+
+/**
+ * @brief This function opens the simulated CAN backend replaying a capture
+ *
+ * The VSCAN device is not opened: the driver reads the frames
+ * injected by the replay engine (see the @ref replayModule).
+ *
+ * @param BR: this is the baudarate of the simulated bus (bus load estimation);
+ * @param capture: a capture file, a capture basename or a capture directory;
+ * @param speed: the replay speed factor (1 = original timing);
+ * @return true if the capture has been found
+ */
+bool canDriver::replayOpen(_CanBR BR, const QString& capture, double speed){
+    if(!replay){
+        replay = new canReplay();
+        connect(replay, SIGNAL(replayCompleted()), this, SLOT(replayCompletedHandler()), Qt::QueuedConnection);
+    }
+
+    if(!replay->start(capture, speed)){
+        qDebug() << "CAN DRIVER: REPLAY CAPTURE NOT FOUND: " << capture;
+        return false;
+    }
+
+    qDebug() << "CAN DRIVER: REPLAY MODE, CAPTURE:" << capture << " SPEED:" << replay->getSpeed();
+    busload.setBitrate(bitrateOf(BR));
+    selfReception = false;
 
     // Start the Can Tx/Rx every 1ms
     canTimer.stop();
@@ -153,7 +430,10 @@ bool canDriver::driverOpen(_CanBR BR, bool loopback){
 
     deviceOpen = true;
     return true;
+}
 
+void canDriver::replayCompletedHandler(void){
+    qDebug() << "CAN DRIVER: REPLAY COMPLETED: " << replay->getReport();
 }
 
 /**
@@ -163,6 +443,21 @@ bool canDriver::driverOpen(_CanBR BR, bool loopback){
  */
 void canDriver::driverClose(void){
 
+    // Pending background open: waits for its completion
+    openRetryTimer.stop();
+    if(opener){
+        disconnect(opener, SIGNAL(finished()), this, SLOT(openCompletedHandler()));
+        opener->wait();
+        delete opener;
+        opener = nullptr;
+    }
+
+    if(replay){
+        canTimer.stop();
+        replay->stop();
+        return;
+    }
+
     if(handle <= 0) return;
 
     // Termines the timer callback
@@ -170,13 +465,15 @@ void canDriver::driverClose(void){
     rxEvent = false;
 
     // Close the device driver
+#ifndef NO_VSCAN
     VSCAN_STATUS status = VSCAN_Close(handle);
     if(status != VSCAN_ERR_OK){
         char string[33];
         VSCAN_GetErrorString(status, string, 32);
-        qDebug() << string;
+        LOG_ERROR("%s", string);
         return ;
     }
+#endif
 
     return;
 }
@@ -210,8 +507,12 @@ void canDriver::canSendFrame(void){
     }
 
 
-    if(VSCAN_Write(handle, &msg, 1, &written) != VSCAN_ERR_OK) return;
-    VSCAN_Flush(handle);
+    if(!busWrite(&msg, 1, &written)) return;
+    counters.txFrames.inc();
+    TRACE->recordFrame(flightRecorder::_FR_TX_FRAME, msg.Id, msg.Data, msg.Size);
+    CAPTURE->record(_CAPTURE_TX, msg.Id, msg.Flags, msg.Data, msg.Size, p2p_clientId);
+    taps.frame(canTap::_TAP_TX, msg.Id, msg.Flags, msg.Data, msg.Size);
+    if(!selfReception) busload.addFrame(msg.Id, msg.Data, msg.Size);
 
     return;
 }
@@ -225,83 +526,482 @@ void canDriver::canSendFrame(void){
  *
  * The received can frames then will be forwarded \n
  * to the can frame consumers in the application \n
- * emitting the canDriver::receivedCanFrame() signal.
+ * and offered to the subscribed taps (see the @ref cantapModule).
  *
  * @param ev: QTimer::QTimerEvent parameter type;
  */
 void canDriver::canTimerEvent(void)
 {   
-    static uint8_t rxTmo = 0;
-    static ushort  p2p_rxCanId = 0;
-    static ushort  p2p_clientId = 0;
-
+    tickStatistics();
 
     // Read anyway in order to discard unexpected messages
     rxmsg = 0;
-    VSCAN_Read(handle, rxmsgs, VSCAN_NUM_MESSAGES, &rxmsg);
+    busRead();
+    TRACE->record(flightRecorder::_FR_TICK, 0, 0, rxmsg);
     if(rxmsg){
-        rxTmo = 10;
+        counters.rxFrames.inc(rxmsg);
 
         for(uint i=0; i < (uint) rxmsg; i++){
             rxCanId = rxmsgs[i].Id;
             for(int j=0; j < 8; j++) rxCanData[j] = rxmsgs[i].Data[j];
-            emit receivedCanFrame(rxCanId, rxCanData); // Only for debug
+            busload.addFrame(rxmsgs[i].Id, rxmsgs[i].Data, rxmsgs[i].Size);
+            TRACE->recordFrame(flightRecorder::_FR_RX_FRAME, rxmsgs[i].Id, rxmsgs[i].Data, rxmsgs[i].Size);
+            bool jobFrame = (job_type != _TX_P2P_FRAME) && (rxCanId == job_rxCanId);
+            CAPTURE->record(_CAPTURE_RX, rxmsgs[i].Id, rxmsgs[i].Flags, rxmsgs[i].Data, rxmsgs[i].Size, ((!jobFrame) && (p2p_rxCanId) && (rxCanId == p2p_rxCanId)) ? p2p_clientId : CAPTURE_NO_CLIENT);
+            taps.frame(canTap::_TAP_RX, rxmsgs[i].Id, rxmsgs[i].Flags, rxmsgs[i].Data, rxmsgs[i].Size);
+
+            // The frames of the running ISO-TP transaction or Bulk job are handled by the related engine
+            if(jobFrame){
+                if(job_type == _TX_ISOTP_FRAME) isotp.rxFrame(rxmsgs[i].Data, rxmsgs[i].Size);
+                else bulk.rxFrame(rxmsgs[i].Data, rxmsgs[i].Size);
+                continue;
+            }
 
             // If the message is the expected answer to a point to point message
             if(rxCanId == p2p_rxCanId){
-                SERVER->rxCanFrameHandle(p2p_clientId, rxCanId, &rxCanData);
+                counters.p2pAnswers.inc();
+                if(p2p_attempt) devStats[rxCanId & 0x3F].recovered++;
+                updateAnswerTime(rxCanId, driverClock.nsecsElapsed() - p2p_txTime);
+                TRACE->record(flightRecorder::_FR_P2P_COMPLETE, rxCanId, p2p_clientId, (driverClock.nsecsElapsed() - p2p_txTime) / 1000);
+                p2pRequest.tReply = p2pRequest.timer.nsecsElapsed();
+                SERVER->rxCanFrameHandle(&p2pRequest, rxCanId, &rxCanData);
+                qint64 tSocket = p2pRequest.timer.nsecsElapsed();
+                latency.record(rxCanId, p2pRequest.tEnqueue, p2pRequest.tWrite, p2pRequest.tReply, tSocket);
+                SERVER->recordLatency(&p2pRequest, tSocket);
+                if(p2p_attempt) purgeExpired(&p2pRequest, rxCanId);
                 p2p_rxCanId = 0;
-                break;
-            }else SERVER->rxAsyncCanFrameHandle(rxCanId, &rxCanData); // Sends Asynch frames
+                continue; // The rest of the batch is still dispatched
+            }else if(lateReplyHandle(rxCanId, &rxCanData)){
+                counters.lateAnswers.inc();
+            }else{
+                counters.asyncFrames.inc();
+                SERVER->rxAsyncCanFrameHandle(rxCanId, &rxCanData); // Sends Asynch frames
+            }
         }
     }
 
-    // Verify if there is a timeout condition
+    // Verify if there is a timeout condition: the timeout is measured from the request transmission,
+    // the unrelated frames received in the meantime don't extend it
     if(p2p_rxCanId){
-        if(!rxTmo){
-            for(int j=0; j < 8; j++) rxCanData[j] = 0;
-            SERVER->rxCanFrameHandle(p2p_clientId, p2p_rxCanId, &rxCanData);
+        if(driverClock.nsecsElapsed() - p2p_txTime >= p2p_tmo){
+            deviceStatistics* stat = &devStats[p2p_rxCanId & 0x3F];
+            stat->timeouts++;
+            counters.p2pTimeouts.inc();
+            TRACE->record(flightRecorder::_FR_P2P_TIMEOUT, p2p_rxCanId, p2p_clientId, p2p_attempt);
+
+            // Keeps the record of the expired transaction for a late answer
+            p2pExpired expired;
+            expired.request = p2pRequest;
+            expired.rxCanId = p2p_rxCanId;
+            expired.txTime = p2p_txTime;
+            expired.expired = driverClock.elapsed();
+            if(expiredList.size() >= MAX_EXPIRED) expiredList.removeFirst();
+            expiredList.append(expired);
+
+            // A request with an expired deadline is not sent again
+            bool expired_deadline = (p2pRequest.hasDeadline) && (p2pRequest.timer.elapsed() >= p2pRequest.deadline);
+
+            if((p2p_attempt < p2pRequest.retries) && (!expired_deadline)){
+                // The request will be sent again after the backoff time
+                p2pRetry retry;
+                retry.request = p2pRequest;
+                retry.attempt = p2p_attempt + 1;
+                retry.due = driverClock.elapsed() + ((qint64) p2pRequest.backoff << p2p_attempt);
+                retryList.append(retry);
+            }else{
+                stat->failures++;
+                SERVER->rxErrorHandle(&p2pRequest, p2p_rxCanId, getBusErrorReason());
+            }
             p2p_rxCanId = 0;
-        }else rxTmo--;
+        }
         return;
     }
 
+    // The running ISO-TP transaction or Bulk job is served every slot:
+    // every JOB_SLICE slots, or when a CRITICAL request is waiting,
+    // the slot is offered to a Point to Point request of the other Clients
+    int jobCanId = -1;
+    if(job_type != _TX_P2P_FRAME){
+        jobCanId = job_rxCanId;
+        if((jobSlots < JOB_SLICE) && (!SERVER->isCriticalWaiting(jobCanId))){
+            jobSlots++;
+            jobService();
+            return;
+        }
+        jobSlots = 0;
+    }
+
+   // Try to send a new message: the requests to be sent again have the priority,
+   // then find the next client to be served
+   canTxRequest request;
+   uchar attempt = 0;
+   if(!getRetryRequest(&request, &attempt)){
+       if(!SERVER->getNextTxFrame(&request, jobCanId) ){
+           p2p_rxCanId = 0;
+
+           // No request to be interleaved: the slot goes to the running job
+           if(job_type != _TX_P2P_FRAME) jobService();
+           return;
+       }
+   }
 
+   if(request.type == _TX_ISOTP_FRAME){
+       job_type = _TX_ISOTP_FRAME;
+       jobRequest = request;
+       job_rxCanId = request.rxCanId;
+       job_txCanId = request.txCanId;
+       jobSlots = 0;
+       jobTxCount = 0;
+       isotp.start(request.data);
+       isoTpService();
+       return;
+   }
 
-   // Try to send a new message: Find the next client to be served
-   if(!SERVER->getNextTxFrame(&p2p_clientId, &p2p_rxCanId, &txCanId, &txData) ){
-       p2p_rxCanId = 0;
+   if(request.type == _TX_BULK_FRAME){
+       job_type = _TX_BULK_FRAME;
+       jobRequest = request;
+       job_rxCanId = request.job.ackCanId;
+       job_txCanId = request.job.reqCanId;
+       jobSlots = 0;
+       jobTxCount = 0;
+       bulk.start(request.job, request.data);
+       bulkService();
        return;
    }
 
+   p2pRequest = request;
+   p2p_attempt = attempt;
+   p2p_clientId = request.clientId;
+   p2p_rxCanId = request.rxCanId;
+   txCanId = request.txCanId;
+   txData = request.data;
+
+   if(attempt) devStats[p2p_rxCanId & 0x3F].retries++;
+   else devStats[p2p_rxCanId & 0x3F].requests++;
 
    canSendFrame();
-   emit transmittedCanFrame(txCanId, txData);   
-   rxTmo = 10; // 5ms max tmo
+   counters.p2pRequests.inc();
+   TRACE->record(flightRecorder::_FR_P2P_START, txCanId, p2p_clientId, attempt);
+   p2p_txTime = driverClock.nsecsElapsed();
+   p2pRequest.tWrite = p2pRequest.timer.nsecsElapsed();
+   p2p_tmo = (qint64) devStats[p2p_rxCanId & 0x3F].tmo * 1000000; // Adaptive device timeout
+
+}
+
+
+
+/**
+ * @brief This function returns a request whose backoff time is expired
+ *
+ * @param request: pointer to the request to be filled
+ * @param attempt: pointer to the attempt number of the request
+ * @return true if a request shall be sent again
+ */
+bool canDriver::getRetryRequest(canTxRequest* request, uchar* attempt){
+    if(retryList.isEmpty()) return false;
 
+    qint64 now = driverClock.elapsed();
+    for(int i=0; i<retryList.size(); i++){
+        if(retryList[i].due > now) continue;
+
+        // The answer canId is in use by the running job
+        if((job_type != _TX_P2P_FRAME) && (retryList[i].request.rxCanId == job_rxCanId)) continue;
+
+        *request = retryList[i].request;
+        *attempt = retryList[i].attempt;
+        retryList.removeAt(i);
+        return true;
+    }
+
+    return false;
 }
 
+/**
+ * @brief This function delivers a late answer to the requesting Client
+ *
+ * The received frame is compared with the recently expired transactions:
+ * if the frame is the answer of an expired transaction, it is delivered
+ * only to the requesting Client with the Late frame.
+ *
+ * The expired transactions older than LATE_WINDOW ms are discarded.
+ *
+ * @param canId: this is the canId of the received frame
+ * @param data: this is the data content of the frame
+ * @return true if the frame is a late answer
+ */
+bool canDriver::lateReplyHandle(ushort canId, QByteArray* data){
+    if(expiredList.isEmpty()) return false;
+
+    qint64 now = driverClock.elapsed();
+    while((!expiredList.isEmpty()) && (now - expiredList.first().expired > LATE_WINDOW)) expiredList.removeFirst();
+
+    for(int i=0; i<expiredList.size(); i++){
+        if(expiredList[i].rxCanId != canId) continue;
+
+        p2pExpired expired = expiredList[i];
+        expiredList.removeAt(i);
+
+        // The pending new attempt of the same request is not more necessary
+        for(int j=0; j<retryList.size(); j++){
+            const canTxRequest* retry = &retryList[j].request;
+            if((retry->clientId == expired.request.clientId) && (retry->txCanId == expired.request.txCanId) &&
+               (retry->rxCanId == expired.rxCanId) && (retry->seq == expired.request.seq)){
+                retryList.removeAt(j);
+                break;
+            }
+        }
+
+        devStats[canId & 0x3F].lateReplies++;
+        updateAnswerTime(canId, driverClock.nsecsElapsed() - expired.txTime);
+        SERVER->rxLateFrameHandle(&expired.request, canId, data);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief This function removes the expired attempts of an answered request
+ *
+ * When a retried request is answered, the records of its timed out attempts
+ * are not more valid: a following frame with the same canId must not be
+ * delivered as a late answer (and its time must not update the answer time estimation).
+ *
+ * @param request: this is the answered request
+ * @param canId: this is the canId of the answer
+ */
+void canDriver::purgeExpired(const canTxRequest* request, ushort canId){
+    for(int i=expiredList.size()-1; i>=0; i--){
+        const p2pExpired* expired = &expiredList[i];
+        if((expired->rxCanId == canId) && (expired->request.clientId == request->clientId) &&
+           (expired->request.txCanId == request->txCanId) && (expired->request.seq == request->seq)){
+            expiredList.removeAt(i);
+        }
+    }
+}
+
+/**
+ * @brief This function updates the answer time estimation of a device
+ *
+ * The estimation uses the smoothed round trip time and its variance:
+ * - srtt = 7/8 srtt + 1/8 rtt;
+ * - rttvar = 3/4 rttvar + 1/4 |srtt - rtt|;
+ *
+ * The device P2P timeout is set to srtt + 4 * rttvar,
+ * limited between P2P_MIN_TMO and P2P_MAX_TMO.
+ *
+ * @param canId: this is the canId of the device answer
+ * @param rtt: this is the measured answer time (ns)
+ */
+void canDriver::updateAnswerTime(ushort canId, qint64 rtt){
+    deviceStatistics* stat = &devStats[canId & 0x3F];
+    uint sample = (uint) (rtt / 1000);
+
+    if(!stat->srtt){
+        stat->srtt = sample;
+        stat->rttvar = sample / 2;
+    }else{
+        uint delta = (stat->srtt > sample) ? stat->srtt - sample : sample - stat->srtt;
+        stat->rttvar = (3 * stat->rttvar + delta) / 4;
+        stat->srtt = (7 * stat->srtt + sample) / 8;
+    }
+
+    uint tmo = (stat->srtt + 4 * stat->rttvar + 999) / 1000;
+    if(tmo < P2P_MIN_TMO) tmo = P2P_MIN_TMO;
+    if(tmo > P2P_MAX_TMO) tmo = P2P_MAX_TMO;
+    stat->tmo = tmo;
+}
+
+/**
+ * @brief This function discards the pending activities of a disconnected Client
+ *
+ * - the running ISO-TP transaction or Bulk job of the Client is aborted,
+ *   releasing the bus for the other Clients;
+ * - the Client requests waiting for a new attempt are discarded;
+ * - the pending Point to Point request of the Client is not sent again at its timeout.
+ *
+ * @param clientId: this is the identifier of the disconnected Client
+ */
+void canDriver::cancelClient(ushort clientId){
+    if((job_type != _TX_P2P_FRAME) && (jobRequest.clientId == clientId)){
+        LOG_INFO("CAN DRIVER: CLIENT %u DISCONNECTED, JOB TO CANID:0x%x ABORTED", (uint) clientId, (uint) job_txCanId);
+        if(job_type == _TX_ISOTP_FRAME) isotp.abort();
+        else bulk.abort();
+        job_type = _TX_P2P_FRAME;
+        job_rxCanId = 0;
+        jobSlots = 0;
+        jobTxCount = 0;
+    }
+
+    for(int i=retryList.size()-1; i>=0; i--){
+        if(retryList[i].request.clientId == clientId) retryList.removeAt(i);
+    }
 
+    if((p2p_rxCanId) && (p2p_clientId == clientId)) p2pRequest.retries = 0;
+}
+
+/**
+ * @brief This function serves the running ISO-TP transaction or Bulk job
+ */
+void canDriver::jobService(void){
+    if(job_type == _TX_ISOTP_FRAME) isoTpService();
+    else if(job_type == _TX_BULK_FRAME) bulkService();
+}
+
+/**
+ * @brief This function handles the running ISO-TP transaction
+ *
+ * The function is called every scheduling slot assigned to the job:
+ * - sends the frames requested by the ISO-TP engine with a single driver write;
+ * - when the transaction terminates, sends the response to the Client
+ *   and releases the job slot for the next request.
+ *
+ * The device answer canId shall be registered by the Client:
+ * the transaction fails immediatelly if no answer canId is registered.
+ */
+void canDriver::isoTpService(void){
+    if(!job_rxCanId) isotp.abort();
+
+    // Collects the frames to be sent in this slot, after the ones not sent in the previous slot
+    while((jobTxCount < isoTp::MAX_FRAMES_PER_SLOT) && (isotp.getTxFrame(jobTx[jobTxCount].Data))){
+        jobTx[jobTxCount].Flags = VSCAN_FLAGS_STANDARD;
+        jobTx[jobTxCount].Id = job_txCanId;
+        jobTx[jobTxCount].Size = 8;
+        jobTxCount++;
+    }
+
+    jobSend();
+    if(isotp.isBusy()) return;
+
+    if(isotp.isCompleted()){
+        SERVER->rxIsoTpFrameHandle(&jobRequest, job_rxCanId, &isotp.getResponse());
+    }else{
+        _ClientErrorCode reason = _CLIENT_ERR_PROTOCOL;
+        if((isotp.getError() == isoTp::_ISOTP_ERR_TIMEOUT_BS) || (isotp.getError() == isoTp::_ISOTP_ERR_TIMEOUT_CR) || (isotp.getError() == isoTp::_ISOTP_ERR_TIMEOUT_P2)){
+            reason = getBusErrorReason();
+        }
+        SERVER->rxErrorHandle(&jobRequest, job_rxCanId, reason);
+        LOG_WARNING("CAN DRIVER: ISO-TP TRANSACTION TO CANID:0x%x FAILED, ERROR:%d", (uint) job_txCanId, (int) isotp.getError());
+    }
+
+    isotp.abort();
+    job_type = _TX_P2P_FRAME;
+    job_rxCanId = 0;
+    jobTxCount = 0;
+}
+
+/**
+ * @brief This function handles the running Bulk transfer job
+ *
+ * The function is called every scheduling slot assigned to the job:
+ * - sends the segments allowed by the job sliding window with a single driver write;
+ * - notifies the job progress to the Client;
+ * - when the job terminates, notifies the completion to the Client
+ *   and releases the job slot for the next request.
+ */
+void canDriver::bulkService(void){
+
+    // Collects the segments to be sent in this slot, after the ones not sent in the previous slot
+    while((jobTxCount < bulkTransfer::MAX_FRAMES_PER_SLOT) && (bulk.getTxFrame(jobTx[jobTxCount].Data, &jobTx[jobTxCount].Size))){
+        jobTx[jobTxCount].Flags = VSCAN_FLAGS_STANDARD;
+        jobTx[jobTxCount].Id = job_txCanId;
+        jobTxCount++;
+    }
+
+    jobSend();
+
+    if(bulk.isBusy()){
+        if(bulk.isProgressTime()) SERVER->bulkProgressHandle(jobRequest.clientId, job_txCanId, bulk.getAckBytes(), bulk.getTotalBytes());
+        return;
+    }
+
+    SERVER->bulkProgressHandle(jobRequest.clientId, job_txCanId, bulk.getAckBytes(), bulk.getTotalBytes());
+    SERVER->bulkCompletedHandle(jobRequest.clientId, job_txCanId, bulk.getResult(), bulk.getElapsed(), bulk.getSegments(), bulk.getRetransmissions());
+    if(bulk.getResult() != bulkTransfer::_BULK_OK){
+        LOG_WARNING("CAN DRIVER: BULK TRANSFER TO CANID:0x%x FAILED, ERROR:%d", (uint) job_txCanId, (int) bulk.getResult());
+    }
+
+    bulk.abort();
+    job_type = _TX_P2P_FRAME;
+    job_rxCanId = 0;
+    jobTxCount = 0;
+}
+
+/**
+ * @brief This function sends the frames of the running job
+ *
+ * The frames not accepted by the driver are moved at the beginning of jobTx:
+ * they are sent first in the next slot of the job.
+ */
+void canDriver::jobSend(void){
+    uint written = canSendFrames(jobTx, jobTxCount);
+    if(written < jobTxCount) memmove(jobTx, &jobTx[written], (jobTxCount - written) * sizeof(VSCAN_MSG));
+    jobTxCount -= written;
+}
+
+/**
+ * @brief This function sends a set of frames with a single driver write.
+ *
+ * Only the frames accepted by the driver are accounted
+ * (bus load, flight recorder, capture and taps).
+ *
+ * @param msgs: this is the array of the frames to be sent
+ * @param nframes: this is the number of frames
+ * @return the number of frames written (0 in case of write error)
+ */
+uint canDriver::canSendFrames(VSCAN_MSG* msgs, uint nframes){
+    DWORD written = 0;
+    if(!nframes) return 0;
+
+    if(!busWrite(msgs, nframes, &written)) return 0;
+    if(written > nframes) written = nframes;
+    counters.txFrames.inc(written);
+    for(uint i=0; i<(uint) written; i++){
+        if(!selfReception) busload.addFrame(msgs[i].Id, msgs[i].Data, msgs[i].Size);
+        TRACE->recordFrame(flightRecorder::_FR_TX_FRAME, msgs[i].Id, msgs[i].Data, msgs[i].Size);
+        CAPTURE->record(_CAPTURE_TX, msgs[i].Id, msgs[i].Flags, msgs[i].Data, msgs[i].Size, CAPTURE_NO_CLIENT);
+        taps.frame(canTap::_TAP_TX, msgs[i].Id, msgs[i].Flags, msgs[i].Data, msgs[i].Size);
+    }
+    return (uint) written;
+}
+
+/**
+ * @brief This function returns the reason code of a missing device answer.
+ *
+ * The function reads the CAN controller error flags:
+ * - Bus Error: the answer is missing because of the bus error condition;
+ * - Error Passive: the answer is missing because of the controller error condition;
+ * - otherwise the device didn't answer in time.
+ *
+ * @return the reason code to be notified to the Client
+ */
+_ClientErrorCode canDriver::getBusErrorReason(void){
+    DWORD flags = 0;
+
+    if(!busGetFlags(&flags)) return _CLIENT_ERR_TIMEOUT;
+    if(flags & VSCAN_IOCTL_FLAG_BUS_ERROR) return _CLIENT_ERR_BUS_ERROR;
+    if(flags & VSCAN_IOCTL_FLAG_ERR_PASSIVE) return _CLIENT_ERR_PASSIVE;
+    return _CLIENT_ERR_TIMEOUT;
+}
 
 void canDriver::printErrors(void){
     static DWORD flag_back = 0;
-    DWORD flags;
-    QString errstr = "";
+    DWORD flags = 0;
 
-    VSCAN_Ioctl(handle, VSCAN_IOCTL_GET_FLAGS, &flags);
+    busGetFlags(&flags);
     if(flags == flag_back) return;
 
     flag_back = flags;
 
-    if(flags&0x1) errstr += " RX-FIFO-FULL ";
-    if(flags&0x2) errstr += " TX-FIFO-FULL ";
-    if(flags&0x4) errstr += " ERR-WARNING ";
-    if(flags&0x8) errstr += " DATA-OVERRUN ";
-    if(flags&0x10) errstr += " UNUSED ";
-    if(flags&0x20) errstr += " ERR-PASSIVE ";
-    if(flags&0x40) errstr += " ARBIT-LOST ";
-    if(flags&0x80) errstr += " BUS-ERROR ";
-    qDebug() << errstr;
+    LOG_WARNING("%s%s%s%s%s%s%s%s",
+                (flags&0x1) ? " RX-FIFO-FULL " : "",
+                (flags&0x2) ? " TX-FIFO-FULL " : "",
+                (flags&0x4) ? " ERR-WARNING " : "",
+                (flags&0x8) ? " DATA-OVERRUN " : "",
+                (flags&0x10) ? " UNUSED " : "",
+                (flags&0x20) ? " ERR-PASSIVE " : "",
+                (flags&0x40) ? " ARBIT-LOST " : "",
+                (flags&0x80) ? " BUS-ERROR " : "");
     return;
 
 }
@@ -57,19 +57,127 @@
  * - When in loopback mode, the data driver receives also the data sent.
  *
  *
+ * # RETRY POLICY
+ *
+ * A Client can request that a timed out Point to Point request is sent again
+ * by the driver before to notify the timeout (see the Client Option frame in the @ref interfaceModule):
+ * - the request waits the backoff time in a retry list, while the bus serves the other Clients;
+ * - when the backoff time expires, the request is sent again with priority over the new requests;
+ * - the backoff time is doubled at every attempt;
+ * - the timeout is notified to the Client only when all the attempts fail.
+ *
+ * The driver collects the statistics of every remote device (Device ID = canId & 0x3F),
+ * see canDriver::deviceStatistics.
+ *
+ * # LATE ANSWERS AND ADAPTIVE TIMEOUT
+ *
+ * When a Point to Point request times out, the driver keeps a record
+ * of the expired transaction for canDriver::LATE_WINDOW ms:
+ * - if the device answers inside this window, the answer is delivered once,
+ *   only to the requesting Client, with the Late frame (see the @ref interfaceModule);
+ * - the pending new attempt of the same request (see RETRY POLICY) is cancelled;
+ * - the late answer is counted in the device statistics and it is not forwarded as an ASYNC frame.
+ *
+ * The driver estimates the answer time of every device (smoothed round trip time and variance,
+ * updated also with the late answers): the P2P timeout of a device is
+ * srtt + 4 * rttvar, limited between canDriver::P2P_MIN_TMO and canDriver::P2P_MAX_TMO.
+ *
+ * # ISO-TP TRANSACTIONS
+ *
+ * A Client can request an ISO-TP (ISO 15765-2) transaction (see the @ref isotpModule):
+ * - the driver sends up to isoTp::MAX_FRAMES_PER_SLOT frames every scheduling slot assigned to the job,
+ *   following the Block Size and STmin requested by the device;
+ * - the whole device response is sent back to the Client with a single frame.
+ *
+ * # BULK TRANSFER JOBS
+ *
+ * A Client can request a Bulk transfer job (see the @ref bulkModule):
+ * - the driver sends up to bulkTransfer::MAX_FRAMES_PER_SLOT segments every scheduling slot
+ *   assigned to the job, inside the sliding window of the job;
+ * - the job progress is notified to the Client every bulkTransfer::PROGRESS_PERIOD ms.
+ *
+ * The frames of a job not accepted by the driver write (write error or partial write)
+ * are kept and sent first in the next slot of the job: the engines never skip a frame.
+ *
+ * # JOB INTERLEAVING
+ *
+ * One ISO-TP transaction or Bulk job runs at a time, but it doesn't hold the bus
+ * until it completes (a 1MB Bulk job lasts tens of seconds):
+ * - every canDriver::JOB_SLICE slots, and every slot a CRITICAL Client has a request waiting,
+ *   the slot is offered to a Point to Point request of the Server queues;
+ * - the job is paused until the Point to Point exchange completes;
+ *   the device frames of the job are still delivered to its engine;
+ * - the Clients whose next request is an ISO-TP or Bulk request, or whose answer canId
+ *   is the one of the running job, are not served until the job completes.
+ *
+ * When a Client disconnects (see canDriver::cancelClient()) its running job is aborted
+ * and its requests waiting for a new attempt are discarded.
+ *
+ * # LATENCY
+ *
+ * The driver records the stage timestamps of every Point to Point transaction
+ * and the latency histograms (see the @ref latencyModule).
+ *
+ * # DIAGNOSTIC COUNTERS
+ *
+ * The driver counts the frames, the Point to Point transactions,
+ * the bus error conditions and the scheduling tick jitter (see canDriver::driverCounters).
+ * The counters are lock-free (see the @ref countersModule).
+ *
+ * The bus error conditions are counted when the related controller flag is set:
+ * the flags are polled every canDriver::FLAGS_PERIOD ms.
+ *
+ * # BUS LOAD
+ *
+ * The driver accounts every frame transmitted and received on the bus
+ * in the bus load estimator (see the @ref busloadModule), with the configured bitrate.
+ * In self reception mode the transmitted frames are accounted only when received back.
+ *
+ * The bus load is used by the Server admission control (see the @ref interfaceModule).
+ *
+ * # ASYNCHRONOUS OPEN
+ *
+ * At startup the device is opened with canDriver::driverOpenAsync():
+ * the open retries and the device configuration run in a background thread,
+ * while the Server and the Interface are already listening.
+ * Until the device is ready the Client requests are queued (up to the Client queue depth)
+ * and they are served when the scheduling starts.
+ *
+ * A failed open is tried again after canDriver::OPEN_RETRY_MIN_MS, doubling the delay
+ * up to canDriver::OPEN_RETRY_MAX_MS: the GetStatus Interface command reports
+ * OPENING while the open thread runs and OPEN_FAILED while a retry is waiting.
+ *
+ * The open duration (canDriver::getOpenTime()) and the time to the first accepted
+ * Client connection (Server::getFirstConnectionTime()) are logged and exported
+ * by the metrics exporter.
+ *
+ * # REPLAY MODE
+ *
+ * With canDriver::replayOpen() the VSCAN device is replaced by a simulated backend
+ * injecting the device frames of a recorded capture (see the @ref replayModule):
+ * the scheduling, the routing and the Client handling are unchanged.
+ *
+ * In the VSCAN-free build (NO_VSCAN define, see the @ref replayModule)
+ * the device cannot be opened and the replay mode is the only available backend.
+ *
  * # INTERFACE FUNCTIONS
  *
  * The Driver implements the following functions:
  * - canDriver::driverOpen(): opens the connection with the system device driver;
+ * - canDriver::driverOpenAsync(): opens the connection in a background thread;
+ * - canDriver::replayOpen(): opens the simulated backend replaying a capture;
  * - canDriver::driverClose(): close the connection with the system device driver;
  * - canDriver::sendOnCanSlot(): slot function that sends the data on the CAN bus
- * - canDriver::receivedCanFrame(): signal function emitted when a valid frame is received from the CAN bus;
+ * - canDriver::getTaps(): registry of the frame observers (see the @ref cantapModule);
  *
  *
  *
  */
 #include <QTimer>
 #include <QTimerEvent>
+#include <QElapsedTimer>
+#include <QThread>
+#include "server.h"
 
 typedef void VOID;
 typedef char CHAR;
@@ -78,6 +186,13 @@ typedef unsigned char UCHAR;
 typedef unsigned short USHORT;
 typedef unsigned long ULONG;
 #include "vs_can_api.h"
+#include "isotp.h"
+#include "bulktransfer.h"
+#include "busload.h"
+#include "latency.h"
+#include "counters.h"
+#include "replay.h"
+#include "cantap.h"
 
 /**
  * @brief This is the class implementing the Can Driver Interface
@@ -109,6 +224,15 @@ class canDriver: public QObject
 
     void driverClose(void); //!< Close the communication wioth the System Driver
     bool driverOpen(_CanBR BR, bool loopback); //!< Open the communication with the System Driver
+    bool driverOpenAsync(_CanBR BR, bool loopback); //!< Open the communication with the System Driver in a background thread
+    inline qint64 getOpenTime(void){return openTime;} //!< Returns the duration in ms of the background open (-1 if pending)
+    inline bool isOpening(void){return (opener != nullptr);} //!< The background open thread is running
+    inline bool isOpenPending(void){return (opener != nullptr) || (openRetryTimer.isActive());} //!< The device is opening or an open retry is waiting
+    inline uint getOpenFailures(void){return openFailures;} //!< Returns the failed open attempts of the background open
+    bool replayOpen(_CanBR BR, const QString& capture, double speed); //!< Open the simulated backend replaying a capture
+    inline canReplay* getReplay(void){return replay;} //!< Returns the replay engine (nullptr if not in replay mode)
+    inline canTapRegistry* getTaps(void){return &taps;} //!< Returns the registry of the frame observers
+    void cancelClient(ushort clientId); //!< Discards the running job and the retries of a disconnected Client
 
     inline bool isDeviceOpen(void){return deviceOpen;}
     inline uint8_t getApiMaj(void){return version.Major;}
@@ -118,16 +242,73 @@ class canDriver: public QObject
     inline uint8_t getHWrev(void){return hwparam.HwVersion;}
     inline uint8_t getHWsrev(void){return hwparam.SwVersion;}
 
+    static const uchar MAX_DEVICES = 64; //!< Max number of remote devices (Device ID = canId & 0x3F)
+    static const uint OPEN_RETRY_MIN_MS = 1000;     //!< Delay before the first open retry
+    static const uint OPEN_RETRY_MAX_MS = 30000;    //!< Max delay between the open retries
+
+    /// Point to Point statistics of a remote device
+    typedef struct{
+        uint requests;      //!< Requests sent to the device (first attempts)
+        uint timeouts;      //!< Answers not received in time (any attempt)
+        uint retries;       //!< Requests sent again after a timeout
+        uint recovered;     //!< Requests answered after at least a new attempt
+        uint failures;      //!< Timeouts notified to the Clients
+        uint lateReplies;   //!< Answers received after the timeout
+        uint srtt;          //!< Smoothed answer time (us)
+        uint rttvar;        //!< Answer time variance (us)
+        uint tmo;           //!< Current P2P timeout (ms)
+    }deviceStatistics;
+
+    static const uint P2P_MIN_TMO = 10;     //!< Min P2P timeout (ms)
+    static const uint P2P_MAX_TMO = 50;     //!< Max P2P timeout (ms)
+    static const uint LATE_WINDOW = 100;    //!< Time in ms an expired transaction can receive a late answer
+    static const int  MAX_EXPIRED = 16;     //!< Max number of expired transactions recorded
+
+    inline const deviceStatistics& getDeviceStatistics(uchar devId){return devStats[devId & 0x3F];}
+    void resetDeviceStatistics(void); //!< Clears the statistics of all the devices
+
+    static const uint FLAGS_PERIOD = 100;   //!< Polling period in ms of the controller error flags
+    static const uint TICK_PERIOD = 1000;   //!< Expected scheduling tick period (us)
+
+    /// Diagnostic counters of the driver
+    typedef struct{
+        statCounter rxFrames;       //!< Frames received from the bus
+        statCounter txFrames;       //!< Frames sent on the bus
+        statCounter rxFps;          //!< Frames received in the last second
+        statCounter txFps;          //!< Frames sent in the last second
+        statCounter p2pRequests;    //!< Point to Point requests sent (any attempt)
+        statCounter p2pAnswers;     //!< Point to Point answers received in time
+        statCounter p2pTimeouts;    //!< Point to Point answers not received in time
+        statCounter lateAnswers;    //!< Answers delivered after the timeout
+        statCounter asyncFrames;    //!< Frames forwarded as ASYNC frames
+        statCounter busErrors;      //!< Bus Error conditions
+        statCounter errPassive;     //!< Error Passive conditions
+        statCounter errWarning;     //!< Error Warning conditions
+        statCounter overruns;       //!< Data overrun and FIFO full conditions
+        statCounter ticks;          //!< Scheduling ticks
+        statCounter jitterSum;      //!< Sum of the tick jitters (us)
+        statCounter jitterMax;      //!< Max tick jitter (us)
+    }driverCounters;
+
+    inline const driverCounters& getCounters(void){return counters;} //!< Returns the diagnostic counters
+    void resetCounters(void); //!< Clears the diagnostic counters
+    inline int getRetryQueue(void){return retryList.size();} //!< Returns the number of requests waiting for a new attempt
+
+    inline latencyStatistics& getLatency(void){return latency;} //!< Returns the transaction latency histograms
+    inline double getBusLoad(uint windowMs){return busload.getLoad(windowMs);} //!< Returns the bus load percentage of a time window
+    inline uint getBitrate(void){return busload.getBitrate();}
+
 
 signals:
-    void receivedCanFrame(ushort id, QByteArray data); //!< Signal emitted when a CAN frame is received
-    void transmittedCanFrame(ushort id, QByteArray data); //!< Signal emitted when a CAN frame is transmitted
 
 public slots:
 
 
 private slots:
     void canTimerEvent(void);   //!< Timer scheduled to read the queue of the received messages
+    void replayCompletedHandler(void); //!< Logs the replay timing report
+    void openCompletedHandler(void); //!< Completes the background device open
+    void openRetryHandler(void); //!< Starts a new background open attempt
 
 private:
     bool deviceOpen;
@@ -144,8 +325,126 @@ private:
     bool   rxEvent;
     uint8_t rxClientId;
 
+    qint64  p2p_tmo;        //!< Timeout of the pending P2P answer (ns from p2p_txTime)
+    ushort  p2p_rxCanId;    //!< canId of the pending P2P answer
+    ushort  p2p_clientId;   //!< Client waiting for the pending P2P answer
+    isoTp   isotp;          //!< ISO-TP engine of the running ISO-TP transaction
+    bulkTransfer bulk;      //!< Engine of the running Bulk transfer job
+
+    static const uint JOB_SLICE = 10; //!< Slots of a running job between two interleaved Point to Point requests
+    static const uchar JOB_MAX_FRAMES = 8; //!< Max frames of a job slot (isoTp and bulkTransfer MAX_FRAMES_PER_SLOT)
+
+    uchar        job_type;      //!< Type of the running job (_TX_ISOTP_FRAME, _TX_BULK_FRAME), _TX_P2P_FRAME if none
+    ushort       job_rxCanId;   //!< canId of the device frames of the running job
+    ushort       job_txCanId;   //!< canId of the frames sent by the running job
+    canTxRequest jobRequest;    //!< Request of the running job
+    uint         jobSlots;      //!< Slots served to the running job since the last interleaved request
+    VSCAN_MSG    jobTx[JOB_MAX_FRAMES]; //!< Frames of the running job to be written
+    uint         jobTxCount;    //!< Frames in jobTx (the unsent ones are sent first in the next slot)
+
+    /// Point to Point request waiting for a new attempt
+    typedef struct{
+        canTxRequest request;   //!< Request to be sent again
+        uchar        attempt;   //!< Attempt number
+        qint64       due;       //!< Time of the new attempt (driverClock ms)
+    }p2pRetry;
+
+    /// Point to Point transaction expired without answer
+    typedef struct{
+        canTxRequest request;   //!< Expired request
+        ushort       rxCanId;   //!< canId of the expected answer
+        qint64       txTime;    //!< Time the request has been sent (driverClock ns)
+        qint64       expired;   //!< Time of the timeout (driverClock ms)
+    }p2pExpired;
+
+    QList<p2pExpired> expiredList;  //!< Recently expired transactions
+    qint64          p2p_txTime;     //!< Time the pending request has been sent (driverClock ns)
+
+    canTxRequest    p2pRequest;     //!< Pending Point to Point request
+    uchar           p2p_attempt;    //!< Attempt number of the pending request
+    QList<p2pRetry> retryList;      //!< Requests waiting for a new attempt
+    QElapsedTimer   driverClock;    //!< Time base of the driver
+    deviceStatistics devStats[MAX_DEVICES]; //!< Statistics of the remote devices
+    busLoad         busload;        //!< Bus load estimator
+    canTapRegistry  taps;           //!< Registry of the frame observers
+    latencyStatistics latency;      //!< Latency histograms of the Point to Point transactions
+    driverCounters  counters;       //!< Diagnostic counters
+    qint64          lastTick;       //!< Time of the last scheduling tick (driverClock ns)
+    qint64          fpsTime;        //!< Time of the last frame rate update (driverClock ms)
+    quint64         fpsRx;          //!< Received frames at the last frame rate update
+    quint64         fpsTx;          //!< Sent frames at the last frame rate update
+    qint64          flagsTime;      //!< Time of the last error flags polling (driverClock ms)
+    DWORD           busFlags;       //!< Last controller error flags
+
+    void tickStatistics(void); //!< Updates the tick jitter, the frame rates and the bus error counters
+    bool            selfReception;  //!< The transmitted frames are received back (loopback mode)
+    canReplay*      replay;         //!< Simulated backend (replay mode), nullptr with the VSCAN device
+
+    QThread*        opener;         //!< Background device open thread (nullptr if not pending)
+    bool            openResult;     //!< Result of the background open
+    _CanBR          openBR;         //!< Baudrate of the background open
+    bool            openLoopback;   //!< Loopback mode of the background open
+    QElapsedTimer   openTimer;      //!< Time base of the background open
+    qint64          openTime;       //!< Duration of the background open (ms), -1 if pending
+    QTimer          openRetryTimer; //!< Delay before the next open attempt
+    uint            openRetryDelay; //!< Current retry delay (ms)
+    uint            openFailures;   //!< Failed open attempts
+
+    void startOpener(void); //!< Starts the background open thread
+
+    bool deviceSetup(_CanBR BR, bool loopback); //!< Opens and configures the device
+    void startScheduling(_CanBR BR, bool loopback); //!< Starts the scheduling of an open device
+    static uint bitrateOf(_CanBR BR); //!< Returns the bitrate of a baudrate code
+
+    /// Sends frames on the bus (VSCAN device or simulated backend)
+    inline bool busWrite(VSCAN_MSG* msgs, uint nframes, DWORD* written){
+        if(replay) return replay->write(msgs, nframes, written);
+#ifdef NO_VSCAN
+        *written = 0;
+        return false;
+#else
+        if(VSCAN_Write(handle, msgs, nframes, written) != VSCAN_ERR_OK) return false;
+        VSCAN_Flush(handle);
+        return true;
+#endif
+    }
+
+    /// Reads the received frames in rxmsgs (VSCAN device or simulated backend)
+    inline void busRead(void){
+        if(replay) rxmsg = replay->read(rxmsgs, VSCAN_NUM_MESSAGES);
+#ifdef NO_VSCAN
+        else rxmsg = 0;
+#else
+        else VSCAN_Read(handle, rxmsgs, VSCAN_NUM_MESSAGES, &rxmsg);
+#endif
+    }
+
+    /// Reads the controller error flags (no errors on the simulated backend)
+    inline bool busGetFlags(DWORD* flags){
+        if(replay){
+            *flags = 0;
+            return true;
+        }
+#ifdef NO_VSCAN
+        return false;
+#else
+        return (VSCAN_Ioctl(handle, VSCAN_IOCTL_GET_FLAGS, flags) == VSCAN_ERR_OK);
+#endif
+    }
+
+    bool getRetryRequest(canTxRequest* request, uchar* attempt); //!< Returns a request whose backoff time is expired
+    bool lateReplyHandle(ushort canId, QByteArray* data); //!< Delivers a late answer to the requesting Client
+    void purgeExpired(const canTxRequest* request, ushort canId); //!< Removes the expired attempts of an answered request
+    void updateAnswerTime(ushort canId, qint64 rtt); //!< Updates the answer time estimation of a device
+
+    _ClientErrorCode getBusErrorReason(void); //!< Returns the reason code of a missing answer
     void printErrors(void);
     void canSendFrame(void); //!< Sends on the CAN bus
+    void jobService(void); //!< Serves the running ISO-TP transaction or Bulk job
+    void isoTpService(void); //!< Handles the running ISO-TP transaction
+    void bulkService(void); //!< Handles the running Bulk transfer job
+    uint canSendFrames(VSCAN_MSG* msgs, uint nframes); //!< Sends a set of frames with a single driver write
+    void jobSend(void); //!< Sends the frames of the running job, keeping the unsent ones
     QByteArray txData;
     uint16_t txCanId;
 
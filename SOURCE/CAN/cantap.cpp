@@ -0,0 +1,143 @@
+#include "cantap.h"
+#include <cstring>
+
+/**
+ * @brief canTap class constructor
+ *
+ * @param size: the ring size in frames, rounded up to a power of 2
+ */
+canTap::canTap(uint size){
+    ringSize = 1;
+    while(ringSize < size) ringSize <<= 1;
+    ring = new tapFrame[ringSize];
+
+    head.store(0);
+    tail.store(0);
+    dropped.store(0);
+    setFilter(0, 0, DIR_RX | DIR_TX);
+}
+
+canTap::~canTap(){
+    delete[] ring;
+}
+
+/**
+ * @brief This function sets the frames accepted by the tap
+ *
+ * A frame is accepted when (canId & mask) == value and its direction is enabled.
+ * The filter shall be changed in the driver thread.
+ *
+ * @param mask: the identifier mask (0 = all the identifiers)
+ * @param value: the identifier value
+ * @param directions: the accepted directions (DIR_RX, DIR_TX)
+ */
+void canTap::setFilter(ushort mask, ushort value, uint directions){
+    this->mask = mask;
+    this->value = value & mask;
+    this->directions = directions;
+}
+
+/**
+ * @brief This function queues a frame
+ *
+ * The function is called by the driver: if the ring is full the frame is discarded.
+ *
+ * @param frame: the frame
+ */
+void canTap::push(const tapFrame* frame){
+    uint h = head.load(std::memory_order_relaxed);
+    if(h - tail.load(std::memory_order_acquire) >= ringSize){
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring[h & (ringSize - 1)] = *frame;
+    head.store(h + 1, std::memory_order_release);
+}
+
+/**
+ * @brief This function reads the queued frames
+ *
+ * @param frames: the array of the read frames
+ * @param max: the array size
+ * @return the number of frames read
+ */
+uint canTap::read(tapFrame* frames, uint max){
+    uint t = tail.load(std::memory_order_relaxed);
+    uint h = head.load(std::memory_order_acquire);
+
+    uint n = 0;
+    while((t != h) && (n < max)){
+        frames[n++] = ring[t & (ringSize - 1)];
+        t++;
+    }
+
+    tail.store(t, std::memory_order_release);
+    return n;
+}
+
+/**
+ * @brief canTapRegistry class constructor
+ */
+canTapRegistry::canTapRegistry(){
+    for(int i=0; i<MAX_TAPS; i++) taps[i] = nullptr;
+    count = 0;
+    clock.start();
+}
+
+/**
+ * @brief This function subscribes a tap
+ *
+ * @param tap: the tap
+ * @return true if the tap is subscribed (false if all the slots are in use)
+ */
+bool canTapRegistry::subscribe(canTap* tap){
+    int slot = -1;
+    for(int i=0; i<MAX_TAPS; i++){
+        if(taps[i] == tap) return true;
+        if((!taps[i]) && (slot < 0)) slot = i;
+    }
+    if(slot < 0) return false;
+
+    taps[slot] = tap;
+    count++;
+    return true;
+}
+
+/**
+ * @brief This function unsubscribes a tap
+ *
+ * @param tap: the tap
+ */
+void canTapRegistry::unsubscribe(canTap* tap){
+    for(int i=0; i<MAX_TAPS; i++){
+        if(taps[i] != tap) continue;
+        taps[i] = nullptr;
+        count--;
+        return;
+    }
+}
+
+/**
+ * @brief This function copies a frame in the taps accepting it
+ *
+ * @param direction: the frame direction (see canTap::_Direction)
+ * @param id: the CAN identifier
+ * @param flags: the VSCAN frame flags
+ * @param data: the data bytes
+ * @param dlc: the data length
+ */
+void canTapRegistry::dispatch(uchar direction, ushort id, uchar flags, const uchar* data, uchar dlc){
+    tapFrame frame;
+    frame.time = clock.nsecsElapsed();
+    frame.id = id;
+    frame.direction = direction;
+    frame.flags = flags;
+    frame.dlc = (dlc > 8) ? 8 : dlc;
+    memset(frame.data, 0, 8);
+    memcpy(frame.data, data, frame.dlc);
+
+    for(int i=0; i<MAX_TAPS; i++){
+        if((taps[i]) && (taps[i]->accepts(id, direction))) taps[i]->push(&frame);
+    }
+}
@@ -0,0 +1,130 @@
+#ifndef CANTAP_H
+#define CANTAP_H
+
+/*!
+ * \defgroup  cantapModule CAN Frame Tap Module.
+ *
+ * This Module implements the observers of the CAN frames handled by the driver.
+ *
+ * # TAP REGISTRY
+ *
+ * An observer (debug window, candump tap, ..) subscribes a canTap to the
+ * canTapRegistry of the driver (see canDriver::getTaps()):
+ * - every frame received or sent by the driver is offered to the registry;
+ * - the frame is copied in the queue of every subscribed tap whose filter accepts it;
+ * - the observer reads the queued frames at its own pace (e.g. on a timer).
+ *
+ * When no tap is subscribed, the driver only pays the test of the subscribed tap counter:
+ * no copy, no allocation and no signal dispatch.
+ *
+ * # TAP QUEUE
+ *
+ * The tap queue is a lock-free single producer (the driver) single consumer
+ * (the observer) ring of canTap::size() frames:
+ * - the driver never waits: when the ring is full the frame is discarded and counted;
+ * - the observer may run in a different thread than the driver.
+ *
+ * The subscription and the unsubscription shall be done in the driver thread;
+ * a tap shall be unsubscribed before it is destroyed.
+ *
+ * # FILTER
+ *
+ * A tap accepts a frame when (canId & mask) == value and the frame direction
+ * is enabled (see canTap::setFilter()). The default filter accepts all the frames.
+ */
+
+#include <QtGlobal>
+#include <QElapsedTimer>
+#include <atomic>
+
+/// This is a frame queued in a tap
+typedef struct{
+    qint64  time;       //!< Time of the frame (registry clock ns)
+    ushort  id;         //!< CAN identifier
+    uchar   direction;  //!< Frame direction (see canTap::_Direction)
+    uchar   flags;      //!< VSCAN frame flags
+    uchar   dlc;        //!< Data length
+    uchar   data[8];    //!< Data bytes
+}tapFrame;
+
+/**
+ * @brief This class implements a frame observer queue
+ *
+ * \ingroup cantapModule
+ */
+class canTap
+{
+public:
+
+    /// This enumeration defines the frame direction
+    typedef enum{
+        _TAP_RX = 0,    //!< Frame received from the bus
+        _TAP_TX         //!< Frame sent on the bus
+    }_Direction;
+
+    static const uint DIR_RX = (1 << _TAP_RX);  //!< Direction mask of the received frames
+    static const uint DIR_TX = (1 << _TAP_TX);  //!< Direction mask of the sent frames
+    static const uint DEFAULT_SIZE = 4096;      //!< Default ring size (frames)
+
+    explicit canTap(uint size = DEFAULT_SIZE);
+    ~canTap();
+
+    void setFilter(ushort mask, ushort value, uint directions); //!< Sets the frames accepted by the tap
+
+    /// Returns true if the filter accepts a frame
+    inline bool accepts(ushort id, uchar direction){
+        return ((id & mask) == value) && (directions & (1 << direction));
+    }
+
+    void push(const tapFrame* frame); //!< Queues a frame (driver side)
+    uint read(tapFrame* frames, uint max); //!< Reads the queued frames (observer side)
+
+    inline uint size(void){return ringSize;}
+    inline quint64 getDropped(void){return dropped.load(std::memory_order_relaxed);}
+
+private:
+    tapFrame*           ring;       //!< Frame ring
+    uint                ringSize;   //!< Ring size (power of 2)
+    std::atomic<uint>   head;       //!< Next slot written by the driver
+    std::atomic<uint>   tail;       //!< Next slot read by the observer
+    std::atomic<quint64> dropped;   //!< Frames discarded with the ring full
+
+    ushort              mask;       //!< Identifier filter mask
+    ushort              value;      //!< Identifier filter value
+    uint                directions; //!< Accepted directions (DIR_RX | DIR_TX)
+};
+
+/**
+ * @brief This class implements the registry of the subscribed taps
+ *
+ * \ingroup cantapModule
+ */
+class canTapRegistry
+{
+public:
+
+    canTapRegistry();
+
+    static const int MAX_TAPS = 8; //!< Max number of subscribed taps
+
+    bool subscribe(canTap* tap); //!< Subscribes a tap
+    void unsubscribe(canTap* tap); //!< Unsubscribes a tap
+
+    /// Offers a frame to the subscribed taps
+    inline void frame(uchar direction, ushort id, uchar flags, const uchar* data, uchar dlc){
+        if(Q_LIKELY(!count)) return;
+        dispatch(direction, id, flags, data, dlc);
+    }
+
+    inline int getCount(void){return count;}
+    inline qint64 getTime(void){return clock.nsecsElapsed();} //!< Returns the current registry clock time (ns)
+
+private:
+    canTap*         taps[MAX_TAPS]; //!< Subscribed taps
+    int             count;          //!< Number of subscribed taps
+    QElapsedTimer   clock;          //!< Time base of the frames
+
+    void dispatch(uchar direction, ushort id, uchar flags, const uchar* data, uchar dlc); //!< Copies a frame in the accepting taps
+};
+
+#endif // CANTAP_H
@@ -0,0 +1,307 @@
+#include "isotp.h"
+
+/**
+ * @brief isoTp class constructor
+ */
+isoTp::isoTp(){
+    state = _ISOTP_IDLE;
+    error = _ISOTP_ERR_NONE;
+    txIndex = 0;
+    txSn = 0;
+    txBs = 0;
+    txBsCount = 0;
+    txStMin = 0;
+    wftCount = 0;
+    rxLen = 0;
+    rxSn = 0;
+    rxBsCount = 0;
+}
+
+/**
+ * @brief This function starts a new transaction.
+ *
+ * The request payload is stored and the first frame
+ * will be returned by the next isoTp::getTxFrame() call.
+ *
+ * @param request: this is the payload to be sent to the device
+ */
+void isoTp::start(const QByteArray& request){
+    txData = request;
+    txIndex = 0;
+    txSn = 1;
+    txBs = 0;
+    txBsCount = 0;
+    txStMin = 0;
+    wftCount = 0;
+
+    rxData.clear();
+    rxLen = 0;
+    rxSn = 1;
+
+    error = _ISOTP_ERR_NONE;
+    if((txData.size() == 0) || ((uint) txData.size() > MAX_PAYLOAD)){
+        setError(_ISOTP_ERR_OVERFLOW);
+        return;
+    }
+
+    state = _ISOTP_TX_FIRST;
+    timer.start();
+}
+
+/**
+ * @brief This function terminates the current transaction
+ */
+void isoTp::abort(void){
+    state = _ISOTP_IDLE;
+}
+
+void isoTp::setError(_Error err){
+    error = err;
+    state = _ISOTP_ERROR;
+}
+
+/**
+ * @brief This function converts the STmin protocol code in microseconds
+ *
+ * - 0x00 to 0x7F: 0 to 127 ms;
+ * - 0xF1 to 0xF9: 100 to 900 us;
+ * - reserved values are handled as the max value (127ms).
+ *
+ * @param stmin: the STmin code received with the Flow Control frame
+ * @return the separation time in microseconds
+ */
+qint64 isoTp::decodeStMin(uchar stmin){
+    if(stmin <= 0x7F) return ((qint64) stmin) * 1000;
+    if((stmin >= 0xF1) && (stmin <= 0xF9)) return ((qint64) (stmin - 0xF0)) * 100;
+    return 127000;
+}
+
+/**
+ * @brief This function returns the next frame to be sent on the bus.
+ *
+ * The canDriver calls this function every scheduling slot, until
+ * the function returns false.
+ *
+ * The function verifies also the protocol timeouts:
+ * in case of timeout the transaction is terminated in error.
+ *
+ * @param data: pointer to the 8 bytes frame to be filled
+ * @return true if a frame shall be sent
+ */
+bool isoTp::getTxFrame(uchar* data){
+    for(int i=0; i<8; i++) data[i] = 0;
+
+    switch(state){
+
+    case _ISOTP_TX_FIRST:
+        if(txData.size() <= 7){
+            // Single Frame
+            data[0] = (uchar) txData.size();
+            for(int i=0; i<txData.size(); i++) data[1+i] = txData.at(i);
+            txIndex = txData.size();
+            state = _ISOTP_RX_WAIT;
+        }else if(txData.size() <= 4095){
+            // First Frame
+            data[0] = 0x10 | ((txData.size() >> 8) & 0x0F);
+            data[1] = txData.size() & 0xFF;
+            for(int i=0; i<6; i++) data[2+i] = txData.at(i);
+            txIndex = 6;
+            state = _ISOTP_TX_WAIT_FC;
+        }else{
+            // First Frame with escape sequence
+            data[0] = 0x10;
+            data[1] = 0;
+            data[2] = (txData.size() >> 24) & 0xFF;
+            data[3] = (txData.size() >> 16) & 0xFF;
+            data[4] = (txData.size() >> 8) & 0xFF;
+            data[5] = txData.size() & 0xFF;
+            data[6] = txData.at(0);
+            data[7] = txData.at(1);
+            txIndex = 2;
+            state = _ISOTP_TX_WAIT_FC;
+        }
+        timer.start();
+        return true;
+
+    case _ISOTP_TX_WAIT_FC:
+        if(timer.elapsed() > N_BS_TMO) setError(_ISOTP_ERR_TIMEOUT_BS);
+        return false;
+
+    case _ISOTP_TX_CF:
+        // Separation time between Consecutive frames
+        if((txStMin) && (stTimer.isValid()) && (stTimer.nsecsElapsed() < txStMin * 1000)) return false;
+
+        data[0] = 0x20 | (txSn & 0x0F);
+        for(int i=0; (i<7) && (txIndex < txData.size()); i++) data[1+i] = txData.at(txIndex++);
+        txSn = (txSn + 1) & 0x0F;
+        stTimer.start();
+        timer.start();
+
+        if(txIndex >= txData.size()){
+            state = _ISOTP_RX_WAIT;
+            return true;
+        }
+
+        // The device requests a new Flow Control after BS frames
+        if(txBs){
+            txBsCount++;
+            if(txBsCount >= txBs) state = _ISOTP_TX_WAIT_FC;
+        }
+        return true;
+
+    case _ISOTP_RX_WAIT:
+        if(timer.elapsed() > P2_TMO) setError(_ISOTP_ERR_TIMEOUT_P2);
+        return false;
+
+    case _ISOTP_RX_FC:
+        rxBsCount = 0;
+        data[0] = 0x30;
+        data[1] = RX_BLOCK_SIZE;
+        data[2] = RX_STMIN;
+        state = _ISOTP_RX_CF;
+        timer.start();
+        return true;
+
+    case _ISOTP_RX_CF:
+        if(timer.elapsed() > N_CR_TMO) setError(_ISOTP_ERR_TIMEOUT_CR);
+        return false;
+
+    case _ISOTP_RX_OVFLW:
+        // The response is refused: the transaction terminates after the Flow Control frame
+        data[0] = 0x32;
+        setError(_ISOTP_ERR_OVERFLOW);
+        return true;
+
+    default:
+        return false;
+    }
+
+}
+
+/**
+ * @brief This function handles a frame received from the device
+ *
+ * The frame shall be already filtered by the canDriver
+ * with the device answer canId.
+ *
+ * @param data: this is the frame content
+ * @param len: this is the frame length
+ */
+void isoTp::rxFrame(const uchar* data, uchar len){
+    if(!len) return;
+    uchar pci = data[0] >> 4;
+
+    switch(state){
+
+    case _ISOTP_TX_WAIT_FC:
+        if((pci != 3) || (len < 3)) return; // Not a Flow Control frame: ignored
+
+        switch(data[0] & 0x0F){
+        case 0: // Continue To Send
+            txBs = data[1];
+            txBsCount = 0;
+            txStMin = decodeStMin(data[2]);
+            wftCount = 0;
+            stTimer.invalidate(); // The first CF is sent without separation time
+            state = _ISOTP_TX_CF;
+            timer.start();
+            return;
+
+        case 1: // Wait
+            wftCount++;
+            if(wftCount > MAX_WFT) setError(_ISOTP_ERR_WFT_OVRN);
+            else timer.start();
+            return;
+
+        case 2: // Overflow
+            setError(_ISOTP_ERR_OVERFLOW);
+            return;
+
+        default:
+            setError(_ISOTP_ERR_INVALID);
+            return;
+        }
+
+    case _ISOTP_RX_WAIT:
+        if(pci == 0){
+            // Single Frame
+            uchar sflen = data[0] & 0x0F;
+            if((sflen == 0) || (sflen > len - 1)){
+                setError(_ISOTP_ERR_INVALID);
+                return;
+            }
+            rxData = QByteArray((const char*) &data[1], sflen);
+            state = _ISOTP_COMPLETED;
+            return;
+        }
+
+        if(pci == 1){
+            // First Frame
+            if(len < 8){
+                setError(_ISOTP_ERR_INVALID);
+                return;
+            }
+
+            int offset = 2;
+            rxLen = ((uint) (data[0] & 0x0F) << 8) | data[1];
+            if(rxLen == 0){
+                rxLen = ((uint) data[2] << 24) | ((uint) data[3] << 16) | ((uint) data[4] << 8) | data[5];
+                offset = 6;
+
+                // The escape form is valid only for the lengths not fitting 12 bits
+                if(rxLen <= 0xFFF){
+                    setError(_ISOTP_ERR_INVALID);
+                    return;
+                }
+            }
+
+            // A length fitting a Single Frame is not valid in a First Frame
+            if(rxLen <= 7){
+                setError(_ISOTP_ERR_INVALID);
+                return;
+            }
+
+            // The device is informed with an Overflow Flow Control frame
+            if(rxLen > MAX_PAYLOAD){
+                error = _ISOTP_ERR_OVERFLOW;
+                state = _ISOTP_RX_OVFLW;
+                return;
+            }
+
+            rxData.clear();
+            rxData.reserve(rxLen);
+            rxData.append((const char*) &data[offset], len - offset);
+            rxSn = 1;
+            state = _ISOTP_RX_FC;
+            return;
+        }
+        return; // Other frames are ignored
+
+    case _ISOTP_RX_CF:
+        if(pci != 2) return;
+        if((data[0] & 0x0F) != rxSn){
+            setError(_ISOTP_ERR_WRONG_SN);
+            return;
+        }
+
+        rxSn = (rxSn + 1) & 0x0F;
+        for(int i=1; (i < len) && ((uint) rxData.size() < rxLen); i++) rxData.append((char) data[i]);
+        timer.start();
+
+        if((uint) rxData.size() >= rxLen){
+            state = _ISOTP_COMPLETED;
+            return;
+        }
+
+        // A new Flow Control is requested every RX_BLOCK_SIZE frames
+        if(RX_BLOCK_SIZE){
+            rxBsCount++;
+            if(rxBsCount >= RX_BLOCK_SIZE) state = _ISOTP_RX_FC;
+        }
+        return;
+
+    default:
+        return;
+    }
+
+}
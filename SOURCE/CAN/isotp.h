@@ -0,0 +1,125 @@
+#ifndef ISOTP_H
+#define ISOTP_H
+
+/*!
+ * \defgroup  isotpModule ISO-TP Transport Module.
+ *
+ * This Module implements the ISO 15765-2 (ISO-TP) transport protocol
+ * used to exchange payloads longer than 8 bytes with the remote devices.
+ *
+ * # PROTOCOL OVERVIEW
+ *
+ * The module implements a single request/response transaction with
+ * the normal addressing format (the PCI byte is the first data byte):
+ *
+ * - Single Frame (SF):      0x0L [data]; L = payload length (1 to 7 bytes);
+ * - First Frame (FF):       0x1H LL [data]; HLL = payload length (8 to 4095 bytes);
+ * - First Frame escape:     0x10 0x00 L3 L2 L1 L0 [data]; 32 bit payload length (> 4095 bytes);
+ * - Consecutive Frame (CF): 0x2N [data]; N = Sequence Number (1..15, 0, 1, ..);
+ * - Flow Control (FC):      0x3S BS STmin; S = Flow Status (0=CTS, 1=WAIT, 2=OVERFLOW);
+ *
+ * The request is segmented and sent to the device following the Block Size
+ * and the STmin requested by the device with its Flow Control frames.
+ *
+ * When the request has been completelly transmitted, the module waits for the
+ * device response: if the response is segmented (First Frame),
+ * a Flow Control frame is sent back to the device with:
+ * - BS = isoTp::RX_BLOCK_SIZE;
+ * - STmin = isoTp::RX_STMIN;
+ *
+ * A response First Frame longer than isoTp::MAX_PAYLOAD is refused with
+ * an Overflow Flow Control frame (0x32), then the transaction terminates in error.
+ *
+ * The module doesn't access the CAN bus directly:
+ * - the canDriver polls the isoTp::getTxFrame() every scheduling slot
+ *   to get the frames to be sent;
+ * - the canDriver forwards the frames received from the device to the isoTp::rxFrame();
+ *
+ *  NOTE: the frames are always sent with 8 bytes. The bytes not used are set to 0.
+ *
+ */
+
+#include <QByteArray>
+#include <QElapsedTimer>
+
+/**
+ * @brief This class implements a single ISO-TP transaction
+ *
+ * \ingroup isotpModule
+ */
+class isoTp
+{
+public:
+
+    isoTp();
+
+    static const uint  MAX_PAYLOAD = 65535;     //!< Max accepted payload length (request and response)
+    static const uchar RX_BLOCK_SIZE = 0;       //!< Block Size sent to the device (0 = no more Flow Control frames)
+    static const uchar RX_STMIN = 0;            //!< STmin sent to the device
+    static const uint  N_BS_TMO = 100;          //!< Max time in ms waiting for a Flow Control frame
+    static const uint  N_CR_TMO = 100;          //!< Max time in ms waiting for a Consecutive Frame
+    static const uint  P2_TMO = 100;            //!< Max time in ms waiting for the device response
+    static const uchar MAX_WFT = 10;            //!< Max number of consecutive WAIT Flow Control frames
+    static const uchar MAX_FRAMES_PER_SLOT = 8; //!< Max number of frames sent in a single scheduling slot
+
+    /// This enumeration defines the transaction status
+    typedef enum{
+        _ISOTP_IDLE = 0,        //!< No transaction is pending
+        _ISOTP_TX_FIRST,        //!< The first frame (SF or FF) shall be sent
+        _ISOTP_TX_WAIT_FC,      //!< Waiting for the device Flow Control frame
+        _ISOTP_TX_CF,           //!< Sending the Consecutive Frames
+        _ISOTP_RX_WAIT,         //!< Waiting for the device response
+        _ISOTP_RX_FC,           //!< A Flow Control frame shall be sent to the device
+        _ISOTP_RX_OVFLW,        //!< An Overflow Flow Control frame shall be sent to the device
+        _ISOTP_RX_CF,           //!< Receiving the response Consecutive Frames
+        _ISOTP_COMPLETED,       //!< The response has been successfully received
+        _ISOTP_ERROR            //!< The transaction is terminated in error
+    }_State;
+
+    /// This enumeration defines the transaction error codes
+    typedef enum{
+        _ISOTP_ERR_NONE = 0,
+        _ISOTP_ERR_TIMEOUT_BS,  //!< Timeout waiting for the Flow Control frame
+        _ISOTP_ERR_TIMEOUT_CR,  //!< Timeout waiting for the Consecutive Frame
+        _ISOTP_ERR_TIMEOUT_P2,  //!< Timeout waiting for the device response
+        _ISOTP_ERR_WRONG_SN,    //!< Wrong Sequence Number received
+        _ISOTP_ERR_OVERFLOW,    //!< Buffer overflow (device or bridge)
+        _ISOTP_ERR_WFT_OVRN,    //!< Too many WAIT Flow Control frames
+        _ISOTP_ERR_INVALID      //!< Invalid frame received
+    }_Error;
+
+    void start(const QByteArray& request); //!< Starts a new transaction
+    void abort(void); //!< Terminates the current transaction
+    bool getTxFrame(uchar* data); //!< Returns the next frame to be sent on the bus
+    void rxFrame(const uchar* data, uchar len); //!< Handles a frame received from the device
+
+    inline bool isBusy(void){return ((state != _ISOTP_IDLE) && (state != _ISOTP_COMPLETED) && (state != _ISOTP_ERROR));}
+    inline bool isCompleted(void){return (state == _ISOTP_COMPLETED);}
+    inline bool isError(void){return (state == _ISOTP_ERROR);}
+    inline _Error getError(void){return error;}
+    inline const QByteArray& getResponse(void){return rxData;}
+
+private:
+    _State      state;
+    _Error      error;
+    QElapsedTimer timer;    //!< Timer for the protocol timeouts
+    QElapsedTimer stTimer;  //!< Timer for the STmin separation time
+
+    QByteArray  txData;     //!< Request payload
+    int         txIndex;    //!< Index of the next byte to be sent
+    uchar       txSn;       //!< Sequence Number of the next Consecutive Frame
+    uchar       txBs;       //!< Block Size requested by the device
+    uchar       txBsCount;  //!< Consecutive Frames sent in the current block
+    qint64      txStMin;    //!< Separation time requested by the device (us)
+    uchar       wftCount;   //!< Number of consecutive WAIT Flow Control frames
+
+    QByteArray  rxData;     //!< Response payload
+    uint        rxLen;      //!< Expected response length
+    uchar       rxSn;       //!< Expected Sequence Number of the next Consecutive Frame
+    uchar       rxBsCount;  //!< Consecutive Frames received in the current block
+
+    void setError(_Error err);
+    static qint64 decodeStMin(uchar stmin);
+};
+
+#endif // ISOTP_H
@@ -0,0 +1,239 @@
+#include "replay.h"
+#include "capturereader.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+
+/**
+ * @brief canReplay class constructor
+ */
+canReplay::canReplay(){
+    head.store(0);
+    tail.store(0);
+    speed = 1.0;
+    worker = nullptr;
+    running.store(false);
+    abortRequest.store(false);
+    injected.store(0);
+    total.store(0);
+    stalls.store(0);
+}
+
+/**
+ * @brief This function returns the files of a capture
+ *
+ * @param capture: a capture file (basename_NNNN.cap), a capture basename or a directory
+ * @return the capture files in index order
+ */
+QStringList canReplay::captureFiles(const QString& capture){
+    QFileInfo info(capture);
+    QDir dir;
+    QString filter;
+
+    if(info.isDir()){
+        dir = QDir(capture);
+        filter = QString("*%1").arg(CAPTURE_EXTENSION);
+    }else{
+        QString base = info.fileName();
+        base.remove(QRegularExpression(QString("_\\d{4}\\%1$").arg(CAPTURE_EXTENSION)));
+        dir = info.dir();
+        filter = QString("%1_*%2").arg(base).arg(CAPTURE_EXTENSION);
+    }
+
+    // The file index has a fixed number of digits: the name order is the index order
+    QStringList list;
+    QStringList names = dir.entryList(QStringList(filter), QDir::Files, QDir::Name);
+    for(int i=0; i<names.size(); i++) list.append(dir.filePath(names[i]));
+    return list;
+}
+
+/**
+ * @brief This function starts the replay of a capture
+ *
+ * @param capture: a capture file, a capture basename or a directory (see captureFiles())
+ * @param factor: the speed factor (2 = twice the original speed)
+ * @return true if the capture files have been found
+ */
+bool canReplay::start(const QString& capture, double factor){
+    stop();
+
+    files = captureFiles(capture);
+    if(files.isEmpty()) return false;
+
+    speed = (factor > 0) ? factor : 1.0;
+    head.store(0);
+    tail.store(0);
+    injected.store(0);
+    total.store(0);
+    stalls.store(0);
+    pacing.reset();
+    pickup.reset();
+
+    abortRequest.store(false);
+    running.store(true);
+    clock.start();
+    worker = QThread::create([this](){ replayThread(); });
+    worker->start(QThread::TimeCriticalPriority);
+    return true;
+}
+
+/**
+ * @brief This function stops the replay
+ */
+void canReplay::stop(void){
+    if(!worker) return;
+
+    abortRequest.store(true);
+    worker->wait();
+    delete worker;
+    worker = nullptr;
+    running.store(false, std::memory_order_release);
+}
+
+/**
+ * @brief This function waits for a clock time
+ *
+ * The thread sleeps up to SPIN_MARGIN ns before the due time, then it spins.
+ * The sleep is split in 100ms steps in order to handle the stop request.
+ *
+ * @param due: the clock time (ns)
+ */
+void canReplay::waitUntil(qint64 due){
+    for(;;){
+        qint64 remaining = due - clock.nsecsElapsed();
+        if(remaining <= 0) return;
+        if(abortRequest.load(std::memory_order_relaxed)) return;
+
+        if(remaining > SPIN_MARGIN){
+            qint64 us = (remaining - SPIN_MARGIN) / 1000;
+            if(us > 100000) us = 100000;
+            QThread::usleep(us);
+        }
+    }
+}
+
+/**
+ * @brief Replay thread body
+ *
+ * The RX records of the capture files are injected in the ring at their due time:
+ * - the due time is the record time from the first RX record, divided by the speed factor;
+ * - if the ring is full (driver not reading) the injection waits and a stall is counted.
+ */
+void canReplay::replayThread(void){
+    captureReader reader;
+
+    // Counts the frames to be injected
+    quint64 frames = 0;
+    for(int f=0; f<files.size(); f++){
+        if(!reader.open(files[f])) continue;
+        for(quint64 i=0; i<reader.getCount(); i++){
+            if(reader.getRecord(i)->direction == _CAPTURE_RX) frames++;
+        }
+    }
+    total.store(frames, std::memory_order_relaxed);
+
+    qint64 first = -1;
+    qint64 start = clock.nsecsElapsed();
+
+    for(int f=0; f<files.size(); f++){
+        if(!reader.open(files[f])) continue;
+
+        for(quint64 i=0; i<reader.getCount(); i++){
+            const captureRecord* rec = reader.getRecord(i);
+            if(rec->direction != _CAPTURE_RX) continue;
+            if(first < 0) first = rec->timestamp;
+
+            qint64 due = start + (qint64) ((rec->timestamp - first) / speed);
+            waitUntil(due);
+
+            uint h = head.load(std::memory_order_relaxed);
+            if(h - tail.load(std::memory_order_acquire) >= RING_SIZE){
+                stalls.fetch_add(1, std::memory_order_relaxed);
+                while(h - tail.load(std::memory_order_acquire) >= RING_SIZE){
+                    if(abortRequest.load(std::memory_order_relaxed)) break;
+                    QThread::usleep(100);
+                }
+            }
+            if(abortRequest.load(std::memory_order_relaxed)){
+                running.store(false, std::memory_order_release);
+                return;
+            }
+
+            replayFrame* frame = &ring[h & (RING_SIZE - 1)];
+            frame->msg.Id = rec->id;
+            frame->msg.Size = rec->dlc;
+            frame->msg.Flags = rec->flags;
+            frame->msg.Timestamp = 0;
+            for(int j=0; j<8; j++) frame->msg.Data[j] = rec->data[j];
+            frame->injected = clock.nsecsElapsed();
+
+            qint64 us = (frame->injected - due) / 1000;
+            pacing.record((quint32) ((us > 0xFFFFFFFF) ? 0xFFFFFFFF : us));
+
+            head.store(h + 1, std::memory_order_release);
+            injected.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Publishes the pacing histogram
+    running.store(false, std::memory_order_release);
+    emit replayCompleted();
+}
+
+/**
+ * @brief This function reads the injected frames
+ *
+ * The function is called by the driver every scheduling tick in place of the VSCAN_Read().
+ *
+ * @param msgs: the array of the received frames
+ * @param max: the array size
+ * @return the number of frames read
+ */
+uint canReplay::read(VSCAN_MSG* msgs, uint max){
+    uint t = tail.load(std::memory_order_relaxed);
+    uint h = head.load(std::memory_order_acquire);
+    qint64 now = clock.nsecsElapsed();
+
+    uint n = 0;
+    while((t != h) && (n < max)){
+        replayFrame* frame = &ring[t & (RING_SIZE - 1)];
+        msgs[n++] = frame->msg;
+
+        qint64 us = (now - frame->injected) / 1000;
+        pickup.record((quint32) ((us > 0xFFFFFFFF) ? 0xFFFFFFFF : us));
+        t++;
+    }
+
+    tail.store(t, std::memory_order_release);
+    return n;
+}
+
+/**
+ * @brief This function sends frames on the simulated bus
+ *
+ * The simulated bus has no devices: the frames are accepted and discarded.
+ *
+ * @param msgs: the frames
+ * @param nframes: the number of frames
+ * @param written: the number of frames sent
+ * @return true
+ */
+bool canReplay::write(const VSCAN_MSG* msgs, uint nframes, DWORD* written){
+    Q_UNUSED(msgs);
+    *written = nframes;
+    return true;
+}
+
+/**
+ * @brief This function returns the replay timing report
+ *
+ * The pacing values are reported only when the replay thread has terminated.
+ *
+ * @return the report: injected total stalls pacing(avg p50 p99 max) pickup(avg p50 p99 max) in us
+ */
+QString canReplay::getReport(void){
+    return QString("INJECTED:%1/%2 STALLS:%3 PACING(us) AVG:%4 P50:%5 P99:%6 MAX:%7 PICKUP(us) AVG:%8 P50:%9 P99:%10 MAX:%11")
+            .arg(getInjected()).arg(getTotal()).arg(getStalls())
+            .arg(getPacing().getAvg()).arg(getPacing().getPercentile(50)).arg(getPacing().getPercentile(99)).arg(getPacing().getMax())
+            .arg(pickup.getAvg()).arg(pickup.getPercentile(50)).arg(pickup.getPercentile(99)).arg(pickup.getMax());
+}
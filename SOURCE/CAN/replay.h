@@ -0,0 +1,125 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+/*!
+ * \defgroup  replayModule Capture Replay Module.
+ *
+ * This Module implements a simulated CAN backend replaying a recorded capture
+ * (see the @ref captureModule) in place of the VSCAN device.
+ *
+ * # REPLAY
+ *
+ * The replay is activated with the -replay command line option (see the main page):
+ * - the frames received from the devices (RX records) are injected in the driver
+ *   reception queue at their original relative timing, divided by the speed factor;
+ * - the frames sent by the original bridge (TX records) are not replayed:
+ *   the live Clients connect and send their requests as usual;
+ * - the frames sent by the driver are accepted by the simulated bus and discarded;
+ *
+ * # PACING
+ *
+ * A dedicated thread paces the injection with the high resolution monotonic clock:
+ * - the thread sleeps until canReplay::SPIN_MARGIN ns before the due time,
+ *   then it spins up to the due time (the sleep resolution of the OS is not enough);
+ * - the injected frames are passed to the driver with a lock-free single producer
+ *   single consumer ring (canReplay::RING_SIZE frames): the driver reads them
+ *   every scheduling tick as it reads the VSCAN queue.
+ *
+ * # TIMING REPORT
+ *
+ * Two timing errors are measured for every frame (see the @ref latencyModule histograms):
+ * - pacing: injection time - due time (the replay thread accuracy);
+ * - pickup: driver reception - injection time (the scheduling tick granularity);
+ *
+ * The report is logged at the end of the replay and it is available with
+ * the GetReplayStatus Interface command.
+ *
+ * The counters are atomic and can be read during the replay; the pacing histogram
+ * is written by the replay thread and it is published only when the replay
+ * thread has terminated (empty while the replay is running).
+ *
+ * # VSCAN-FREE BUILD
+ *
+ * With the novscan build option (qmake CONFIG+=novscan, NO_VSCAN define) the VSCAN
+ * library is neither linked nor called: the driver can only run the replay backend,
+ * so a capture can be replayed deterministically on a host without the device library.
+ */
+
+#include <QObject>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <atomic>
+#include "vs_can_api.h"
+#include "latency.h"
+
+/**
+ * @brief This class implements the simulated CAN backend replaying a capture
+ *
+ * \ingroup replayModule
+ */
+class canReplay: public QObject
+{
+    Q_OBJECT
+
+public:
+
+    canReplay();
+    ~canReplay(){stop();}
+
+    static const uint RING_SIZE = 8192;             //!< Frames of the injection ring (power of 2)
+    static const qint64 SPIN_MARGIN = 2000000;      //!< Time before the due time the thread stops sleeping (ns)
+
+    bool start(const QString& capture, double factor); //!< Starts the replay of a capture
+    void stop(void); //!< Stops the replay
+
+    uint read(VSCAN_MSG* msgs, uint max); //!< Reads the injected frames (driver side)
+    bool write(const VSCAN_MSG* msgs, uint nframes, DWORD* written); //!< Sends frames on the simulated bus
+
+    QString getReport(void); //!< Returns the replay timing report
+
+    inline bool isRunning(void){return running.load(std::memory_order_acquire);}
+    inline quint64 getInjected(void){return injected.load(std::memory_order_relaxed);}
+    inline quint64 getTotal(void){return total.load(std::memory_order_relaxed);}
+    inline quint64 getStalls(void){return stalls.load(std::memory_order_relaxed);}
+    inline double getSpeed(void){return speed;}
+
+    /// Returns the pacing histogram: empty until the replay thread has terminated
+    inline const latencyHistogram& getPacing(void){return (isRunning()) ? noPacing : pacing;}
+    inline const latencyHistogram& getPickup(void){return pickup;}
+
+signals:
+    void replayCompleted(void); //!< Emitted by the replay thread when all the frames have been injected
+
+private:
+
+    /// This is an injected frame
+    typedef struct{
+        VSCAN_MSG   msg;        //!< Frame content
+        qint64      injected;   //!< Injection time (clock ns)
+    }replayFrame;
+
+    replayFrame         ring[RING_SIZE];    //!< Injection ring
+    std::atomic<uint>   head;               //!< Next slot written by the replay thread
+    std::atomic<uint>   tail;               //!< Next slot read by the driver
+
+    QStringList         files;      //!< Capture files in index order
+    double              speed;      //!< Speed factor (1 = original timing)
+    QThread*            worker;     //!< Replay thread
+    QElapsedTimer       clock;      //!< Replay time base
+    std::atomic<bool>   running;
+    std::atomic<bool>   abortRequest;
+    std::atomic<quint64> injected;  //!< Frames injected
+    std::atomic<quint64> total;     //!< RX frames of the capture
+    std::atomic<quint64> stalls;    //!< Injections delayed by the ring full condition
+
+    latencyHistogram    pacing;     //!< Pacing error (us): written by the replay thread
+    latencyHistogram    noPacing;   //!< Empty histogram returned while the replay is running
+    latencyHistogram    pickup;     //!< Pickup delay (us): written by the driver
+
+    static QStringList captureFiles(const QString& capture); //!< Returns the files of a capture
+    void replayThread(void); //!< Replay thread body
+    void waitUntil(qint64 due); //!< Waits for a clock time
+};
+
+#endif // REPLAY_H
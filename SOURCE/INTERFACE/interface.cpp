@@ -18,6 +18,28 @@ uint Interface::handleReceivedCommand(QList<QString>* frame, QList<QString>* ans
 
     if(frame->at(2) == "GetRevision")  return GetRevision(answer);
     else if(frame->at(2) == "GetStatus")  return GetStatus(answer);
+    else if(frame->at(2) == "GetDeviceStatistics")  return GetDeviceStatistics(frame, answer);
+    else if(frame->at(2) == "ResetDeviceStatistics")  return ResetDeviceStatistics(answer);
+    else if(frame->at(2) == "GetSchedulerStatistics")  return GetSchedulerStatistics(answer);
+    else if(frame->at(2) == "ResetSchedulerStatistics")  return ResetSchedulerStatistics(answer);
+    else if(frame->at(2) == "GetDeadlineStatistics")  return GetDeadlineStatistics(answer);
+    else if(frame->at(2) == "SetSchedulerMode")  return SetSchedulerMode(frame, answer);
+    else if(frame->at(2) == "GetBusLoad")  return GetBusLoad(answer);
+    else if(frame->at(2) == "SetAdmissionControl")  return SetAdmissionControl(frame, answer);
+    else if(frame->at(2) == "GetRateStatistics")  return GetRateStatistics(answer);
+    else if(frame->at(2) == "GetLatencyStatistics")  return GetLatencyStatistics(frame, answer);
+    else if(frame->at(2) == "ResetLatencyStatistics")  return ResetLatencyStatistics(answer);
+    else if(frame->at(2) == "GetStatistics")  return GetStatistics(answer);
+    else if(frame->at(2) == "GetBusErrors")  return GetBusErrors(answer);
+    else if(frame->at(2) == "GetTickJitter")  return GetTickJitter(answer);
+    else if(frame->at(2) == "GetErrorStatistics")  return GetErrorStatistics(answer);
+    else if(frame->at(2) == "GetClientStatistics")  return GetClientStatistics(answer);
+    else if(frame->at(2) == "ResetStatistics")  return ResetStatistics(answer);
+    else if(frame->at(2) == "DumpFlightRecorder")  return DumpFlightRecorder(answer);
+    else if(frame->at(2) == "StartCapture")  return StartCapture(frame, answer);
+    else if(frame->at(2) == "StopCapture")  return StopCapture(answer);
+    else if(frame->at(2) == "GetCaptureStatus")  return GetCaptureStatus(answer);
+    else if(frame->at(2) == "GetReplayStatus")  return GetReplayStatus(answer);
     return 1;
 }
 
@@ -29,6 +51,26 @@ uint Interface::GetRevision( QList<QString>* answer){
     return 0;
 }
 
+/**
+ * @brief GetStatus
+ *
+ * Returns the status of the CAN device.
+ *
+ * The frame format is: <E SEQ GetStatus >
+ *
+ * @return
+ * - "status apiMaj apiMin apiSub hwSn hwRev hwSRev"
+ *
+ * Where status is:
+ *  - READY: the device is open;
+ *  - OPENING: the background open is running;
+ *  - OPEN_FAILED: the last open attempt failed and a retry is waiting;
+ *  - FAULT: the device is closed;
+ *
+ * The device fields are 0 if the device is not open.
+ *
+ * \ingroup InterfaceModule
+ */
 uint Interface::GetStatus( QList<QString>* answer){
     answer->clear();
 
@@ -42,7 +84,9 @@ uint Interface::GetStatus( QList<QString>* answer){
         answer->append(QString("%1").arg(CAN->getHWsrev()));
 
     }else{
-            answer->append("FAULT");
+            if(CAN->isOpening()) answer->append("OPENING");
+            else if(CAN->isOpenPending()) answer->append("OPEN_FAILED");
+            else answer->append("FAULT");
             answer->append("0");
             answer->append("0");
             answer->append("0");
@@ -53,3 +97,602 @@ uint Interface::GetStatus( QList<QString>* answer){
 
     return 0;
 }
+
+/**
+ * @brief GetDeviceStatistics
+ *
+ * Returns the Point to Point statistics of a remote device.
+ *
+ * The frame format is: <E SEQ GetDeviceStatistics devId >
+ *
+ * @param
+ *  - devId: the Device ID (canId & 0x3F).
+ *
+ * @return
+ * - "requests timeouts retries recovered failures late srtt rttvar tmo"
+ *
+ * Where:
+ *  - requests: requests sent to the device (first attempts);
+ *  - timeouts: answers not received in time (any attempt);
+ *  - retries: requests sent again after a timeout;
+ *  - recovered: requests answered after at least a new attempt;
+ *  - failures: timeouts notified to the Clients;
+ *  - late: answers received after the timeout;
+ *  - srtt: smoothed answer time in us;
+ *  - rttvar: answer time variance in us;
+ *  - tmo: current P2P timeout in ms;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetDeviceStatistics(QList<QString>* frame, QList<QString>* answer){
+    answer->clear();
+    if(frame->size() < 4) return 1;
+
+    bool ok;
+    uint devId = frame->at(3).toUInt(&ok);
+    if((!ok) || (devId >= canDriver::MAX_DEVICES)) return 1;
+
+    canDriver::deviceStatistics stat = CAN->getDeviceStatistics(devId);
+    answer->append(QString("%1").arg(stat.requests));
+    answer->append(QString("%1").arg(stat.timeouts));
+    answer->append(QString("%1").arg(stat.retries));
+    answer->append(QString("%1").arg(stat.recovered));
+    answer->append(QString("%1").arg(stat.failures));
+    answer->append(QString("%1").arg(stat.lateReplies));
+    answer->append(QString("%1").arg(stat.srtt));
+    answer->append(QString("%1").arg(stat.rttvar));
+    answer->append(QString("%1").arg(stat.tmo));
+    return 0;
+}
+
+/**
+ * @brief ResetDeviceStatistics
+ *
+ * Clears the Point to Point statistics of all the remote devices.
+ *
+ * The frame format is: <E SEQ ResetDeviceStatistics >
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::ResetDeviceStatistics( QList<QString>* answer){
+    answer->clear();
+    CAN->resetDeviceStatistics();
+    return 0;
+}
+
+/**
+ * @brief GetSchedulerStatistics
+ *
+ * Returns the queue waiting time statistics of every priority class.
+ *
+ * The frame format is: <E SEQ GetSchedulerStatistics >
+ *
+ * @return
+ * - "[class-0] [class-1] [class-2] [class-3]"
+ *
+ * Where every class block is:
+ *  - served: requests sent on the bus;
+ *  - avg: average queue waiting time in us;
+ *  - max: max queue waiting time in us;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetSchedulerStatistics( QList<QString>* answer){
+    answer->clear();
+
+    for(int i=0; i<_CLASS_NUM; i++){
+        Server::classStatistics stat = SERVER->getClassStatistics(i);
+        answer->append(QString("%1").arg(stat.served));
+        answer->append(QString("%1").arg((stat.served) ? stat.totWait / stat.served : 0));
+        answer->append(QString("%1").arg(stat.maxWait));
+    }
+    return 0;
+}
+
+/**
+ * @brief ResetSchedulerStatistics
+ *
+ * Clears the queue waiting time statistics of every priority class.
+ *
+ * The frame format is: <E SEQ ResetSchedulerStatistics >
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::ResetSchedulerStatistics( QList<QString>* answer){
+    answer->clear();
+    SERVER->resetClassStatistics();
+    return 0;
+}
+
+/**
+ * @brief GetDeadlineStatistics
+ *
+ * Returns the deadline statistics of every connected Client.
+ *
+ * The frame format is: <E SEQ GetDeadlineStatistics >
+ *
+ * @return
+ * - "[client-block] .. [client-block]"
+ *
+ * Where every client block is:
+ *  - id: the Client identifier;
+ *  - requests: requests received with a deadline;
+ *  - misses: requests discarded because of the deadline expiration;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetDeadlineStatistics( QList<QString>* answer){
+    answer->clear();
+    SERVER->getDeadlineStatistics(answer);
+    return 0;
+}
+
+/**
+ * @brief SetSchedulerMode
+ *
+ * Selects the scheduler working mode of the Client requests.
+ *
+ * The frame format is: <E SEQ SetSchedulerMode mode >
+ *
+ * @param
+ *  - mode: CLASS (priority class and weight, default) or CANID (canId priority, as the bus arbitration).
+ *
+ * @return
+ * - "mode": the current scheduler mode;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::SetSchedulerMode(QList<QString>* frame, QList<QString>* answer){
+    answer->clear();
+    if(frame->size() < 4) return 1;
+
+    if(frame->at(3) == "CLASS") SERVER->setSchedulerMode(_SCHED_CLASS);
+    else if(frame->at(3) == "CANID") SERVER->setSchedulerMode(_SCHED_CANID);
+    else return 1;
+
+    answer->append(frame->at(3));
+    return 0;
+}
+
+/**
+ * @brief GetBusLoad
+ *
+ * Returns the CAN bus load estimation.
+ *
+ * The frame format is: <E SEQ GetBusLoad >
+ *
+ * @return
+ * - "load100ms load1s load10s bitrate threshold class overload"
+ *
+ * Where:
+ *  - load100ms, load1s, load10s: bus load percentage of the last 100ms, 1s and 10s;
+ *  - bitrate: the configured bus bitrate (bit/s);
+ *  - threshold: the admission control threshold (0 = disabled);
+ *  - class: the first class throttled by the admission control;
+ *  - overload: scheduling slots with the admission control active;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetBusLoad( QList<QString>* answer){
+    answer->clear();
+    answer->append(QString::number(CAN->getBusLoad(100), 'f', 1));
+    answer->append(QString::number(CAN->getBusLoad(1000), 'f', 1));
+    answer->append(QString::number(CAN->getBusLoad(10000), 'f', 1));
+    answer->append(QString("%1").arg(CAN->getBitrate()));
+    answer->append(QString("%1").arg(SERVER->getAdmissionThreshold()));
+    answer->append(QString("%1").arg(SERVER->getAdmissionClass()));
+    answer->append(QString("%1").arg(SERVER->getOverloadSlots()));
+    return 0;
+}
+
+/**
+ * @brief SetAdmissionControl
+ *
+ * Configures the admission control of the Client requests.
+ *
+ * The frame format is: <E SEQ SetAdmissionControl threshold class >
+ *
+ * @param
+ *  - threshold: the bus load percentage activating the admission control (0 = disabled, max 100);
+ *  - class: the first throttled class (1 to 3): this class and the lower classes are throttled.
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::SetAdmissionControl(QList<QString>* frame, QList<QString>* answer){
+    answer->clear();
+    if(frame->size() < 5) return 1;
+
+    bool ok;
+    uint threshold = frame->at(3).toUInt(&ok);
+    if((!ok) || (threshold > 100)) return 1;
+    uint cls = frame->at(4).toUInt(&ok);
+    if((!ok) || (cls == _CLASS_CRITICAL) || (cls >= _CLASS_NUM)) return 1;
+
+    SERVER->setAdmissionControl(threshold, cls);
+    return 0;
+}
+
+/**
+ * @brief GetRateStatistics
+ *
+ * Returns the rate limit statistics of every connected Client (see the RATE Client option).
+ *
+ * The frame format is: <E SEQ GetRateStatistics >
+ *
+ * @return
+ * - "[client-block] .. [client-block]"
+ *
+ * Where every client block is:
+ *  - id: the Client identifier;
+ *  - fps: rate limit in requests per second (0 = no limit);
+ *  - burst: token bucket size;
+ *  - accepted: requests accepted;
+ *  - throttled: requests discarded by the rate limit;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetRateStatistics( QList<QString>* answer){
+    answer->clear();
+    SERVER->getRateStatistics(answer);
+    return 0;
+}
+
+/**
+ * @brief GetLatencyStatistics
+ *
+ * Returns the latency histogram of a Point to Point transaction stage
+ * (see the @ref latencyModule).
+ *
+ * The frame format is: <E SEQ GetLatencyStatistics stage [devId] >
+ * or: <E SEQ GetLatencyStatistics stage CLIENT clientId >
+ *
+ * @param
+ *  - stage: RX, QUEUE, DEVICE, REPLY or TOTAL;
+ *  - devId: optional Device ID (canId & 0x3F). If not present, all the devices are considered.
+ *  - clientId: identifier of a connected Client (see GetClientStatistics):
+ *    only the transactions of the Client are considered.
+ *
+ * @return
+ * - "count min avg p50 p90 p99 p999 max"
+ *
+ * Where all the times are in us.
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetLatencyStatistics(QList<QString>* frame, QList<QString>* answer){
+    answer->clear();
+    if(frame->size() < 4) return 1;
+
+    uchar stage;
+    if(frame->at(3) == "RX") stage = latencyStatistics::_STAGE_RX;
+    else if(frame->at(3) == "QUEUE") stage = latencyStatistics::_STAGE_QUEUE;
+    else if(frame->at(3) == "DEVICE") stage = latencyStatistics::_STAGE_DEVICE;
+    else if(frame->at(3) == "REPLY") stage = latencyStatistics::_STAGE_REPLY;
+    else if(frame->at(3) == "TOTAL") stage = latencyStatistics::_STAGE_TOTAL;
+    else return 1;
+
+    const latencyHistogram* histo = &CAN->getLatency().getHistogram(stage);
+    if((frame->size() >= 6) && (frame->at(4) == "CLIENT")){
+        bool ok;
+        uint clientId = frame->at(5).toUInt(&ok);
+        if(!ok) return 1;
+        histo = SERVER->getClientLatency(clientId, stage);
+        if(!histo) return 1;
+    }else if(frame->size() >= 5){
+        bool ok;
+        uint devId = frame->at(4).toUInt(&ok);
+        if((!ok) || (devId >= latencyStatistics::MAX_DEVICES)) return 1;
+        histo = &CAN->getLatency().getDeviceHistogram(devId, stage);
+    }
+
+    answer->append(QString("%1").arg(histo->getCount()));
+    answer->append(QString("%1").arg(histo->getMin()));
+    answer->append(QString("%1").arg(histo->getAvg()));
+    answer->append(QString("%1").arg(histo->getPercentile(50)));
+    answer->append(QString("%1").arg(histo->getPercentile(90)));
+    answer->append(QString("%1").arg(histo->getPercentile(99)));
+    answer->append(QString("%1").arg(histo->getPercentile(99.9)));
+    answer->append(QString("%1").arg(histo->getMax()));
+    return 0;
+}
+
+/**
+ * @brief ResetLatencyStatistics
+ *
+ * Clears the latency histograms of all the stages, devices and connected Clients.
+ *
+ * The frame format is: <E SEQ ResetLatencyStatistics >
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::ResetLatencyStatistics( QList<QString>* answer){
+    answer->clear();
+    CAN->getLatency().reset();
+    SERVER->resetClientLatency();
+    return 0;
+}
+
+/**
+ * @brief GetStatistics
+ *
+ * Returns the traffic counters of the Application.
+ *
+ * The frame format is: <E SEQ GetStatistics >
+ *
+ * @return
+ * - "rxFps txFps rx tx p2p answers timeouts late async clients queued retry"
+ *
+ * Where:
+ *  - rxFps, txFps: frames received and sent in the last second;
+ *  - rx, tx: frames received and sent;
+ *  - p2p: Point to Point requests sent (any attempt);
+ *  - answers: Point to Point answers received in time;
+ *  - timeouts: Point to Point answers not received in time;
+ *  - late: answers delivered after the timeout;
+ *  - async: frames forwarded as ASYNC frames;
+ *  - clients: connected Clients;
+ *  - queued: requests in the Client queues;
+ *  - retry: requests waiting for a new attempt;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetStatistics( QList<QString>* answer){
+    answer->clear();
+    const canDriver::driverCounters& cnt = CAN->getCounters();
+    answer->append(QString("%1").arg(cnt.rxFps.get()));
+    answer->append(QString("%1").arg(cnt.txFps.get()));
+    answer->append(QString("%1").arg(cnt.rxFrames.get()));
+    answer->append(QString("%1").arg(cnt.txFrames.get()));
+    answer->append(QString("%1").arg(cnt.p2pRequests.get()));
+    answer->append(QString("%1").arg(cnt.p2pAnswers.get()));
+    answer->append(QString("%1").arg(cnt.p2pTimeouts.get()));
+    answer->append(QString("%1").arg(cnt.lateAnswers.get()));
+    answer->append(QString("%1").arg(cnt.asyncFrames.get()));
+    answer->append(QString("%1").arg(SERVER->getClients()));
+    answer->append(QString("%1").arg(SERVER->getQueuedRequests()));
+    answer->append(QString("%1").arg(CAN->getRetryQueue()));
+    return 0;
+}
+
+/**
+ * @brief GetBusErrors
+ *
+ * Returns the CAN controller error conditions counters.
+ *
+ * The frame format is: <E SEQ GetBusErrors >
+ *
+ * @return
+ * - "bus passive warning overrun"
+ *
+ * Where:
+ *  - bus: Bus Error conditions;
+ *  - passive: Error Passive conditions;
+ *  - warning: Error Warning conditions;
+ *  - overrun: Data overrun and FIFO full conditions;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetBusErrors( QList<QString>* answer){
+    answer->clear();
+    const canDriver::driverCounters& cnt = CAN->getCounters();
+    answer->append(QString("%1").arg(cnt.busErrors.get()));
+    answer->append(QString("%1").arg(cnt.errPassive.get()));
+    answer->append(QString("%1").arg(cnt.errWarning.get()));
+    answer->append(QString("%1").arg(cnt.overruns.get()));
+    return 0;
+}
+
+/**
+ * @brief GetTickJitter
+ *
+ * Returns the jitter of the CAN driver scheduling tick (expected every 1ms).
+ *
+ * The frame format is: <E SEQ GetTickJitter >
+ *
+ * @return
+ * - "ticks avg max"
+ *
+ * Where:
+ *  - ticks: scheduling ticks;
+ *  - avg: average tick jitter in us;
+ *  - max: max tick jitter in us;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetTickJitter( QList<QString>* answer){
+    answer->clear();
+    const canDriver::driverCounters& cnt = CAN->getCounters();
+    quint64 ticks = cnt.ticks.get();
+    answer->append(QString("%1").arg(ticks));
+    answer->append(QString("%1").arg((ticks > 1) ? cnt.jitterSum.get() / (ticks - 1) : 0));
+    answer->append(QString("%1").arg(cnt.jitterMax.get()));
+    return 0;
+}
+
+/**
+ * @brief GetErrorStatistics
+ *
+ * Returns the request failures of every reason code
+ * (see the Error frame in the @ref interfaceModule).
+ *
+ * The frame format is: <E SEQ GetErrorStatistics >
+ *
+ * @return
+ * - "reason-1 reason-2 .. reason-N": failures of every reason code, starting from 1;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetErrorStatistics( QList<QString>* answer){
+    answer->clear();
+    for(int i=_CLIENT_ERR_TIMEOUT; i<_CLIENT_ERR_NUM; i++) answer->append(QString("%1").arg(SERVER->getErrorCount(i)));
+    return 0;
+}
+
+/**
+ * @brief GetClientStatistics
+ *
+ * Returns the diagnostic counters of every connected Client.
+ *
+ * The frame format is: <E SEQ GetClientStatistics >
+ *
+ * @return
+ * - "[client-block] .. [client-block]"
+ *
+ * Where every client block is:
+ *  - id: the Client identifier;
+ *  - class: the Client priority class;
+ *  - queue: requests in the Client queue;
+ *  - requests: requests accepted in the queue;
+ *  - drops: requests discarded before the queue;
+ *  - errors: request failures;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetClientStatistics( QList<QString>* answer){
+    answer->clear();
+    SERVER->getClientStatistics(answer);
+    return 0;
+}
+
+/**
+ * @brief ResetStatistics
+ *
+ * Clears the traffic, bus error, tick jitter, error and Client counters.
+ *
+ * The frame format is: <E SEQ ResetStatistics >
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::ResetStatistics( QList<QString>* answer){
+    answer->clear();
+    CAN->resetCounters();
+    SERVER->resetCounters();
+    return 0;
+}
+
+/**
+ * @brief DumpFlightRecorder
+ *
+ * Writes the flight recorder content in a new dump file (see the @ref flightrecorderModule).
+ * The file is written in background: the command fails if a dump is in progress.
+ *
+ * The frame format is: <E SEQ DumpFlightRecorder >
+ *
+ * @return
+ * - "filename": the dump file name;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::DumpFlightRecorder( QList<QString>* answer){
+    answer->clear();
+    QString filename = TRACE->dump();
+    if(filename.isEmpty()) return 1;
+    answer->append(filename);
+    return 0;
+}
+
+/**
+ * @brief StartCapture
+ *
+ * Starts a new binary capture of the bus traffic (see the @ref captureModule).
+ *
+ * The frame format is: <E SEQ StartCapture [name] >
+ *
+ * @param
+ *  - name: optional capture name (default: capture_yyyyMMdd_hhmmss);
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::StartCapture(QList<QString>* frame, QList<QString>* answer){
+    answer->clear();
+
+    QString name;
+    if(frame->size() > 3) name = frame->at(3);
+    else name = QString("capture_%1").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+
+    if(!CAPTURE->start(name, CAN->getBitrate())) return 1;
+    answer->append(CAPTURE->getName());
+    return 0;
+}
+
+/**
+ * @brief StopCapture
+ *
+ * Stops the current capture.
+ *
+ * The frame format is: <E SEQ StopCapture >
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::StopCapture( QList<QString>* answer){
+    answer->clear();
+    CAPTURE->stop();
+    return 0;
+}
+
+/**
+ * @brief GetCaptureStatus
+ *
+ * Returns the status of the capture.
+ *
+ * The frame format is: <E SEQ GetCaptureStatus >
+ *
+ * @return
+ * - "running files records dropped failed"
+ *
+ * Where:
+ *  - running: 1 if the capture is running;
+ *  - files: the number of files of the capture;
+ *  - records: the number of frames recorded;
+ *  - dropped: the number of frames discarded because the next file was not ready;
+ *  - failed: 1 if the capture has been stopped because the next file could not be created;
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetCaptureStatus( QList<QString>* answer){
+    answer->clear();
+    answer->append(QString("%1").arg(CAPTURE->isRunning() ? 1 : 0));
+    answer->append(QString("%1").arg(CAPTURE->getFiles()));
+    answer->append(QString("%1").arg(CAPTURE->getRecords()));
+    answer->append(QString("%1").arg(CAPTURE->getDropped()));
+    answer->append(QString("%1").arg(CAPTURE->isFailed() ? 1 : 0));
+    return 0;
+}
+
+/**
+ * @brief GetReplayStatus
+ *
+ * Returns the status and the timing report of the capture replay (see the @ref replayModule).
+ *
+ * The frame format is: <E SEQ GetReplayStatus >
+ *
+ * @return
+ * - "running injected total pacing-p50 pacing-p99 pacing-max pickup-p50 pickup-p99 pickup-max"
+ *
+ * Where:
+ *  - running: 1 if the replay is running;
+ *  - injected: the frames injected;
+ *  - total: the device frames of the capture;
+ *  - pacing: the injection time error (us), 0 until the replay has terminated;
+ *  - pickup: the delay between the injection and the driver reception (us);
+ *
+ * The command fails if the driver is not in replay mode.
+ *
+ * \ingroup InterfaceModule
+ */
+uint Interface::GetReplayStatus( QList<QString>* answer){
+    answer->clear();
+    canReplay* replay = CAN->getReplay();
+    if(!replay) return 1;
+
+    answer->append(QString("%1").arg(replay->isRunning() ? 1 : 0));
+    answer->append(QString("%1").arg(replay->getInjected()));
+    answer->append(QString("%1").arg(replay->getTotal()));
+    answer->append(QString("%1").arg(replay->getPacing().getPercentile(50)));
+    answer->append(QString("%1").arg(replay->getPacing().getPercentile(99)));
+    answer->append(QString("%1").arg(replay->getPacing().getMax()));
+    answer->append(QString("%1").arg(replay->getPickup().getPercentile(50)));
+    answer->append(QString("%1").arg(replay->getPickup().getPercentile(99)));
+    answer->append(QString("%1").arg(replay->getPickup().getMax()));
+    return 0;
+}
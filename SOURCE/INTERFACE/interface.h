@@ -70,6 +70,28 @@ private slots:
 private:
     uint GetRevision( QList<QString>* answer);
     uint GetStatus( QList<QString>* answer);
+    uint GetDeviceStatistics(QList<QString>* frame, QList<QString>* answer);
+    uint ResetDeviceStatistics( QList<QString>* answer);
+    uint GetSchedulerStatistics( QList<QString>* answer);
+    uint ResetSchedulerStatistics( QList<QString>* answer);
+    uint GetDeadlineStatistics( QList<QString>* answer);
+    uint SetSchedulerMode(QList<QString>* frame, QList<QString>* answer);
+    uint GetBusLoad( QList<QString>* answer);
+    uint SetAdmissionControl(QList<QString>* frame, QList<QString>* answer);
+    uint GetRateStatistics( QList<QString>* answer);
+    uint GetLatencyStatistics(QList<QString>* frame, QList<QString>* answer);
+    uint ResetLatencyStatistics( QList<QString>* answer);
+    uint GetStatistics( QList<QString>* answer);
+    uint GetBusErrors( QList<QString>* answer);
+    uint GetTickJitter( QList<QString>* answer);
+    uint GetErrorStatistics( QList<QString>* answer);
+    uint GetClientStatistics( QList<QString>* answer);
+    uint ResetStatistics( QList<QString>* answer);
+    uint DumpFlightRecorder( QList<QString>* answer);
+    uint StartCapture(QList<QString>* frame, QList<QString>* answer);
+    uint StopCapture( QList<QString>* answer);
+    uint GetCaptureStatus( QList<QString>* answer);
+    uint GetReplayStatus( QList<QString>* answer);
 
 
 };
@@ -0,0 +1,257 @@
+#include "asynclog.h"
+#include <QDebug>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+std::atomic<asyncLog::threadRing*> asyncLog::rings[asyncLog::MAX_THREADS];
+std::atomic<quint64> asyncLog::dropped(0);
+std::atomic<quint64> asyncLog::suppressed(0);
+std::atomic<bool>    asyncLog::running(false);
+QtMessageHandler     asyncLog::previous = nullptr;
+QThread*             asyncLog::worker = nullptr;
+QElapsedTimer        asyncLog::clock;
+
+/**
+ * @brief This function starts the logger
+ *
+ * The function shall be called after the installation of the handler
+ * writing the messages (appLog): that handler is called by the flush thread only.
+ */
+void asyncLog::start(void){
+    if(worker) return;
+
+    clock.start();
+    previous = qInstallMessageHandler(messageHandler);
+    running.store(true);
+    worker = QThread::create([](){ flushThread(); });
+    worker->start(QThread::LowPriority);
+}
+
+/**
+ * @brief This function writes the pending messages and stops the logger
+ *
+ * The previous message handler is installed again.
+ */
+void asyncLog::stop(void){
+    if(!worker) return;
+
+    running.store(false);
+    worker->wait();
+    delete worker;
+    worker = nullptr;
+
+    qInstallMessageHandler(previous);
+    flush();
+}
+
+/**
+ * @brief This function writes a formatted message
+ *
+ * The message is formatted in a stack buffer and queued:
+ * use the LOG_DEBUG(), LOG_INFO(), LOG_WARNING() and LOG_ERROR() macros.
+ *
+ * @param level: the message level
+ * @param format: printf format
+ */
+void asyncLog::write(_Level level, const char* format, ...){
+    char text[MSG_SIZE];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    if(length < 0) return;
+    if(length >= MSG_SIZE) length = MSG_SIZE - 1;
+
+    // Logger not started: synchronous output
+    if(!running.load(std::memory_order_relaxed)){
+        qDebug() << text;
+        return;
+    }
+
+    push(level, text, length);
+}
+
+/**
+ * @brief This function returns the ring of the calling thread
+ *
+ * The ring is allocated at the first message of the thread in a free slot:
+ * it is released when the thread terminates (see reclaim()).
+ *
+ * @return the ring, or nullptr if MAX_THREADS rings are already in use
+ */
+asyncLog::threadRing* asyncLog::localRing(void){
+    static thread_local ringOwner local;
+    if(local.ring) return local.ring;
+
+    threadRing* ring = new threadRing;
+    ring->head.store(0);
+    ring->tail.store(0);
+    ring->lastHash = 0;
+    ring->lastTime = -(RATE_WINDOW * 1000000) - 1;
+    ring->repeated = 0;
+    ring->released.store(false);
+
+    for(int i=0; i<MAX_THREADS; i++){
+        threadRing* expected = nullptr;
+        if(rings[i].compare_exchange_strong(expected, ring, std::memory_order_acq_rel)){
+            local.ring = ring;
+            return ring;
+        }
+    }
+
+    delete ring;
+    return nullptr;
+}
+
+/**
+ * @brief This function frees the rings of the terminated threads
+ *
+ * A ring is freed when its thread has terminated and all its messages
+ * have been written. The function is called by the flush thread only
+ * (the only reader of the rings).
+ */
+void asyncLog::reclaim(void){
+    for(int i=0; i<MAX_THREADS; i++){
+        threadRing* ring = rings[i].load(std::memory_order_acquire);
+        if(!ring) continue;
+        if(!ring->released.load(std::memory_order_acquire)) continue;
+        if(ring->tail.load(std::memory_order_relaxed) != ring->head.load(std::memory_order_acquire)) continue;
+
+        rings[i].store(nullptr, std::memory_order_release);
+        delete ring;
+    }
+}
+
+/**
+ * @brief This function queues a message in the ring of the calling thread
+ *
+ * A message identical to the last message of the thread within RATE_WINDOW is suppressed.
+ *
+ * @param level: the message level
+ * @param text: the message text
+ * @param length: the text length
+ */
+void asyncLog::push(_Level level, const char* text, int length){
+    threadRing* ring = localRing();
+    if(!ring){
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // FNV-1a hash of the text
+    uint hash = 2166136261u;
+    for(int i=0; i<length; i++) hash = (hash ^ (uchar) text[i]) * 16777619u;
+
+    qint64 now = clock.nsecsElapsed();
+    if((hash == ring->lastHash) && (now - ring->lastTime < RATE_WINDOW * 1000000)){
+        ring->repeated++;
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if(ring->repeated){
+        char note[64];
+        int n = snprintf(note, sizeof(note), "LAST MESSAGE REPEATED %u TIMES", ring->repeated);
+        enqueue(ring, level, note, n);
+        ring->repeated = 0;
+    }
+
+    ring->lastHash = hash;
+    ring->lastTime = now;
+    enqueue(ring, level, text, length);
+}
+
+void asyncLog::enqueue(threadRing* ring, _Level level, const char* text, int length){
+    uint h = ring->head.load(std::memory_order_relaxed);
+    if(h - ring->tail.load(std::memory_order_acquire) >= RING_SIZE){
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if(length > MSG_SIZE) length = MSG_SIZE;
+    logMessage* msg = &ring->ring[h & (RING_SIZE - 1)];
+    msg->time = clock.nsecsElapsed();
+    msg->level = level;
+    msg->length = length;
+    memcpy(msg->text, text, length);
+    ring->head.store(h + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Qt message handler
+ *
+ * The qDebug() messages are queued as the LOG_xx() messages.
+ * A fatal message stops the logger and it is written synchronously after the pending messages.
+ */
+void asyncLog::messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg){
+    if(type == QtFatalMsg){
+        QtMessageHandler handler = previous;
+        stop();
+        if(handler) handler(type, context, msg);
+        return;
+    }
+
+    _Level level = _LOG_DEBUG;
+    if(type == QtInfoMsg) level = _LOG_INFO;
+    else if(type == QtWarningMsg) level = _LOG_WARNING;
+    else if(type == QtCriticalMsg) level = _LOG_ERROR;
+
+    QByteArray text = msg.toUtf8();
+    push(level, text.constData(), (text.size() < MSG_SIZE) ? (int) text.size() : MSG_SIZE);
+}
+
+/**
+ * @brief This function writes the queued messages
+ *
+ * The messages of all the rings are written in time order.
+ *
+ * @return true if at least a message has been written
+ */
+bool asyncLog::flush(void){
+    static const QtMsgType types[] = {QtDebugMsg, QtInfoMsg, QtWarningMsg, QtCriticalMsg};
+    bool written = false;
+
+    for(;;){
+
+        // Oldest message of the rings
+        threadRing* oldest = nullptr;
+        logMessage* msg = nullptr;
+        for(int i=0; i<MAX_THREADS; i++){
+            threadRing* ring = rings[i].load(std::memory_order_acquire);
+            if(!ring) continue;
+            uint t = ring->tail.load(std::memory_order_relaxed);
+            if(t == ring->head.load(std::memory_order_acquire)) continue;
+            logMessage* m = &ring->ring[t & (RING_SIZE - 1)];
+            if((!msg) || (m->time < msg->time)){
+                oldest = ring;
+                msg = m;
+            }
+        }
+        if(!oldest){
+            reclaim();
+            return written;
+        }
+
+        QString text = QString::fromUtf8(msg->text, msg->length);
+        if(previous){
+            QMessageLogContext context;
+            previous(types[msg->level & 0x3], context, text);
+        }else fprintf(stderr, "%s\n", text.toLocal8Bit().constData());
+
+        oldest->tail.fetch_add(1, std::memory_order_release);
+        written = true;
+    }
+}
+
+/**
+ * @brief Flush thread body
+ */
+void asyncLog::flushThread(void){
+    while(running.load(std::memory_order_relaxed)){
+        flush();
+        QThread::msleep(FLUSH_MS);
+    }
+    flush();
+}
@@ -0,0 +1,151 @@
+#ifndef ASYNCLOG_H
+#define ASYNCLOG_H
+
+/*!
+ * \defgroup  asynclogModule Asynchronous Logger Module.
+ *
+ * This Module moves the writing of the debug messages out of the calling threads,
+ * so that a log message can never stall the CAN scheduling.
+ *
+ * # MESSAGE PATH
+ *
+ * - every thread writing a message gets its own lock-free single producer single consumer
+ *   ring of asyncLog::RING_SIZE messages (allocated at the first message of the thread);
+ * - when the thread terminates its ring is released: the flush thread writes the pending
+ *   messages and frees the ring slot, so the short living worker threads
+ *   don't exhaust the asyncLog::MAX_THREADS slots;
+ * - the message is copied in the ring (truncated to asyncLog::MSG_SIZE bytes):
+ *   if the ring is full the message is discarded and counted, the caller never waits;
+ * - a background thread reads the rings every asyncLog::FLUSH_MS ms, merges the messages
+ *   in time order and passes them to the message handler installed before asyncLog::start()
+ *   (the appLog file and the debug window).
+ *
+ * The messages written with qDebug() and the other Qt log functions are handled
+ * the same way, since asyncLog::start() installs the Qt message handler.
+ *
+ * # LEVELS
+ *
+ * The LOG_DEBUG(), LOG_INFO(), LOG_WARNING() and LOG_ERROR() macros format the message
+ * (printf syntax) in a stack buffer, without memory allocation.
+ * The macros of the levels lower than LOG_MIN_LEVEL are compiled out:
+ * the release build defines LOG_MIN_LEVEL=LOG_LEVEL_INFO (see the project file).
+ *
+ * # RATE LIMITING
+ *
+ * A message identical to the last message of the same thread, written within
+ * asyncLog::RATE_WINDOW ms, is suppressed and counted:
+ * the count is reported with a "LAST MESSAGE REPEATED n TIMES" message
+ * before the next message written.
+ */
+
+#include <QtGlobal>
+#include <QString>
+#include <QThread>
+#include <QElapsedTimer>
+#include <atomic>
+
+#define LOG_LEVEL_DEBUG     0
+#define LOG_LEVEL_INFO      1
+#define LOG_LEVEL_WARNING   2
+#define LOG_LEVEL_ERROR     3
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL       LOG_LEVEL_DEBUG
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...)      asyncLog::write(asyncLog::_LOG_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...)      do{}while(0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...)       asyncLog::write(asyncLog::_LOG_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...)       do{}while(0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(...)    asyncLog::write(asyncLog::_LOG_WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...)    do{}while(0)
+#endif
+
+#define LOG_ERROR(...)      asyncLog::write(asyncLog::_LOG_ERROR, __VA_ARGS__)
+
+/**
+ * @brief This class implements the asynchronous logger
+ *
+ * \ingroup asynclogModule
+ */
+class asyncLog
+{
+public:
+
+    /// This enumeration defines the message levels
+    typedef enum{
+        _LOG_DEBUG = LOG_LEVEL_DEBUG,
+        _LOG_INFO = LOG_LEVEL_INFO,
+        _LOG_WARNING = LOG_LEVEL_WARNING,
+        _LOG_ERROR = LOG_LEVEL_ERROR
+    }_Level;
+
+    static const int MSG_SIZE = 240;        //!< Max length of a message (bytes)
+    static const uint RING_SIZE = 256;      //!< Messages of a thread ring (power of 2)
+    static const int MAX_THREADS = 32;      //!< Max number of threads with a ring at the same time
+    static const int FLUSH_MS = 20;         //!< Flush period (ms)
+    static const qint64 RATE_WINDOW = 1000; //!< Suppression window of the repeated messages (ms)
+
+    static void start(void); //!< Installs the Qt message handler and starts the flush thread
+    static void stop(void); //!< Writes the pending messages and stops the flush thread
+
+    static void write(_Level level, const char* format, ...) Q_ATTRIBUTE_FORMAT_PRINTF(2, 3); //!< Writes a formatted message
+
+    inline static quint64 getDropped(void){return dropped.load(std::memory_order_relaxed);}
+    inline static quint64 getSuppressed(void){return suppressed.load(std::memory_order_relaxed);}
+
+private:
+
+    /// This is a queued message
+    typedef struct{
+        qint64  time;           //!< Message time (clock ns)
+        uchar   level;          //!< _Level
+        ushort  length;         //!< Text length
+        char    text[MSG_SIZE]; //!< Text (not terminated)
+    }logMessage;
+
+    /// This is the ring of a thread
+    typedef struct{
+        logMessage          ring[RING_SIZE];
+        std::atomic<uint>   head;       //!< Next slot written by the thread
+        std::atomic<uint>   tail;       //!< Next slot read by the flush thread
+        uint                lastHash;   //!< Hash of the last message written (thread side)
+        qint64              lastTime;   //!< Time of the last message written (clock ns)
+        uint                repeated;   //!< Messages suppressed since the last message written
+        std::atomic<bool>   released;   //!< The thread has terminated
+    }threadRing;
+
+    /// Owner of the ring of a thread: the ring is released when the thread terminates
+    struct ringOwner{
+        threadRing* ring = nullptr;
+        ~ringOwner(){ if(ring) ring->released.store(true, std::memory_order_release); }
+    };
+
+    static std::atomic<threadRing*> rings[MAX_THREADS]; //!< Rings of the threads (nullptr if the slot is free)
+    static std::atomic<quint64> dropped;    //!< Messages discarded (ring full)
+    static std::atomic<quint64> suppressed; //!< Repeated messages suppressed
+    static std::atomic<bool>    running;    //!< Flush thread running
+    static QtMessageHandler     previous;   //!< Handler writing the messages
+    static QThread*             worker;     //!< Flush thread
+    static QElapsedTimer        clock;      //!< Time base of the messages
+
+    static threadRing* localRing(void); //!< Returns the ring of the calling thread
+    static void push(_Level level, const char* text, int length); //!< Queues a message
+    static void enqueue(threadRing* ring, _Level level, const char* text, int length); //!< Copies a message in a ring
+    static void messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg); //!< Qt message handler
+    static void reclaim(void); //!< Frees the drained rings of the terminated threads
+    static bool flush(void); //!< Writes the queued messages
+    static void flushThread(void); //!< Flush thread body
+};
+
+#endif // ASYNCLOG_H
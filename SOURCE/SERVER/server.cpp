@@ -15,6 +15,16 @@ Server::Server(QString ipaddress, int port):QTcpServer()
     localip = QHostAddress(ipaddress);
     localport = port;
     idseq=0;
+    schedulerMode = _SCHED_CLASS;
+    admissionThreshold = 0;
+    admissionClass = _CLASS_LOW;
+    admitClasses = _CLASS_NUM;
+    jobCanId = -1;
+    overloadSlots = 0;
+    for(int i=0; i<_CLASS_NUM; i++) rrIndex[i] = 0;
+    resetClassStatistics();
+    startupReference = 0;
+    firstConnection = -1;
 
 }
 
@@ -75,6 +85,14 @@ void Server::incomingConnection(qintptr socketDescriptor)
     item->socket->setSocketOption(QAbstractSocket::LowDelayOption,1);
     socketList.append(item);
 
+    // Startup time measurement: time from the process start to the first accepted connection
+    if(firstConnection < 0){
+        QElapsedTimer now;
+        now.start();
+        firstConnection = now.msecsSinceReference() - startupReference;
+        LOG_INFO("SERVER: FIRST CONNECTION ACCEPTED %lld ms AFTER STARTUP", (long long) firstConnection);
+    }
+
 
     // Interface signal connection
     connect(item->socket,SIGNAL(readyRead()), item, SLOT(socketRxData()),Qt::UniqueConnection);
@@ -85,8 +103,22 @@ void Server::incomingConnection(qintptr socketDescriptor)
     connect(item->socket,SIGNAL(errorOccurred(QAbstractSocket::SocketError)),item,SLOT(socketError(QAbstractSocket::SocketError)),Qt::UniqueConnection);
 
     item->id = this->idseq++;
+    TRACE->record(flightRecorder::_FR_CLIENT_CONNECT, 0, item->id, 0);
     item->rxCanId = 0;
-    item->dataPresent = false;
+    item->retries = 0;
+    item->backoff = 0;
+    item->errorFrames = false;
+    item->priorityClass = _CLASS_NORMAL;
+    item->weight = 1;
+    item->deficit = 0;
+    item->deadlineCount = 0;
+    item->deadlineRequests = 0;
+    item->deadlineMisses = 0;
+    item->rateFps = 0;
+    item->rateBurst = 0;
+    item->rateTokens = 0;
+    item->rateAccepted = 0;
+    item->rateThrottled = 0;
     return;
  }
 
@@ -112,7 +144,8 @@ void ServerItem::socketError(QAbstractSocket::SocketError error)
  * This function is called whenever a Client disconnects.
  *
  * The function deletes the client socket structure \n
- * removing the client from the active Client connection queue.
+ * removing the client from the active Client connection queue,
+ * and discards the Client activities pending in the driver (see canDriver::cancelClient()).
  *
  * @param id: the client identifier
  */
@@ -122,6 +155,8 @@ void Server::disconnected(ushort id)
     for(int i =0; i < socketList.size(); i++ ){
         if(socketList[i]->id == id){
 
+            TRACE->record(flightRecorder::_FR_CLIENT_DISCONNECT, 0, id, 0);
+            CAN->cancelClient(id); // The bus is not held for a disconnected Client
             disconnect(socketList[i]);
             socketList[i]->socket->deleteLater();
             delete socketList[i];
@@ -156,6 +191,128 @@ ushort ServerItem::getItem(int* index, QByteArray* data, bool* data_ok){
     return 0;
 }
 
+/**
+ * @brief This function extracts a text token from the frame.
+ *
+ * @param index: the current position in the frame
+ * @param data: the frame content
+ * @return the token, or an empty string if no token is present
+ */
+QString ServerItem::getToken(int* index, QByteArray* data){
+    QString val;
+
+    for(; *index< data->size(); (*index)++) if(data->at(*index) != ' ') break; // Removes the spaces
+
+    for(; *index< data->size(); (*index)++){
+        if(data->at(*index) == ' ') return val;
+        val.append(data->at(*index));
+    }
+
+    // Non è terminato con uno spazio: errore
+    return QString();
+}
+
+/**
+ * @brief This function decodes the Client Option frame.
+ *
+ * See the CLIENT OPTION FRAME FORMAT in the @ref interfaceModule
+ *
+ * @param index: the position of the option name in the frame
+ * @param data: the pointer to the protocol frame to be decoded.
+ * @return true if the option has been accepted
+ */
+bool ServerItem::handleOptionFrame(int* index, QByteArray* data){
+    bool data_ok;
+    QString option = getToken(index, data);
+
+    if(option == "RETRY"){
+        ushort n = getItem(index, data, &data_ok);
+        if((!data_ok) || (n > MAX_RETRIES)) return false;
+        ushort tmo = getItem(index, data, &data_ok);
+        if(!data_ok) return false;
+
+        retries = n;
+        backoff = tmo;
+        LOG_DEBUG("CLIENT OPTION: RETRY=%u BACKOFF=%ums", (uint) retries, (uint) backoff);
+        return true;
+    }
+
+    if(option == "ERRORS"){
+        ushort enable = getItem(index, data, &data_ok);
+        if((!data_ok) || (enable > 1)) return false;
+
+        errorFrames = (enable == 1);
+        LOG_DEBUG("CLIENT OPTION: ERRORS=%u", (uint) enable);
+        return true;
+    }
+
+    if(option == "CLASS"){
+        ushort cls = getItem(index, data, &data_ok);
+        if((!data_ok) || (cls >= _CLASS_NUM)) return false;
+
+        priorityClass = cls;
+        deficit = 0;
+        LOG_DEBUG("CLIENT OPTION: CLASS=%u", (uint) priorityClass);
+        return true;
+    }
+
+    if(option == "WEIGHT"){
+        ushort w = getItem(index, data, &data_ok);
+        if((!data_ok) || (w == 0) || (w > 255)) return false;
+
+        weight = w;
+        LOG_DEBUG("CLIENT OPTION: WEIGHT=%u", (uint) weight);
+        return true;
+    }
+
+    if(option == "RATE"){
+        ushort fps = getItem(index, data, &data_ok);
+        if(!data_ok) return false;
+        ushort burst = getItem(index, data, &data_ok);
+        if((!data_ok) || (burst > MAX_RATE_BURST)) return false;
+        if((fps) && (!burst)) return false;
+
+        rateFps = fps;
+        rateBurst = burst;
+        rateTokens = burst;
+        rateTimer.start();
+        LOG_DEBUG("CLIENT OPTION: RATE=%ufps BURST=%u", (uint) rateFps, (uint) rateBurst);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief This function verifies the Client rate limit (RATE option)
+ *
+ * The token bucket is refilled with rateFps tokens per second, up to rateBurst tokens:
+ * every accepted request takes a token.
+ *
+ * The function shall be called only for a valid request that is going to be queued.
+ *
+ * @return true if the request can be accepted
+ */
+bool ServerItem::rateAdmit(void){
+    if(!rateFps){
+        rateAccepted++;
+        return true;
+    }
+
+    rateTokens += (double) rateTimer.nsecsElapsed() * rateFps / 1000000000.0;
+    rateTimer.start();
+    if(rateTokens > rateBurst) rateTokens = rateBurst;
+
+    if(rateTokens < 1){
+        rateThrottled++;
+        return false;
+    }
+
+    rateTokens -= 1;
+    rateAccepted++;
+    return true;
+}
+
 /**
  * This function decodes a single frame received from the Client.
  *
@@ -171,38 +328,29 @@ ushort ServerItem::getItem(int* index, QByteArray* data, bool* data_ok){
 void ServerItem::handleSocketFrame(QByteArray* data){
 
     QByteArray frame;
-    bool is_register;
-    bool is_valid;
+    char frame_type;
     int i;
     bool data_ok;
 
 
-    is_valid = false;
+    frame_type = 0;
     for(i=0; i< data->size(); i++){
         if(data->at(i)== ' ') continue;
-        if(data->at(i)== 'F') {
-            is_register = true;
-            is_valid = true;
-            i++;
-            break;
-        }
-
-        if(data->at(i)== 'D') {
-            is_register = false;
-            is_valid = true;
+        if((data->at(i)== 'F') || (data->at(i)== 'D') || (data->at(i)== 'T') || (data->at(i)== 'B') || (data->at(i)== 'O')) {
+            frame_type = data->at(i);
             i++;
             break;
         }
     }
-    if(!is_valid) return;
+    if(!frame_type) return;
 
-    if(is_register){// Can Registering Frame: set the reception mask and address
+    if(frame_type == 'F'){// Can Registering Frame: set the reception mask and address
 
 
         rxCanId = getItem(&i, data, &data_ok);
         if(!data_ok){
             rxCanId = 0;
-            qDebug() << "CLIENT REGISTRATION TO A DEVICE FAILED: WRONG DEVICE FORMAT";
+            LOG_WARNING("CLIENT REGISTRATION TO A DEVICE FAILED: WRONG DEVICE FORMAT");
             return;
         }
 
@@ -211,36 +359,205 @@ void ServerItem::handleSocketFrame(QByteArray* data){
         frame.append(">");
         emit sendToClient(frame);
 
-        qDebug() << QString("CLIENT REGISTERED FOR RECEPTION TO ADDR=0x%1").arg(rxCanId,1,16);
+        LOG_DEBUG("CLIENT REGISTERED FOR RECEPTION TO ADDR=0x%x", (uint) rxCanId);
+        return;
+
+    }else if(frame_type == 'O'){// Client Option Frame
+
+        if(!handleOptionFrame(&i, data)){
+            LOG_WARNING("CLIENT OPTION FAILED: WRONG OPTION FORMAT");
+            return;
+        }
+
+        frame.append("<");
+        frame.append(*data);
+        frame.append(">");
+        emit sendToClient(frame);
         return;
 
     }else{
 
-        // A data is waiting to be sent
-        if(dataPresent) return;
+        canTxRequest request;
+        request.timer.start();
+        request.hasSeq = false;
+        request.seq = 0;
+        request.hasDeadline = false;
+        request.deadline = 0;
+        request.tEnqueue = 0;
+        request.tWrite = 0;
+        request.tReply = 0;
+
+        // Optional attributes preceding the canId
+        if(!getAttributes(&i, data, &request)) return;
 
         frame.clear();
         ushort canid = getItem(&i, data, &data_ok);
         if(!data_ok) return;
+        request.txCanId = canid;
+
+        // The Client queue is full
+        if(txQueue.size() >= MAX_QUEUE_DEPTH){
+            sendErrorFrame(&request, _CLIENT_ERR_QUEUE_FULL);
+            return;
+        }
+
+        // The Bulk transfer frame carries the job descriptor before the data block
+        if(frame_type == 'B'){
+            ushort param[5];
+            for(int k=0; k<5; k++){
+                param[k] = getItem(&i, data, &data_ok);
+                if(!data_ok) return;
+            }
+
+            // The segSize, window, ackEvery and ackCode fields are 8 bit values
+            if((param[1] > 0xFF) || (param[2] > 0xFF) || (param[3] > 0xFF) || (param[4] > 0xFF)){
+                SERVER->bulkCompletedHandle(id, canid, bulkTransfer::_BULK_INVALID, 0, 0, 0);
+                return;
+            }
+
+            request.job.reqCanId = canid;
+            request.job.ackCanId = param[0];
+            request.job.segSize = param[1];
+            request.job.window = param[2];
+            request.job.ackEvery = param[3];
+            request.job.ackCode = param[4];
+        }
+
+        // The ISO-TP and Bulk frames can carry more than 8 bytes
+        uint max_len = 8;
+        if(frame_type == 'T') max_len = isoTp::MAX_PAYLOAD;
+        else if(frame_type == 'B') max_len = bulkTransfer::MAX_PAYLOAD;
 
         ushort val;
-        for(; (i< data->size()) && (frame.size() <= 8) ; i++){
+        for(; (i< data->size()) && ((uint) frame.size() < max_len) ; i++){
             val = getItem(&i, data, &data_ok);
             if(data_ok) frame.append((unsigned char) val);
             else break;
         }
 
+        // The ISO-TP and Bulk payloads exceeding max_len are rejected (the D frame is truncated)
+        if((frame_type != 'D') && ((uint) frame.size() >= max_len)){
+            getItem(&i, data, &data_ok);
+            if(data_ok){
+                LOG_WARNING("CLIENT %u: %c FRAME EXCEEDING %u BYTES REJECTED", (uint) id, frame_type, max_len);
+                sendErrorFrame(&request, _CLIENT_ERR_PROTOCOL);
+                return;
+            }
+        }
+
         // If a valid set of data has been identified they will be sent to the driver        
         if(frame.size()){
-            txCanId = canid;
-            txData = frame;
-            dataPresent = true;
+            if(frame_type == 'T') request.type = _TX_ISOTP_FRAME;
+            else if(frame_type == 'B') request.type = _TX_BULK_FRAME;
+            else request.type = _TX_P2P_FRAME;
+
+            // While the device is opening the request is queued and served when the scheduling starts;
+            // with the device closed it is answered as a failed request
+            if((!CAN->isDeviceOpen()) && (!CAN->isOpenPending())){
+                notOpenHandle(&request);
+                return;
+            }
+
+            // The Client exceeds its rate limit: the token is taken only by an accepted request
+            if(!rateAdmit()){
+                sendErrorFrame(&request, _CLIENT_ERR_THROTTLED);
+                return;
+            }
+
+            request.data = frame;
+            if(request.hasDeadline){
+                deadlineCount++;
+                deadlineRequests++;
+            }
+            request.tEnqueue = request.timer.nsecsElapsed();
+            txQueue.enqueue(request);
+            requests.inc();
             //emit sendToCan(canid,frame);
         }
     }
 
 }
 
+/**
+ * @brief This function decodes the optional attributes of a request frame.
+ *
+ * The attributes precede the canId and are identified by a prefix character:
+ * - \#seq: the sequence number echoed in the answer frames;
+ * - \@deadline: the relative deadline in ms;
+ *
+ * @param index: the current position in the frame
+ * @param data: the frame content
+ * @param request: the request to be updated
+ * @return false in case of wrong attribute format
+ */
+bool ServerItem::getAttributes(int* index, QByteArray* data, canTxRequest* request){
+    bool data_ok;
+
+    while(true){
+        for(; *index< data->size(); (*index)++) if(data->at(*index) != ' ') break; // Removes the spaces
+        if(*index >= data->size()) return true;
+
+        if(data->at(*index) == '#'){
+            (*index)++;
+            request->seq = getItem(index, data, &data_ok);
+            if(!data_ok) return false;
+            request->hasSeq = true;
+            continue;
+        }
+
+        if(data->at(*index) == '@'){
+            (*index)++;
+            request->deadline = getItem(index, data, &data_ok);
+            if(!data_ok) return false;
+            request->hasDeadline = true;
+            continue;
+        }
+
+        return true;
+    }
+}
+
+/**
+ * @brief This function sends an Error frame to the Client.
+ *
+ * The frame is sent only if the Client enabled the ERRORS option,
+ * except the rate limit notification (sent to every Client enabling the RATE option).
+ *
+ * @param request: this is the failed request
+ * @param reason: this is the failure reason code
+ */
+void ServerItem::sendErrorFrame(const canTxRequest* request, _ClientErrorCode reason){
+    drops.inc();
+    errors.inc();
+    SERVER->countError(reason);
+    if((!errorFrames) && (reason != _CLIENT_ERR_THROTTLED)) return;
+    emit sendToClient(QString("<E %1%2 %3 %4 > \n\r").arg(Server::seqTag(request)).arg(request->txCanId).arg((int) reason).arg(request->timer.nsecsElapsed() / 1000).toLatin1());
+}
+
+/**
+ * @brief This function answers a request received with the CAN device closed
+ *
+ * The request is answered as a failed request (see Server::rxErrorHandle()):
+ * also without the ERRORS option the Client receives the legacy failure frame.
+ * A Bulk request is answered with the rejected completion frame.
+ *
+ * @param request: this is the Client request
+ */
+void ServerItem::notOpenHandle(canTxRequest* request){
+    drops.inc();
+    request->rxCanId = rxCanId;
+    request->clientId = id;
+
+    if(request->type == _TX_BULK_FRAME){
+        errors.inc();
+        SERVER->countError(_CLIENT_ERR_NOT_OPEN);
+        SERVER->bulkCompletedHandle(id, request->txCanId, bulkTransfer::_BULK_REJECTED, 0, 0, 0);
+        return;
+    }
+
+    SERVER->rxErrorHandle(request, rxCanId, _CLIENT_ERR_NOT_OPEN);
+}
+
 /**
  * This callback is called whenever a data stream is received
  * from a connected Client.
@@ -252,25 +569,34 @@ void ServerItem::handleSocketFrame(QByteArray* data){
  */
 void ServerItem::socketRxData()
 {
-    QByteArray frame;    
-
     if(socket->bytesAvailable()==0) return;
     QByteArray data = socket->readAll();
 
 
 
-    // Identifies all the possible frames in the received stream
+    // Identifies all the possible frames in the received stream:
+    // a long frame (ISO-TP) can be received with more data streams.
+    // A frame longer than MAX_RX_FRAME is discarded up to the next frame start.
     for(int i=0; i<data.size(); i++){
         if(data.at(i) == '<') {
-            frame.clear();
+            rxFrame.clear();
+            rxOverflow = false;
         }else if(data.at(i) == '>'){
-            if(frame.size() > 4) {
-                frame.append(' ');
-                handleSocketFrame(&frame);
-                frame.clear();
+            if((rxFrame.size() > 4) && (!rxOverflow)) {
+                rxFrame.append(' ');
+                handleSocketFrame(&rxFrame);
             }
-        }else{
-            frame.append(data.at(i));
+            rxFrame.clear();
+            rxOverflow = false;
+        }else if(!rxOverflow){
+            if(rxFrame.size() >= MAX_RX_FRAME){
+                LOG_WARNING("CLIENT %u: FRAME EXCEEDING %d BYTES DISCARDED", (uint) id, MAX_RX_FRAME);
+                rxFrame.clear();
+                rxOverflow = true;
+                drops.inc();
+                continue;
+            }
+            rxFrame.append(data.at(i));
         }
     }
 
@@ -299,15 +625,42 @@ void ServerItem::socketTxData(QByteArray data)
  * or with the broadcast address (0).
  *
  * The Data is put in the socket packet as for the protocol:\n
- * <D> (uchar) b0 .. (uchar) b7
+ * <D> [#seq] canId (uchar) b0 .. (uchar) b7
  *
  *
+ * @param request: this is the Client request
  * @param canId: this is the canId of the can message
  * @param data: this is the data content of the frame
  */
-void Server::rxCanFrameHandle(ushort client_id, ushort canId, QByteArray* data){
+void Server::rxCanFrameHandle(const canTxRequest* request, ushort canId, QByteArray* data){
     QByteArray frame;
     frame.append("<D ");
+    frame.append(seqTag(request).toLatin1());
+    frame.append(QString("%1 ").arg(canId).toLatin1());
+
+    for(int i=0; i< 8;i++){
+        if(i >= data->size()) frame.append("0 ");
+        else frame.append(QString("%1 ").arg((uchar) data->at(i)).toLatin1());
+    }
+    frame += " > \n\r";
+
+    clientWrite(request->clientId, frame);
+}
+
+/**
+ * @brief This function sends a late device answer to the requesting Client.
+ *
+ * The Data is put in the socket packet as for the protocol:\n
+ * <L [#seq] canId (uchar) b0 .. (uchar) b7 >
+ *
+ * @param request: this is the expired Client request
+ * @param canId: this is the canId of the can message
+ * @param data: this is the data content of the frame
+ */
+void Server::rxLateFrameHandle(const canTxRequest* request, ushort canId, QByteArray* data){
+    QByteArray frame;
+    frame.append("<L ");
+    frame.append(seqTag(request).toLatin1());
     frame.append(QString("%1 ").arg(canId).toLatin1());
 
     for(int i=0; i< 8;i++){
@@ -316,14 +669,132 @@ void Server::rxCanFrameHandle(ushort client_id, ushort canId, QByteArray* data){
     }
     frame += " > \n\r";
 
-    // Sends to all the client matching the Receprion Acceptance filter
+    clientWrite(request->clientId, frame);
+}
+
+/**
+ * @brief This function sends the ISO-TP device response to the requesting Client.
+ *
+ * The Data is put in the socket packet as for the protocol:\n
+ * <T [#seq] canId (uchar) b0 .. (uchar) bn >
+ *
+ * In case of transaction error, the data content is empty.
+ *
+ * @param request: this is the Client request
+ * @param canId: this is the canId of the device response
+ * @param data: this is the whole response payload
+ */
+void Server::rxIsoTpFrameHandle(const canTxRequest* request, ushort canId, const QByteArray* data){
+    QByteArray frame;
+    frame.reserve(16 + data->size() * 4);
+    frame.append("<T ");
+    frame.append(seqTag(request).toLatin1());
+    frame.append(QString("%1 ").arg(canId).toLatin1());
+
+    for(int i=0; i< data->size();i++){
+        frame.append(QString("%1 ").arg((uchar) data->at(i)).toLatin1());
+    }
+    frame += " > \n\r";
+
+    clientWrite(request->clientId, frame);
+}
+
+/**
+ * @brief This function notifies a request failure to the requesting Client.
+ *
+ * If the Client enabled the ERRORS option, the failure is notified with the frame:\n
+ * <E [#seq] canId reason elapsed >
+ *
+ * Otherwise the legacy notification is used:
+ * - D request: <D canId 0 0 0 0 0 0 0 0 >;
+ * - T request: <T canId >;
+ *
+ * @param request: this is the failed request
+ * @param canId: this is the canId of the expected answer
+ * @param reason: this is the failure reason code
+ */
+void Server::rxErrorHandle(const canTxRequest* request, ushort canId, _ClientErrorCode reason){
+
+    countError(reason);
+
+    for(int i =0; i< socketList.size(); i++){
+        if(socketList[i]->id != request->clientId) continue;
+
+        socketList[i]->errors.inc();
+        if(socketList[i]->errorFrames){
+            clientWrite(request->clientId, QString("<E %1%2 %3 %4 > \n\r").arg(seqTag(request)).arg(canId).arg((int) reason).arg(request->timer.nsecsElapsed() / 1000).toLatin1());
+        }else if(request->type == _TX_P2P_FRAME){
+            QByteArray zero(8, 0);
+            rxCanFrameHandle(request, canId, &zero);
+        }else if(request->type == _TX_ISOTP_FRAME){
+            QByteArray empty;
+            rxIsoTpFrameHandle(request, canId, &empty);
+        }
+        return;
+    }
+}
+
+/**
+ * @brief This function returns the sequence number tag of a request.
+ *
+ * @param request: this is the Client request
+ * @return "#seq " if the request has a sequence number, an empty string otherwise
+ */
+QString Server::seqTag(const canTxRequest* request){
+    if(!request->hasSeq) return QString();
+    return QString("#%1 ").arg(request->seq);
+}
+
+/**
+ * @brief This function notifies the Bulk transfer progress to the requesting Client.
+ *
+ * The frame format is:\n
+ * <P canId acknowledged_bytes total_bytes >
+ *
+ * @param client_id: this is the identifier of the requesting client
+ * @param canId: this is the canId of the segment frames
+ * @param ackBytes: this is the number of bytes acknowledged by the device
+ * @param totalBytes: this is the data block length
+ */
+void Server::bulkProgressHandle(ushort client_id, ushort canId, uint ackBytes, uint totalBytes){
+    QByteArray frame;
+    frame.append(QString("<P %1 %2 %3 > \n\r").arg(canId).arg(ackBytes).arg(totalBytes).toLatin1());
+    clientWrite(client_id, frame);
+}
+
+/**
+ * @brief This function notifies the Bulk transfer completion to the requesting Client.
+ *
+ * The frame format is:\n
+ * <B canId result elapsed_ms segments retransmissions >
+ *
+ * @param client_id: this is the identifier of the requesting client
+ * @param canId: this is the canId of the segment frames
+ * @param result: this is the job result (see bulkTransfer::_Result)
+ * @param elapsed: this is the job duration in ms
+ * @param segments: this is the number of segments of the data block
+ * @param retransmissions: this is the number of retransmitted segments
+ */
+void Server::bulkCompletedHandle(ushort client_id, ushort canId, uint result, qint64 elapsed, uint segments, uint retransmissions){
+    QByteArray frame;
+    frame.append(QString("<B %1 %2 %3 %4 %5 > \n\r").arg(canId).arg(result).arg(elapsed).arg(segments).arg(retransmissions).toLatin1());
+    clientWrite(client_id, frame);
+}
+
+/**
+ * @brief This function writes a frame to the socket of a given Client.
+ *
+ * @param client_id: this is the identifier of the destination client
+ * @param frame: this is the frame content
+ */
+void Server::clientWrite(ushort client_id, const QByteArray& frame){
     for(int i =0; i< socketList.size(); i++){
         if(socketList[i]->id == client_id){
             socketList[i]->socket->write(frame);
             socketList[i]->socket->waitForBytesWritten(100);
+            return;
         }
     }
-
 }
 
 /**
@@ -361,25 +832,423 @@ void Server::rxAsyncCanFrameHandle(ushort canId, QByteArray* data){
 
 }
 
-bool Server::getNextTxFrame(ushort* client_id, uint16_t* pRxCanId, uint16_t* pTxCanId,  QByteArray* pdata){
-    static uint8_t idx =0;
+/**
+ * @brief This function returns the next request to be sent on the CAN bus.
+ *
+ * The requests whose deadline is expired are discarded, see Server::expireDeadlines().
+ *
+ * The requests are selected following the scheduler mode:
+ * - _SCHED_CLASS: the priority class is selected with Server::selectClass();
+ *   inside the selected class the Clients whose first request has a deadline are served
+ *   Earliest Deadline First (see Server::selectDeadlineClient()), the other Clients with Deficit Round Robin;
+ * - _SCHED_CANID: the Client is selected with Server::selectCanIdClient();
+ *
+ * A Client queue is always served in order: only the first request of a queue can be selected.
+ *
+ * While the bus is overloaded (see Server::setAdmissionControl()),
+ * the Clients of the throttled classes are not served.
+ *
+ * While the driver runs an ISO-TP transaction or a Bulk job, only the Point to Point requests
+ * can be interleaved: the Clients whose first request is not a Point to Point request,
+ * or whose answer canId is the job canId, are not served.
+ *
+ * @param request: pointer to the request to be filled
+ * @param jobRxCanId: the device canId of the running job, -1 if no job is running
+ * @return true if a request is present
+ */
+bool Server::getNextTxFrame(canTxRequest* request, int jobRxCanId){
+
+    jobCanId = jobRxCanId;
+
+    // Admission control: the lower classes are not served while the bus is overloaded
+    admitClasses = _CLASS_NUM;
+    if((admissionThreshold) && (CAN->getBusLoad(ADMISSION_WINDOW) >= admissionThreshold)){
+        admitClasses = admissionClass;
+        overloadSlots++;
+    }
+
+    // The requests that can no longer meet their deadline are discarded
+    expireDeadlines();
+
+    int idx;
+    int cls;
+
+    if(schedulerMode == _SCHED_CANID){
+        idx = selectCanIdClient();
+        if(idx < 0) return false;
+        cls = socketList[idx]->priorityClass;
+    }else{
+        cls = selectClass();
+        if(cls < 0) return false;
+
+        // Inside the class the requests with a deadline have the priority
+        idx = selectDeadlineClient(cls);
+        if(idx < 0) idx = selectClient(cls);
+        if(idx < 0) return false;
+    }
+
+    *request = socketList[idx]->txQueue.dequeue();
+    setRequestClient(socketList[idx], request);
+    if(request->hasDeadline) socketList[idx]->deadlineCount--;
+
+    // Scheduling statistics
+    qint64 wait = request->timer.nsecsElapsed() / 1000;
+    classStats[cls].served++;
+    classStats[cls].totWait += wait;
+    if(wait > classStats[cls].maxWait) classStats[cls].maxWait = wait;
+    return true;
+}
+
+/**
+ * @brief This function verifies if a Client can be served in the current slot
+ *
+ * @param item: the Client
+ * @return true if the Client has a request that can be sent
+ */
+bool Server::isServed(ServerItem* item){
+    if(item->txQueue.isEmpty()) return false;
+    if(item->priorityClass >= admitClasses) return false;
+    if(jobCanId < 0) return true;
+
+    // A job is running: only the Point to Point requests not answered with the job canId
+    return (item->txQueue.head().type == _TX_P2P_FRAME) && (item->rxCanId != jobCanId);
+}
+
+/**
+ * @brief This function verifies if a CRITICAL Client has a request waiting
+ *
+ * The function is called by the driver while a job is running,
+ * to interleave the CRITICAL requests with the job slots.
+ *
+ * @param jobRxCanId: the device canId of the running job
+ * @return true if a CRITICAL Point to Point request can be sent
+ */
+bool Server::isCriticalWaiting(int jobRxCanId){
+    for(int i =0; i< socketList.size(); i++){
+        ServerItem* item = socketList[i];
+        if((item->priorityClass != _CLASS_CRITICAL) || (item->txQueue.isEmpty())) continue;
+        if((item->txQueue.head().type == _TX_P2P_FRAME) && (item->rxCanId != jobRxCanId)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief This function sets the admission control
+ *
+ * @param threshold: the bus load percentage activating the admission control (0 = disabled)
+ * @param cls: the first throttled class: this class and the lower classes are throttled
+ */
+void Server::setAdmissionControl(uint threshold, uchar cls){
+    admissionThreshold = threshold;
+    admissionClass = cls;
+    overloadSlots = 0;
+}
+
+/**
+ * @brief This function selects the priority class to be served.
+ *
+ * The class is selected with strict priority and aging:
+ * - the effective priority of a class is its class number, decreased by one
+ *   every AGING_STEP ms its oldest request is waiting;
+ * - the class with the lowest effective priority is served
+ *   (in case of equal value, the class with the higher priority);
+ *
+ * @return the selected class or -1 if no request is present
+ */
+int Server::selectClass(void){
+    qint64 oldest[_CLASS_NUM];
+    for(int c=0; c<_CLASS_NUM; c++) oldest[c] = -1;
 
+    // Finds the oldest request waiting in every class
+    for(int i =0; i< socketList.size(); i++){
+        if(!isServed(socketList[i])) continue;
+        qint64 wait = socketList[i]->txQueue.head().timer.elapsed();
+        uchar cls = socketList[i]->priorityClass;
+        if(wait > oldest[cls]) oldest[cls] = wait;
+    }
+
+    int cls = -1;
+    qint64 best = 0;
+    for(int c=0; c<_CLASS_NUM; c++){
+        if(oldest[c] < 0) continue;
+        qint64 priority = c - oldest[c] / AGING_STEP;
+        if((cls < 0) || (priority < best)){
+            cls = c;
+            best = priority;
+        }
+    }
+    return cls;
+}
+
+/**
+ * @brief This function selects the Client with the highest priority canId.
+ *
+ * The first request of every Client queue is compared:
+ * the effective priority is the request canId, lowered by CANID_AGING_DELTA
+ * every CANID_AGING_STEP ms the request waits in the queue.
+ *
+ * @return the index of the selected Client or -1 if no request is present
+ */
+int Server::selectCanIdClient(void){
+    int idx = -1;
+    qint64 best = 0;
 
     for(int i =0; i< socketList.size(); i++){
-        if(idx >= socketList.size()) idx = 0;
-
-        if(socketList[idx]->dataPresent){
-            *pTxCanId = (socketList[idx]->txCanId);
-            *pRxCanId = (socketList[idx]->rxCanId);
-            *pdata =  (socketList[idx]->txData);
-            *client_id = socketList[idx]->id;
-            socketList[idx]->dataPresent = false;
-            idx++;
-            return true;
+        if(!isServed(socketList[i])) continue;
+        const canTxRequest& head = socketList[i]->txQueue.head();
+        qint64 priority = (qint64) head.txCanId - (head.timer.elapsed() / CANID_AGING_STEP) * CANID_AGING_DELTA;
+        if((idx < 0) || (priority < best)){
+            idx = i;
+            best = priority;
         }
-        idx++;
     }
+    return idx;
+}
 
-    return false;
+/**
+ * @brief This function assigns the Client parameters to a request
+ *
+ * @param item: this is the Client
+ * @param request: this is the request extracted from the Client queue
+ */
+void Server::setRequestClient(ServerItem* item, canTxRequest* request){
+    request->rxCanId = item->rxCanId;
+    request->clientId = item->id;
+    request->retries = item->retries;
+    request->backoff = item->backoff;
+}
+
+/**
+ * @brief This function discards the requests whose deadline is expired.
+ *
+ * The requests with a deadline, in all the Client queues, that can no longer
+ * meet their deadline are removed from the queue and notified to the Client
+ * with the Error frame (the order of the other requests is not changed).
+ */
+void Server::expireDeadlines(void){
+    for(int i =0; i< socketList.size(); i++){
+        ServerItem* item = socketList[i];
+        if(!item->deadlineCount) continue;
+
+        for(int j=0; j<item->txQueue.size(); j++){
+            if(!item->txQueue[j].hasDeadline) continue;
+            if(item->txQueue[j].deadline > item->txQueue[j].timer.elapsed()) continue;
+
+            canTxRequest expired = item->txQueue.takeAt(j);
+            j--;
+            item->deadlineCount--;
+            item->deadlineMisses++;
+            setRequestClient(item, &expired);
+            rxErrorHandle(&expired, expired.txCanId, _CLIENT_ERR_EXPIRED);
+        }
+    }
 }
 
+/**
+ * @brief This function selects the Client of a class with the Earliest Deadline.
+ *
+ * Only the first request of every Client queue of the class is compared,
+ * so that the requests of a Client are always sent in order:
+ * a request with a deadline never overtakes the class priority
+ * nor the previous requests of the same Client.
+ *
+ * @param cls: this is the priority class selected by Server::selectClass()
+ * @return the index of the Client whose first request has the earliest deadline, or -1
+ */
+int Server::selectDeadlineClient(uchar cls){
+    int idx = -1;
+    qint64 best = 0;
+
+    for(int i =0; i< socketList.size(); i++){
+        ServerItem* item = socketList[i];
+        if((item->priorityClass != cls) || (!item->deadlineCount) || (!isServed(item))) continue;
+
+        const canTxRequest& head = item->txQueue.head();
+        if(!head.hasDeadline) continue;
+
+        qint64 remaining = head.deadline - head.timer.elapsed();
+        if((idx < 0) || (remaining < best)){
+            idx = i;
+            best = remaining;
+        }
+    }
+    return idx;
+}
+
+/**
+ * @brief This function returns the deadline statistics of the connected Clients
+ *
+ * For every connected Client the following items are appended to the list:
+ * - Client identifier;
+ * - requests received with a deadline;
+ * - requests discarded because of the deadline expiration;
+ *
+ * @param list: this is the list to be filled
+ */
+void Server::getDeadlineStatistics(QList<QString>* list){
+    for(int i =0; i< socketList.size(); i++){
+        list->append(QString("%1").arg(socketList[i]->id));
+        list->append(QString("%1").arg(socketList[i]->deadlineRequests));
+        list->append(QString("%1").arg(socketList[i]->deadlineMisses));
+    }
+}
+
+/**
+ * @brief This function returns the rate limit statistics of the connected Clients
+ *
+ * For every connected Client the following items are appended to the list:
+ * - Client identifier;
+ * - rate limit in requests per second (0 = no limit);
+ * - token bucket size;
+ * - requests accepted;
+ * - requests discarded by the rate limit;
+ *
+ * @param list: this is the list to be filled
+ */
+void Server::getRateStatistics(QList<QString>* list){
+    for(int i =0; i< socketList.size(); i++){
+        list->append(QString("%1").arg(socketList[i]->id));
+        list->append(QString("%1").arg(socketList[i]->rateFps));
+        list->append(QString("%1").arg(socketList[i]->rateBurst));
+        list->append(QString("%1").arg(socketList[i]->rateAccepted));
+        list->append(QString("%1").arg(socketList[i]->rateThrottled));
+    }
+}
+
+/**
+ * @brief This function returns the diagnostic counters of the connected Clients
+ *
+ * For every connected Client the following items are appended to the list:
+ * - Client identifier;
+ * - priority class;
+ * - requests in the queue;
+ * - requests accepted in the queue;
+ * - requests discarded before the queue;
+ * - request failures;
+ *
+ * @param list: this is the list to be filled
+ */
+void Server::getClientStatistics(QList<QString>* list){
+    for(int i =0; i< socketList.size(); i++){
+        list->append(QString("%1").arg(socketList[i]->id));
+        list->append(QString("%1").arg(socketList[i]->priorityClass));
+        list->append(QString("%1").arg(socketList[i]->txQueue.size()));
+        list->append(QString("%1").arg(socketList[i]->requests.get()));
+        list->append(QString("%1").arg(socketList[i]->drops.get()));
+        list->append(QString("%1").arg(socketList[i]->errors.get()));
+    }
+}
+
+/**
+ * @brief This function returns the number of requests in all the Client queues
+ *
+ * @return the number of queued requests
+ */
+uint Server::getQueuedRequests(void){
+    uint n = 0;
+    for(int i =0; i< socketList.size(); i++) n += socketList[i]->txQueue.size();
+    return n;
+}
+
+/**
+ * @brief This function clears the diagnostic counters of the Server and of the connected Clients
+ */
+void Server::resetCounters(void){
+    for(int i=0; i<_CLIENT_ERR_NUM; i++) errorCount[i].reset();
+    for(int i =0; i< socketList.size(); i++){
+        socketList[i]->requests.reset();
+        socketList[i]->drops.reset();
+        socketList[i]->errors.reset();
+    }
+}
+
+/**
+ * @brief This function records a completed transaction in the latency histograms of the requesting Client
+ *
+ * See the @ref latencyModule.
+ *
+ * @param request: this is the completed request
+ * @param socket: this is the socket write timestamp (ns from the request reception)
+ */
+void Server::recordLatency(const canTxRequest* request, qint64 socket){
+    for(int i =0; i< socketList.size(); i++){
+        if(socketList[i]->id != request->clientId) continue;
+
+        quint32 us[latencyStatistics::_STAGE_NUM];
+        latencyStatistics::getStages(request->tEnqueue, request->tWrite, request->tReply, socket, us);
+        for(int s=0; s<latencyStatistics::_STAGE_NUM; s++) socketList[i]->latency[s].record(us[s]);
+        return;
+    }
+}
+
+/**
+ * @brief This function returns a latency histogram of a connected Client
+ *
+ * @param client_id: this is the Client identifier
+ * @param stage: this is the transaction stage (see latencyStatistics::_Stage)
+ * @return the histogram, or nullptr if the Client is not connected
+ */
+const latencyHistogram* Server::getClientLatency(ushort client_id, uchar stage){
+    for(int i =0; i< socketList.size(); i++){
+        if(socketList[i]->id == client_id) return &socketList[i]->latency[stage % latencyStatistics::_STAGE_NUM];
+    }
+    return nullptr;
+}
+
+/**
+ * @brief This function clears the latency histograms of the connected Clients
+ */
+void Server::resetClientLatency(void){
+    for(int i =0; i< socketList.size(); i++){
+        for(int s=0; s<latencyStatistics::_STAGE_NUM; s++) socketList[i]->latency[s].reset();
+    }
+}
+
+/**
+ * @brief This function selects the next Client of a class with Deficit Round Robin.
+ *
+ * Every time the round robin index reaches a Client with pending requests,
+ * the Client deficit is increased by the Client weight:
+ * the Client is served while its deficit is positive.
+ *
+ * A Client with an empty queue loses its deficit.
+ *
+ * @param cls: this is the priority class
+ * @return the index of the selected Client in the socketList, or -1
+ */
+int Server::selectClient(uchar cls){
+    int n = socketList.size();
+    if(!n) return -1;
+
+    for(int k=0; k < 2 * n + 1; k++){
+        if(rrIndex[cls] >= n) rrIndex[cls] = 0;
+        ServerItem* item = socketList[rrIndex[cls]];
+
+        if(item->priorityClass == cls){
+            if(item->txQueue.isEmpty()) item->deficit = 0;
+            else if((item->deficit > 0) && (isServed(item))){
+                item->deficit--;
+                return rrIndex[cls];
+            }
+        }
+
+        // Next Client: assigns the round quantum
+        rrIndex[cls]++;
+        if(rrIndex[cls] >= n) rrIndex[cls] = 0;
+        item = socketList[rrIndex[cls]];
+        if((item->priorityClass == cls) && (isServed(item))) item->deficit += item->weight;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief This function clears the scheduling statistics
+ */
+void Server::resetClassStatistics(void){
+    for(int i=0; i<_CLASS_NUM; i++){
+        classStats[i].served = 0;
+        classStats[i].totWait = 0;
+        classStats[i].maxWait = 0;
+    }
+}
@@ -87,6 +87,222 @@
  *  - Decimal format: example, 125;
  *  - Hexadecimal format: example, 0xCC
  *
+ *  ## CLIENT OPTION FRAME FORMAT
+ *
+ *  The Client can change the handling of its requests with the Option frame:
+ *
+ *       <O option_name value1 .. valueN>
+ *
+ *  The following options are implemented:
+ *  - <O RETRY retries backoff>: when a Point to Point request times out, the Application
+ *    sends again the request up to retries times (max ServerItem::MAX_RETRIES),
+ *    before to notify the timeout to the Client. Before every new attempt the Application
+ *    waits backoff ms, doubled at every attempt. The bus is free for the other Clients during the backoff time.
+ *    Default: <O RETRY 0 0> (no retry).
+ *
+ *  - <O ERRORS enable>: if enable is 1, the request failures are notified
+ *    with the Error frame (see ERROR FRAME FORMAT). Default: <O ERRORS 0>.
+ *
+ *  - <O CLASS class>: sets the priority class of the Client requests (see SCHEDULING).
+ *    Default: <O CLASS 2>.
+ *  - <O WEIGHT weight>: sets the weight of the Client inside its priority class (1 to 255, see SCHEDULING).
+ *    Default: <O WEIGHT 1>.
+ *  - <O RATE fps burst>: limits the Client requests (D, T and B frames) with a token bucket:
+ *    the bucket holds up to burst tokens (1 to 1000) and it is refilled with fps tokens per second.
+ *    A valid request received with the bucket empty is discarded and notified with
+ *    the Error frame (reason 8, see ERROR FRAME FORMAT), also if the ERRORS option is disabled.
+ *    The requests discarded for other reasons (queue full, device not open, wrong format)
+ *    don't take a token. <O RATE 0 0> disables the limit.
+ *    Default: <O RATE 0 0>.
+ *
+ *  The Server answers replying the frame in case of success.
+ *
+ *  ## REQUEST SEQUENCE NUMBER
+ *
+ *  The D and T frames can optionally carry a sequence number, preceding the canId:
+ *
+ *       <D #seq canId B0 B1 .. B7>
+ *
+ *  Where seq is a 16 bit number assigned by the Client.
+ *  The sequence number is echoed in the answer frame (D or T) and in the Error frame
+ *  related to the request:
+ *
+ *       <D #seq canId B0 B1 .. B7 >
+ *
+ *  Every Client has a request queue of ServerItem::MAX_QUEUE_DEPTH requests:
+ *  the Client can send more requests without waiting for the answers,
+ *  matching the answers with the sequence numbers.
+ *
+ *      NOTE: the answers can be received in a different order than the requests
+ *      (for example when a request is sent again after a timeout, see the RETRY option).
+ *
+ *  ## REQUEST DEADLINE
+ *
+ *  The D and T frames can optionally carry a relative deadline in ms, preceding the canId:
+ *
+ *       <D @deadline canId B0 B1 .. B7>
+ *       <D #seq @deadline canId B0 B1 .. B7>
+ *
+ *  The deadline is the max time, from the request reception,
+ *  for the request to be sent on the bus:
+ *  - inside the Client priority class, the requests with a deadline are scheduled
+ *    Earliest Deadline First (see SCHEDULING);
+ *  - a request that can no longer meet its deadline is discarded and notified with
+ *    the Error frame (reason 7, see ERROR FRAME FORMAT);
+ *  - a timed out request with an expired deadline is not sent again (see RETRY option).
+ *
+ *  The deadline statistics of every Client are measured (see ServerItem::deadlineRequests).
+ *
+ *  ## ISO-TP DATA FRAME FORMAT
+ *
+ *  The Client can send a payload longer than 8 bytes to a device
+ *  implementing the ISO 15765-2 (ISO-TP) transport protocol,
+ *  using the ISO-TP Data Frame format:
+ *
+ *       <T canId B0 B1 .. Bn>
+ *
+ *  Where
+ *  - '<' and '>' are frame delimiters
+ *  - T: is the frame type identifier;
+ *  - canId: is the canId of the device request frames;
+ *  - B0 to Bn: are 8 bit payload content (max isoTp::MAX_PAYLOAD bytes,
+ *    a longer payload is rejected).
+ *
+ *  The device answers (and Flow Control frames) are expected with
+ *  the canId registered with the Acceptance Filter frame.
+ *
+ *  The Application handles locally the segmentation,
+ *  the Flow Control, the Block Size and the STmin of the transaction (see the @ref isotpModule),
+ *  and sends back to the Client the whole device response with a single frame:
+ *
+ *       <T canId B0 B1 .. Bn >
+ *
+ *      NOTE: in case of transaction error or timeout, the response is sent without data: <T canId >
+ *
+ *  ## BULK TRANSFER FRAME FORMAT
+ *
+ *  The Client can download a large data block to a device
+ *  with a single Bulk Transfer frame (see the @ref bulkModule):
+ *
+ *       <B reqCanId ackCanId segSize window ackEvery ackCode B0 B1 .. Bn>
+ *
+ *  Where
+ *  - '<' and '>' are frame delimiters
+ *  - B: is the frame type identifier;
+ *  - reqCanId: is the canId of the segment frames;
+ *  - ackCanId: is the canId of the device acknowledge frames;
+ *  - segSize: is the number of data bytes per segment (1 to 7);
+ *  - window: is the max number of segments not yet acknowledged (1 to 127);
+ *  - ackEvery: the device acknowledges every ackEvery segments;
+ *  - ackCode: is the first byte of a valid acknowledge frame;
+ *  - B0 to Bn: are 8 bit data block content (max bulkTransfer::MAX_PAYLOAD bytes).
+ *
+ *  The Application runs the segmented exchange locally and
+ *  notifies the job progress to the Client every bulkTransfer::PROGRESS_PERIOD ms:
+ *
+ *       <P reqCanId acknowledged_bytes total_bytes >
+ *
+ *  When the job terminates, the Application sends the completion frame:
+ *
+ *       <B reqCanId result elapsed_ms segments retransmissions >
+ *
+ *  Where result is:
+ *  - 0: the data block has been successfully downloaded;
+ *  - 1: acknowledge timeout;
+ *  - 2: the device rejected the data block;
+ *  - 3: invalid job descriptor;
+ *
+ *  ## ERROR FRAME FORMAT
+ *
+ *  When the Client enables the ERRORS option, the Application notifies
+ *  a request failure with the Error frame:
+ *
+ *       <E [#seq] canId reason elapsed >
+ *
+ *  Where
+ *  - canId: is the canId of the expected answer (or of the request if the request has not been sent);
+ *  - reason: is the failure reason code (see _ClientErrorCode):
+ *      - 1: the device answer has not been received in time;
+ *      - 2: the CAN bus is in Bus Error condition;
+ *      - 3: the CAN controller is in Error Passive condition;
+ *      - 4: the request has been discarded because the Client request queue is full;
+ *      - 5: the CAN device is closed (while the device is opening the requests are queued);
+ *      - 6: transport protocol error (ISO-TP), or T/B payload exceeding the max length;
+ *      - 7: the request deadline is expired before the request could be sent;
+ *      - 8: the request exceeds the Client rate limit (see RATE option);
+ *  - elapsed: is the time in microseconds from the request reception to the failure.
+ *
+ *  When the ERRORS option is disabled (default):
+ *  - the timeout of a D frame is notified with an all-zero D frame: <D canId 0 0 0 0 0 0 0 0 >;
+ *  - the failure of a T frame is notified with an empty T frame: <T canId >;
+ *  - the rate limit (reason 8) is notified anyway with the Error frame;
+ *  - a D or T request received with the device closed (reason 5) is notified as a failed request
+ *    (all-zero D frame or empty T frame), a B request with the completion frame (result 2, rejected);
+ *  - the other failures are not notified.
+ *
+ *  ## LATE ANSWER FRAME FORMAT
+ *
+ *  When a device answers after the timeout of a D request
+ *  (up to canDriver::LATE_WINDOW ms later), the answer is delivered
+ *  only to the requesting Client with the Late frame:
+ *
+ *       <L [#seq] canId B0 B1 .. B7 >
+ *
+ *  The late answer is not forwarded as an ASYNC frame.
+ *
+ * ## SCHEDULING
+ *
+ * Every scheduling slot, the Application selects the next request
+ * to be sent on the bus from the Client queues.
+ *
+ * Every Client belongs to a priority class (see _PriorityClass):
+ * - 0: CRITICAL (safety-critical and motion control);
+ * - 1: HIGH;
+ * - 2: NORMAL (default);
+ * - 3: LOW (diagnostic tools);
+ *
+ * The classes are served with strict priority and aging:
+ * the priority of a class is raised by one level every Server::AGING_STEP ms
+ * its oldest request waits in the queue, so that no class can starve.
+ *
+ * Inside a class, the Clients are served with Deficit Round Robin:
+ * a Client with weight W sends up to W requests before the next Client of the same class.
+ *
+ * The queue waiting time of every class is measured (see Server::classStatistics).
+ *
+ * Inside the selected class, the Clients whose next request has a deadline (see REQUEST DEADLINE)
+ * are served before the other Clients of the class, Earliest Deadline First.
+ * A deadline never raises a request above its class, and the requests of a Client
+ * are always sent in the order they are received (a request with a deadline waits
+ * for the previous requests of the same Client).
+ * In CAN-ID priority mode the deadline is only used to discard the expired requests.
+ *
+ * While an ISO-TP transaction or a Bulk job is running, only the Point to Point requests
+ * are interleaved with the job (see the @ref candriverModule): the CRITICAL requests every slot,
+ * the other requests every canDriver::JOB_SLICE slots.
+ *
+ * ### CAN-ID PRIORITY MODE
+ *
+ * The scheduler can optionally work in CAN-ID priority mode (see _SchedulerMode),
+ * matching the bus arbitration rule (the lower canId wins):
+ * - the first requests of all the Client queues are ordered by canId,
+ *   regardless of the Client class and weight;
+ * - the priority of a waiting request is raised by Server::CANID_AGING_DELTA canIds every
+ *   Server::CANID_AGING_STEP ms, so that the higher canIds can't starve;
+ * - the requests of the same Client are always sent in the order they are received;
+ *
+ * The mode is selected with the Interface command SetSchedulerMode.
+ *
+ * ### ADMISSION CONTROL
+ *
+ * The admission control protects the higher priority traffic when the bus is overloaded:
+ * while the bus load of the last Server::ADMISSION_WINDOW ms exceeds the threshold,
+ * the requests of the Clients with a class equal or lower than the throttled class
+ * are kept in the Client queues (including the requests with a deadline).
+ *
+ * The admission control is disabled by default and it is
+ * configured with the Interface command SetAdmissionControl.
+ *
  * ## CAN DATA RECEPTION
  *
  * When a data frame is received from the CAN bus,\n
@@ -102,10 +318,75 @@
 
 #include <QTcpServer>
 #include <QTcpSocket>
+#include <QQueue>
 #include <QHostAddress>
 #include <QNetworkInterface>
+#include <QElapsedTimer>
+#include "isotp.h"
+#include "bulktransfer.h"
+#include "counters.h"
+#include "latency.h"
+
+
 
+/// This enumeration defines the type of the Client requests
+typedef enum{
+    _TX_P2P_FRAME = 0,  //!< Point to Point single frame request (D frame)
+    _TX_ISOTP_FRAME,    //!< ISO-TP multi frame request (T frame)
+    _TX_BULK_FRAME      //!< Bulk transfer job request (B frame)
+}_TxRequestType;
 
+/// This enumeration defines the reason codes of the Error frame
+typedef enum{
+    _CLIENT_ERR_TIMEOUT = 1,        //!< Device answer not received in time
+    _CLIENT_ERR_BUS_ERROR,          //!< CAN bus error condition
+    _CLIENT_ERR_PASSIVE,            //!< CAN controller in Error Passive condition
+    _CLIENT_ERR_QUEUE_FULL,         //!< A previous request is still pending
+    _CLIENT_ERR_NOT_OPEN,           //!< CAN device not open
+    _CLIENT_ERR_PROTOCOL,           //!< Transport protocol error
+    _CLIENT_ERR_EXPIRED,            //!< Request deadline expired
+    _CLIENT_ERR_THROTTLED,          //!< Client rate limit exceeded
+    _CLIENT_ERR_NUM                 //!< Number of reason codes (the reason 0 is not used)
+}_ClientErrorCode;
+
+/// This enumeration defines the priority classes of the Clients
+typedef enum{
+    _CLASS_CRITICAL = 0,    //!< Safety-critical and motion control traffic
+    _CLASS_HIGH,            //!< High priority traffic
+    _CLASS_NORMAL,          //!< Default priority
+    _CLASS_LOW,             //!< Diagnostic traffic
+    _CLASS_NUM              //!< Number of priority classes
+}_PriorityClass;
+
+/// This enumeration defines the scheduler working mode
+typedef enum{
+    _SCHED_CLASS = 0,   //!< Priority class with aging and Deficit Round Robin (default)
+    _SCHED_CANID        //!< CAN-ID priority with aging, as the bus arbitration
+}_SchedulerMode;
+
+/**
+ * @brief This is the structure of a request to be sent on the CAN bus
+ *
+ * \ingroup interfaceModule
+ */
+typedef struct{
+    _TxRequestType  type;       //!< Request type
+    ushort          clientId;   //!< Identifier of the requesting Client
+    uint16_t        txCanId;    //!< canId of the frame to be sent
+    uint16_t        rxCanId;    //!< canId of the expected answer
+    QByteArray      data;       //!< Data content
+    uchar           retries;    //!< Max number of attempts after a timeout
+    ushort          backoff;    //!< Wait time in ms before the first new attempt
+    QElapsedTimer   timer;      //!< Started when the request is received from the Client
+    bool            hasSeq;     //!< The request carries a sequence number
+    ushort          seq;        //!< Sequence number to be echoed in the answer
+    bool            hasDeadline; //!< The request carries a deadline
+    qint64          deadline;   //!< Max time in ms from the request reception to be sent on the bus
+    bulkTransfer::jobDescriptor job; //!< Job descriptor of a Bulk transfer request
+    qint64          tEnqueue;   //!< Enqueue time (ns from the request reception, see the @ref latencyModule)
+    qint64          tWrite;     //!< VSCAN_Write time of the last attempt (ns from the request reception)
+    qint64          tReply;     //!< Device answer reception time (ns from the request reception)
+}canTxRequest;
 
 /**
  * @brief This is the Client socket class
@@ -123,7 +404,7 @@ class ServerItem: public QObject
 
 public:
 
-    explicit ServerItem(){};
+    explicit ServerItem(){rxOverflow = false;};
     ~ServerItem(){};
 
 signals:
@@ -142,13 +423,49 @@ public:
     ushort id;          //!< Identifier of the socket client
     ushort rxCanId;     //!< canId di ricezione
 
-    uint16_t txCanId;
-    QByteArray txData;
-    bool dataPresent;
+    static const int MAX_QUEUE_DEPTH = 32; //!< Max number of requests waiting to be sent
+    QQueue<canTxRequest> txQueue; //!< Requests waiting to be sent
+
+    static const uchar MAX_RETRIES = 10; //!< Max number of attempts after a timeout
+    uchar  retries;     //!< Number of attempts after a timeout (RETRY option)
+    ushort backoff;     //!< Wait time before a new attempt (RETRY option)
+    bool   errorFrames; //!< Failures notified with the Error frame (ERRORS option)
+
+    uchar  priorityClass; //!< Priority class of the Client (CLASS option)
+    uchar  weight;      //!< Weight of the Client inside the priority class (WEIGHT option)
+    int    deficit;     //!< Deficit Round Robin counter
+
+    int    deadlineCount;       //!< Requests with a deadline in the queue
+    uint   deadlineRequests;    //!< Requests received with a deadline
+    uint   deadlineMisses;      //!< Requests discarded because of the deadline expiration
+
+    statCounter requests;       //!< Requests accepted in the queue
+    statCounter drops;          //!< Requests discarded before the queue (rate limit, queue full, device not open)
+    statCounter errors;         //!< Request failures (any reason code)
+
+    latencyHistogram latency[latencyStatistics::_STAGE_NUM]; //!< Latency histograms of the Client Point to Point transactions
+
+    static const ushort MAX_RATE_BURST = 1000; //!< Max token bucket size (RATE option)
+    ushort rateFps;             //!< Token bucket refill rate in requests per second (0 = no limit)
+    ushort rateBurst;           //!< Token bucket size
+    double rateTokens;          //!< Tokens available in the bucket
+    QElapsedTimer rateTimer;    //!< Time of the last token bucket refill
+    uint   rateAccepted;        //!< Requests accepted by the rate limit
+    uint   rateThrottled;       //!< Requests discarded by the rate limit
+
+    static const int MAX_RX_FRAME = 5 * bulkTransfer::MAX_PAYLOAD + 64; //!< Max length of a received frame (the largest Bulk frame in hex format)
 
 private:
+    QByteArray rxFrame; //!< Frame under reception (a frame can be splitted in more socket data streams)
+    bool rxOverflow;    //!< The frame under reception exceeds MAX_RX_FRAME: discarded up to the next frame
     void handleSocketFrame(QByteArray* data);//!< Ethernet frame decoding function
     ushort getItem(int* index, QByteArray* data, bool* data_ok);
+    QString getToken(int* index, QByteArray* data);
+    bool getAttributes(int* index, QByteArray* data, canTxRequest* request); //!< Decodes the optional request attributes
+    void sendErrorFrame(const canTxRequest* request, _ClientErrorCode reason); //!< Sends an Error frame if the ERRORS option is enabled
+    void notOpenHandle(canTxRequest* request); //!< Answers a request received with the CAN device closed
+    bool handleOptionFrame(int* index, QByteArray* data); //!< Option frame decoding function
+    bool rateAdmit(void); //!< Token bucket rate limit verification
 
 };
 
@@ -175,10 +492,57 @@ public:
 
     static const long _DEFAULT_TX_TIMEOUT = 5000;    //!< Default timeout in ms for tx data
     bool Start(void);   //! Starts listening the server on the IP&Port
-    bool getNextTxFrame(ushort* client_id, uint16_t* pRxCanId, uint16_t* pTxCanId,  QByteArray* pdata); //! Return the next frame to be sent
-    void rxCanFrameHandle(ushort client_id, ushort canId, QByteArray* data); //!< Handles the can rx/tx data to be sent to the client
+    bool getNextTxFrame(canTxRequest* request, int jobRxCanId = -1); //! Return the next frame to be sent
+    bool isCriticalWaiting(int jobRxCanId); //!< Returns true if a CRITICAL request can be interleaved with the running job
+    void rxCanFrameHandle(const canTxRequest* request, ushort canId, QByteArray* data); //!< Handles the can rx/tx data to be sent to the client
+    void rxIsoTpFrameHandle(const canTxRequest* request, ushort canId, const QByteArray* data); //!< Handles the ISO-TP response to be sent to the client
+    void rxLateFrameHandle(const canTxRequest* request, ushort canId, QByteArray* data); //!< Handles a late answer to be sent to the client
+    void rxErrorHandle(const canTxRequest* request, ushort canId, _ClientErrorCode reason); //!< Notifies a request failure to the client
+    static QString seqTag(const canTxRequest* request); //!< Returns the sequence number tag of a request
+    void bulkProgressHandle(ushort client_id, ushort canId, uint ackBytes, uint totalBytes); //!< Notifies the Bulk transfer progress to the client
+    void bulkCompletedHandle(ushort client_id, ushort canId, uint result, qint64 elapsed, uint segments, uint retransmissions); //!< Notifies the Bulk transfer completion to the client
     void rxAsyncCanFrameHandle(ushort canId, QByteArray* data); //!<  Handles the Asynch data to be sent to the client
 
+    static const qint64 AGING_STEP = 50; //!< Waiting time in ms raising the priority of a class by one level
+
+    /// Scheduling statistics of a priority class
+    typedef struct{
+        uint    served;     //!< Requests sent on the bus
+        qint64  totWait;    //!< Sum of the queue waiting times (us)
+        qint64  maxWait;    //!< Max queue waiting time (us)
+    }classStatistics;
+
+    static const qint64 CANID_AGING_STEP = 10;  //!< Waiting time in ms raising the priority of a request in CAN-ID mode
+    static const int    CANID_AGING_DELTA = 0x40; //!< canId priority raise every CANID_AGING_STEP
+
+    static const uint   ADMISSION_WINDOW = 100; //!< Bus load window in ms of the admission control
+
+    void setAdmissionControl(uint threshold, uchar cls); //!< Sets the admission control threshold and the first throttled class
+    inline uint getAdmissionThreshold(void){return admissionThreshold;}
+    inline uchar getAdmissionClass(void){return admissionClass;}
+    inline uint getOverloadSlots(void){return overloadSlots;}
+
+    inline void setSchedulerMode(_SchedulerMode mode){schedulerMode = mode;}
+    inline _SchedulerMode getSchedulerMode(void){return schedulerMode;}
+
+    inline const classStatistics& getClassStatistics(uchar cls){return classStats[cls % _CLASS_NUM];}
+    void resetClassStatistics(void); //!< Clears the scheduling statistics
+    void getDeadlineStatistics(QList<QString>* list); //!< Returns the deadline statistics of the connected Clients
+    void getRateStatistics(QList<QString>* list); //!< Returns the rate limit statistics of the connected Clients
+    void getClientStatistics(QList<QString>* list); //!< Returns the diagnostic counters of the connected Clients
+    uint getQueuedRequests(void); //!< Returns the number of requests in all the Client queues
+    inline int getClients(void){return socketList.size();}
+    inline const ServerItem* getClient(int index){return socketList[index];}
+    inline void countError(_ClientErrorCode reason){errorCount[reason % _CLIENT_ERR_NUM].inc();}
+    inline quint64 getErrorCount(uchar reason){return errorCount[reason % _CLIENT_ERR_NUM].get();}
+    void resetCounters(void); //!< Clears the diagnostic counters of the Server and of the Clients
+    void recordLatency(const canTxRequest* request, qint64 socket); //!< Records a completed transaction in the Client latency histograms
+    const latencyHistogram* getClientLatency(ushort client_id, uchar stage); //!< Returns a latency histogram of a Client (nullptr if not connected)
+    void resetClientLatency(void); //!< Clears the latency histograms of the connected Clients
+
+    inline void setStartupReference(qint64 reference){startupReference = reference;} //!< Sets the process start time (QElapsedTimer::msecsSinceReference())
+    inline qint64 getFirstConnectionTime(void){return firstConnection;} //!< Returns the time in ms from the process start to the first accepted connection (-1 if none)
+
 signals:
 
 public slots:
@@ -195,6 +559,25 @@ private:
     quint16             localport;     //!< Port of the local server
     ushort              idseq;
 
+    _SchedulerMode      schedulerMode;          //!< Scheduler working mode
+    uint                admissionThreshold;     //!< Bus load percentage activating the admission control (0 = disabled)
+    uchar               admissionClass;         //!< First class throttled by the admission control
+    int                 admitClasses;           //!< Number of classes served in the current slot
+    int                 jobCanId;               //!< Device canId of the job running in the current slot, -1 if none
+    uint                overloadSlots;          //!< Scheduling slots with the admission control active
+    int                 rrIndex[_CLASS_NUM];    //!< Deficit Round Robin index of every class
+    classStatistics     classStats[_CLASS_NUM]; //!< Scheduling statistics of every class
+    statCounter         errorCount[_CLIENT_ERR_NUM]; //!< Request failures of every reason code
+    qint64              startupReference;       //!< Process start time (QElapsedTimer::msecsSinceReference())
+    qint64              firstConnection;        //!< Time from the process start to the first accepted connection (ms), -1 if none
+    bool isServed(ServerItem* item); //!< Returns true if the Client can be served in the current slot
+    int selectClient(uchar cls); //!< Deficit Round Robin selection inside a class
+    void expireDeadlines(void); //!< Discards the requests whose deadline is expired
+    int selectDeadlineClient(uchar cls); //!< Earliest Deadline First selection inside a class
+    int selectClass(void); //!< Priority class selection with aging
+    int selectCanIdClient(void); //!< CAN-ID priority selection
+    void setRequestClient(ServerItem* item, canTxRequest* request); //!< Assigns the Client parameters to a request
+    void clientWrite(ushort client_id, const QByteArray& frame); //!< Sends a frame to a given client
 
 };
 
@@ -0,0 +1,45 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+/*!
+ * \defgroup  countersModule Statistic Counters Module.
+ *
+ * This Module implements the counters of the Application diagnostic statistics.
+ *
+ * Every counter is written only by the thread owning the counted activity
+ * (the CAN driver or the Server) and can be read by any other thread:
+ * - the counters are lock-free atomic variables;
+ * - the relaxed memory order is used, so that the counting
+ *   doesn't add any synchronization to the CAN path;
+ * - a reader gets a consistent value of every single counter,
+ *   but not a consistent snapshot of a set of counters.
+ *
+ */
+
+#include <QtGlobal>
+#include <atomic>
+
+/**
+ * @brief This class implements a single lock-free statistic counter
+ *
+ * \ingroup countersModule
+ */
+class statCounter
+{
+public:
+
+    statCounter(){reset();}
+
+    inline void inc(quint64 n = 1){value.fetch_add(n, std::memory_order_relaxed);} //!< Increments the counter
+    inline void set(quint64 v){value.store(v, std::memory_order_relaxed);} //!< Sets the counter value
+    inline void reset(void){value.store(0, std::memory_order_relaxed);} //!< Clears the counter
+    inline quint64 get(void) const {return value.load(std::memory_order_relaxed);} //!< Returns the counter value
+
+    /// Updates the counter with a new value if greater (single writer)
+    inline void max(quint64 v){if(v > value.load(std::memory_order_relaxed)) value.store(v, std::memory_order_relaxed);}
+
+private:
+    std::atomic<quint64> value;
+};
+
+#endif // COUNTERS_H
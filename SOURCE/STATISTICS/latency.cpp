@@ -0,0 +1,176 @@
+#include "latency.h"
+#include <QtAlgorithms>
+
+/**
+ * @brief This function clears the histogram
+ */
+void latencyHistogram::reset(void){
+    for(uint i=0; i<NUM_BUCKETS; i++) buckets[i] = 0;
+    count = 0;
+    sum = 0;
+    min = 0xFFFFFFFF;
+    max = 0;
+}
+
+/**
+ * @brief This function returns the bucket of a value
+ *
+ * - values lower than SUB_COUNT have a bucket each;
+ * - the other values are grouped in the SUB_HALF buckets of their power of two range;
+ *
+ * @param us: the value
+ * @return the bucket index
+ */
+uint latencyHistogram::bucketIndex(quint32 us){
+    if(us < SUB_COUNT) return us;
+
+    uint msb = 31 - qCountLeadingZeroBits(us);
+    uint shift = msb - (SUB_BITS - 1);
+    return SUB_COUNT + SUB_HALF * (msb - SUB_BITS) + ((us >> shift) - SUB_HALF);
+}
+
+/**
+ * @brief This function returns the highest value of a bucket
+ *
+ * @param index: the bucket index
+ * @return the highest value counted in the bucket
+ */
+quint32 latencyHistogram::bucketHighValue(uint index){
+    if(index < SUB_COUNT) return index;
+
+    uint msb = SUB_BITS + (index - SUB_COUNT) / SUB_HALF;
+    uint shift = msb - (SUB_BITS - 1);
+    quint64 sub = (index - SUB_COUNT) % SUB_HALF + SUB_HALF;
+    return (quint32) (((sub + 1) << shift) - 1);
+}
+
+/**
+ * @brief This function records a value
+ *
+ * @param us: the value in us
+ */
+void latencyHistogram::record(quint32 us){
+    buckets[bucketIndex(us)]++;
+    count++;
+    sum += us;
+    if(us < min) min = us;
+    if(us > max) max = us;
+}
+
+/**
+ * @brief This function adds the values of another histogram
+ *
+ * @param other: the histogram to be added
+ */
+void latencyHistogram::merge(const latencyHistogram& other){
+    if(!other.count) return;
+    for(uint i=0; i<NUM_BUCKETS; i++) buckets[i] += other.buckets[i];
+    count += other.count;
+    sum += other.sum;
+    if(other.min < min) min = other.min;
+    if(other.max > max) max = other.max;
+}
+
+/**
+ * @brief This function returns the value of a percentile
+ *
+ * The value is the highest value of the bucket containing the percentile,
+ * limited to the max recorded value.
+ *
+ * @param percentile: the percentile (0 to 100)
+ * @return the percentile value in us
+ */
+quint32 latencyHistogram::getPercentile(double percentile) const{
+    if(!count) return 0;
+
+    quint64 target = (quint64) (percentile * count / 100.0 + 0.5);
+    if(target < 1) target = 1;
+    if(target > count) target = count;
+
+    quint64 acc = 0;
+    for(uint i=0; i<NUM_BUCKETS; i++){
+        acc += buckets[i];
+        if(acc >= target){
+            quint32 val = bucketHighValue(i);
+            return (val > max) ? max : val;
+        }
+    }
+    return max;
+}
+
+/**
+ * @brief This function returns the number of values lower or equal than a limit
+ *
+ * The buckets whose highest value is lower or equal than the limit are counted,
+ * so that the result is exact when the limit is the highest value of a bucket.
+ *
+ * @param us: the limit in us
+ * @return the number of recorded values
+ */
+quint64 latencyHistogram::getCountBelow(quint32 us) const{
+    quint64 acc = 0;
+    for(uint i=0; i<NUM_BUCKETS; i++){
+        if(bucketHighValue(i) > us) break;
+        acc += buckets[i];
+    }
+    return acc;
+}
+
+/**
+ * @brief This function clears all the histograms
+ */
+void latencyStatistics::reset(void){
+    for(int s=0; s<_STAGE_NUM; s++){
+        global[s].reset();
+        for(int d=0; d<MAX_DEVICES; d++) device[d][s].reset();
+    }
+}
+
+/**
+ * @brief This function records a completed transaction
+ *
+ * The timestamps are in ns from the request reception on the Client socket.
+ *
+ * @param canId: the canId of the device answer
+ * @param enqueue: enqueue timestamp
+ * @param write: VSCAN_Write timestamp
+ * @param reply: answer reception timestamp
+ * @param socket: socket write timestamp
+ */
+void latencyStatistics::record(ushort canId, qint64 enqueue, qint64 write, qint64 reply, qint64 socket){
+    quint32 us[_STAGE_NUM];
+    getStages(enqueue, write, reply, socket, us);
+
+    latencyHistogram* dev = device[canId & 0x3F];
+    for(int s=0; s<_STAGE_NUM; s++){
+        global[s].record(us[s]);
+        dev[s].record(us[s]);
+    }
+}
+
+/**
+ * @brief This function returns the stage times of a transaction
+ *
+ * The timestamps are in ns from the request reception on the Client socket.
+ *
+ * @param enqueue: enqueue timestamp
+ * @param write: VSCAN_Write timestamp
+ * @param reply: answer reception timestamp
+ * @param socket: socket write timestamp
+ * @param us: the array of the _STAGE_NUM stage times in us to be filled
+ */
+void latencyStatistics::getStages(qint64 enqueue, qint64 write, qint64 reply, qint64 socket, quint32* us){
+    qint64 stage[_STAGE_NUM];
+    stage[_STAGE_RX] = enqueue;
+    stage[_STAGE_QUEUE] = write - enqueue;
+    stage[_STAGE_DEVICE] = reply - write;
+    stage[_STAGE_REPLY] = socket - reply;
+    stage[_STAGE_TOTAL] = socket;
+
+    for(int s=0; s<_STAGE_NUM; s++){
+        qint64 val = stage[s] / 1000;
+        if(val < 0) val = 0;
+        if(val > 0xFFFFFFFF) val = 0xFFFFFFFF;
+        us[s] = (quint32) val;
+    }
+}
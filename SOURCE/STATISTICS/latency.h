@@ -0,0 +1,117 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+/*!
+ * \defgroup  latencyModule Latency Statistics Module.
+ *
+ * This Module measures where the time goes in a Point to Point transaction,
+ * from the Client request reception to the answer written on the Client socket.
+ *
+ * # TRANSACTION STAGES
+ *
+ * Every Point to Point transaction is timestamped (see canTxRequest):
+ * - at the socket reception (the request timer start);
+ * - at the enqueue in the Client queue;
+ * - at the VSCAN_Write of the (last) attempt;
+ * - at the reception of the device answer;
+ * - at the write of the answer on the Client socket;
+ *
+ * The time between two timestamps is a stage (see latencyStatistics::_Stage):
+ * - RX: socket reception to enqueue (frame decoding);
+ * - QUEUE: enqueue to VSCAN_Write (scheduling and retry backoff);
+ * - DEVICE: VSCAN_Write to the answer reception (bus and device);
+ * - REPLY: answer reception to socket write;
+ * - TOTAL: socket reception to socket write;
+ *
+ * # HISTOGRAMS
+ *
+ * Every stage is recorded in a global histogram, in the histogram of the device
+ * (Device ID = canId & 0x3F) and in the histogram of the requesting Client
+ * (kept by the Server with the Client, see ServerItem::latency).
+ *
+ * The histograms have a HDR (High Dynamic Range) log-linear bucket layout:
+ * the values in us are grouped in power of two ranges, every range is split in
+ * latencyHistogram::SUB_HALF linear buckets, so that the relative error is
+ * less than 1/latencyHistogram::SUB_HALF on the whole 32 bit range.
+ *
+ * The record is a fixed time operation on a pre-allocated array:
+ * no memory is allocated on the CAN path.
+ *
+ *  NOTE: the ISO-TP transactions, the Bulk jobs and the late answers are not recorded.
+ */
+
+#include <QtGlobal>
+
+/**
+ * @brief This class implements a single HDR latency histogram
+ *
+ * \ingroup latencyModule
+ */
+class latencyHistogram
+{
+public:
+
+    latencyHistogram(){reset();}
+
+    static const uint SUB_BITS = 5;                     //!< Bits of resolution of every power of two range
+    static const uint SUB_COUNT = 1 << SUB_BITS;        //!< Linear buckets of the first range
+    static const uint SUB_HALF = SUB_COUNT / 2;         //!< Linear buckets of every next range
+    static const uint NUM_BUCKETS = SUB_COUNT + SUB_HALF * (32 - SUB_BITS); //!< Buckets covering the 32 bit range
+
+    void reset(void); //!< Clears the histogram
+    void record(quint32 us); //!< Records a value in us
+    void merge(const latencyHistogram& other); //!< Adds the values of another histogram
+    quint32 getPercentile(double percentile) const; //!< Returns the value of a percentile
+    quint64 getCountBelow(quint32 us) const; //!< Returns the number of values lower or equal than a limit
+
+    inline quint64 getCount(void) const {return count;}
+    inline quint32 getMin(void) const {return (count) ? min : 0;}
+    inline quint32 getMax(void) const {return max;}
+    inline quint32 getAvg(void) const {return (count) ? (quint32) (sum / count) : 0;}
+    inline quint64 getSum(void) const {return sum;}
+
+private:
+    quint32     buckets[NUM_BUCKETS];   //!< Counters of the buckets
+    quint64     count;                  //!< Recorded values
+    quint64     sum;                    //!< Sum of the recorded values
+    quint32     min;                    //!< Min recorded value
+    quint32     max;                    //!< Max recorded value
+
+    static uint bucketIndex(quint32 us);
+    static quint32 bucketHighValue(uint index);
+};
+
+/**
+ * @brief This class collects the latency histograms of every transaction stage
+ *
+ * \ingroup latencyModule
+ */
+class latencyStatistics
+{
+public:
+
+    static const uchar MAX_DEVICES = 64; //!< Max number of remote devices (Device ID = canId & 0x3F)
+
+    /// This enumeration defines the transaction stages
+    typedef enum{
+        _STAGE_RX = 0,      //!< Socket reception to enqueue
+        _STAGE_QUEUE,       //!< Enqueue to VSCAN_Write
+        _STAGE_DEVICE,      //!< VSCAN_Write to the answer reception
+        _STAGE_REPLY,       //!< Answer reception to socket write
+        _STAGE_TOTAL,       //!< Socket reception to socket write
+        _STAGE_NUM          //!< Number of stages
+    }_Stage;
+
+    void reset(void); //!< Clears all the histograms
+    void record(ushort canId, qint64 enqueue, qint64 write, qint64 reply, qint64 socket); //!< Records a completed transaction
+    static void getStages(qint64 enqueue, qint64 write, qint64 reply, qint64 socket, quint32* us); //!< Returns the stage times of a transaction
+
+    inline const latencyHistogram& getHistogram(uchar stage){return global[stage % _STAGE_NUM];}
+    inline const latencyHistogram& getDeviceHistogram(uchar devId, uchar stage){return device[devId & 0x3F][stage % _STAGE_NUM];}
+
+private:
+    latencyHistogram global[_STAGE_NUM];                //!< Histograms of all the devices
+    latencyHistogram device[MAX_DEVICES][_STAGE_NUM];   //!< Histograms of every device
+};
+
+#endif // LATENCY_H
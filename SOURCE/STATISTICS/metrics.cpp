@@ -0,0 +1,199 @@
+#include "application.h"
+#include "metrics.h"
+#include <cstdarg>
+#include <cstdio>
+
+/**
+ * @brief metricsExporter class constructor
+ *
+ * @param ipaddress: IP where the exporter will be bounded;
+ * @param port: bounding port
+ */
+metricsExporter::metricsExporter(QString ipaddress, int port):QTcpServer()
+{
+    localip = QHostAddress(ipaddress);
+    localport = port;
+    renderLen = 0;
+}
+
+/**
+ * @brief This function starts listening the HTTP requests
+ *
+ * @return true in case of success
+ */
+bool metricsExporter::Start(void)
+{
+    if (!this->listen(localip,localport)) {
+        qDebug() << "METRICS EXPORTER: UNABLE TO LISTEN ON PORT " << localport;
+        return false;
+    }
+
+    qDebug() << "METRICS EXPORTER LISTENING ON PORT " << localport;
+    return true;
+}
+
+void metricsExporter::incomingConnection(qintptr socketDescriptor)
+{
+    QTcpSocket* socket = new QTcpSocket(this);
+    if(!socket->setSocketDescriptor(socketDescriptor)){
+        delete socket;
+        return;
+    }
+
+    connect(socket,SIGNAL(readyRead()), this, SLOT(socketRxData()),Qt::UniqueConnection);
+    connect(socket,SIGNAL(disconnected()),this, SLOT(disconnected()),Qt::UniqueConnection);
+}
+
+void metricsExporter::disconnected()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    if(socket) socket->deleteLater();
+}
+
+/**
+ * @brief This function handles a HTTP request
+ *
+ * The request is answered when the whole header is received:
+ * - GET /metrics: the metrics are rendered and sent;
+ * - any other request: 404;
+ *
+ * The connection is closed after the answer.
+ */
+void metricsExporter::socketRxData()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    if(!socket) return;
+
+    // Waits for the whole request header
+    if(socket->bytesAvailable() > MAX_REQUEST){
+        socket->abort();
+        return;
+    }
+    QByteArray request = socket->peek(socket->bytesAvailable());
+    if(!request.contains("\r\n\r\n")) return;
+    socket->readAll();
+
+    int len;
+    if(request.startsWith("GET /metrics")){
+        render();
+        len = snprintf(headerBuffer, HEADER_SIZE,
+                        "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", renderLen);
+        socket->write(headerBuffer, len);
+        socket->write(renderBuffer, renderLen);
+    }else{
+        len = snprintf(headerBuffer, HEADER_SIZE, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        socket->write(headerBuffer, len);
+    }
+
+    socket->disconnectFromHost();
+}
+
+/**
+ * @brief This function appends a formatted string to the render buffer
+ *
+ * The content exceeding the buffer is discarded.
+ *
+ * @param format: printf-like format
+ */
+void metricsExporter::print(const char* format, ...)
+{
+    if(renderLen >= RENDER_SIZE - 1) return;
+
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(&renderBuffer[renderLen], RENDER_SIZE - renderLen, format, args);
+    va_end(args);
+
+    if(len < 0) return;
+    renderLen += len;
+    if(renderLen > RENDER_SIZE - 1) renderLen = RENDER_SIZE - 1;
+}
+
+void metricsExporter::printCounter(const char* name, const char* help, const char* type, quint64 value)
+{
+    print("# HELP %s %s\n# TYPE %s %s\n%s %llu\n", name, help, name, type, name, (unsigned long long) value);
+}
+
+/**
+ * @brief This function renders all the metrics in the render buffer
+ */
+void metricsExporter::render(void)
+{
+    renderLen = 0;
+    renderBuffer[0] = 0;
+
+    // Driver traffic
+    const canDriver::driverCounters& cnt = CAN->getCounters();
+    printCounter("candriver_rx_frames_total", "Frames received from the bus.", "counter", cnt.rxFrames.get());
+    printCounter("candriver_tx_frames_total", "Frames sent on the bus.", "counter", cnt.txFrames.get());
+    printCounter("candriver_rx_fps", "Frames received in the last second.", "gauge", cnt.rxFps.get());
+    printCounter("candriver_tx_fps", "Frames sent in the last second.", "gauge", cnt.txFps.get());
+    printCounter("candriver_p2p_requests_total", "Point to Point requests sent (any attempt).", "counter", cnt.p2pRequests.get());
+    printCounter("candriver_p2p_answers_total", "Point to Point answers received in time.", "counter", cnt.p2pAnswers.get());
+    printCounter("candriver_p2p_timeouts_total", "Point to Point answers not received in time.", "counter", cnt.p2pTimeouts.get());
+    printCounter("candriver_late_answers_total", "Answers delivered after the timeout.", "counter", cnt.lateAnswers.get());
+    printCounter("candriver_async_frames_total", "Frames forwarded as ASYNC frames.", "counter", cnt.asyncFrames.get());
+
+    // Bus errors
+    print("# HELP candriver_bus_errors_total CAN controller error conditions.\n# TYPE candriver_bus_errors_total counter\n");
+    print("candriver_bus_errors_total{type=\"bus\"} %llu\n", (unsigned long long) cnt.busErrors.get());
+    print("candriver_bus_errors_total{type=\"passive\"} %llu\n", (unsigned long long) cnt.errPassive.get());
+    print("candriver_bus_errors_total{type=\"warning\"} %llu\n", (unsigned long long) cnt.errWarning.get());
+    print("candriver_bus_errors_total{type=\"overrun\"} %llu\n", (unsigned long long) cnt.overruns.get());
+
+    // Request failures
+    print("# HELP candriver_request_errors_total Request failures by reason code.\n# TYPE candriver_request_errors_total counter\n");
+    for(int i=_CLIENT_ERR_TIMEOUT; i<_CLIENT_ERR_NUM; i++){
+        print("candriver_request_errors_total{reason=\"%d\"} %llu\n", i, (unsigned long long) SERVER->getErrorCount(i));
+    }
+
+    // Bus load
+    print("# HELP candriver_bus_load_percent Bus load percentage.\n# TYPE candriver_bus_load_percent gauge\n");
+    print("candriver_bus_load_percent{window=\"100ms\"} %.1f\n", CAN->getBusLoad(100));
+    print("candriver_bus_load_percent{window=\"1s\"} %.1f\n", CAN->getBusLoad(1000));
+    print("candriver_bus_load_percent{window=\"10s\"} %.1f\n", CAN->getBusLoad(10000));
+
+    // Startup times (not reported until measured)
+    if(CAN->getOpenTime() >= 0){
+        print("# HELP candriver_device_open_seconds Duration of the background device open.\n# TYPE candriver_device_open_seconds gauge\n");
+        print("candriver_device_open_seconds %g\n", CAN->getOpenTime() / 1000.0);
+    }
+    if(SERVER->getFirstConnectionTime() >= 0){
+        print("# HELP candriver_first_connection_seconds Time from the process start to the first accepted Client connection.\n# TYPE candriver_first_connection_seconds gauge\n");
+        print("candriver_first_connection_seconds %g\n", SERVER->getFirstConnectionTime() / 1000.0);
+    }
+
+    // Clients and queues
+    printCounter("candriver_clients", "Connected Clients.", "gauge", SERVER->getClients());
+    printCounter("candriver_queued_requests", "Requests in the Client queues.", "gauge", SERVER->getQueuedRequests());
+    printCounter("candriver_retry_requests", "Requests waiting for a new attempt.", "gauge", CAN->getRetryQueue());
+
+    print("# HELP candriver_client_queue_depth Requests in the Client queue.\n# TYPE candriver_client_queue_depth gauge\n");
+    for(int i=0; i<SERVER->getClients(); i++){
+        const ServerItem* item = SERVER->getClient(i);
+        print("candriver_client_queue_depth{client=\"%u\"} %d\n", item->id, (int) item->txQueue.size());
+    }
+    print("# HELP candriver_client_requests_total Requests accepted in the Client queue.\n# TYPE candriver_client_requests_total counter\n");
+    for(int i=0; i<SERVER->getClients(); i++){
+        const ServerItem* item = SERVER->getClient(i);
+        print("candriver_client_requests_total{client=\"%u\"} %llu\n", item->id, (unsigned long long) item->requests.get());
+    }
+    print("# HELP candriver_client_drops_total Requests discarded before the Client queue.\n# TYPE candriver_client_drops_total counter\n");
+    for(int i=0; i<SERVER->getClients(); i++){
+        const ServerItem* item = SERVER->getClient(i);
+        print("candriver_client_drops_total{client=\"%u\"} %llu\n", item->id, (unsigned long long) item->drops.get());
+    }
+
+    // Latency histograms: power of two bucket limits, matching the HDR bucket limits
+    static const char* stages[latencyStatistics::_STAGE_NUM] = {"rx", "queue", "device", "reply", "total"};
+    print("# HELP candriver_p2p_latency_seconds Point to Point transaction stage latency.\n# TYPE candriver_p2p_latency_seconds histogram\n");
+    for(int s=0; s<latencyStatistics::_STAGE_NUM; s++){
+        const latencyHistogram& histo = CAN->getLatency().getHistogram(s);
+        for(quint32 limit = 128; limit <= 131072; limit <<= 1){
+            print("candriver_p2p_latency_seconds_bucket{stage=\"%s\",le=\"%g\"} %llu\n", stages[s], (limit - 1) / 1000000.0, (unsigned long long) histo.getCountBelow(limit - 1));
+        }
+        print("candriver_p2p_latency_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %llu\n", stages[s], (unsigned long long) histo.getCount());
+        print("candriver_p2p_latency_seconds_sum{stage=\"%s\"} %g\n", stages[s], histo.getSum() / 1000000.0);
+        print("candriver_p2p_latency_seconds_count{stage=\"%s\"} %llu\n", stages[s], (unsigned long long) histo.getCount());
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+/*!
+ * \defgroup  metricsModule Metrics Exporter Module.
+ *
+ * This Module implements an optional HTTP endpoint exporting the
+ * Application metrics in the Prometheus text exposition format.
+ *
+ * # CONNECTION DETAILS
+ *
+ * The exporter is enabled with the METRICS_EXPORTER parameter
+ * of the configuration file (see canDriverConfiguration):
+ * - the first item is the IP address (default 127.0.0.1);
+ * - the second item is the port (default 0 = exporter disabled);
+ *
+ * The metrics are returned to the HTTP request:
+ *
+ *      GET /metrics HTTP/1.1
+ *
+ * Any other request is answered with 404. The connection is closed after every answer.
+ *
+ * # EXPORTED METRICS
+ *
+ * - candriver_rx_frames_total, candriver_tx_frames_total: frames received and sent;
+ * - candriver_rx_fps, candriver_tx_fps: frames received and sent in the last second;
+ * - candriver_p2p_requests_total, candriver_p2p_answers_total, candriver_p2p_timeouts_total,
+ *   candriver_late_answers_total, candriver_async_frames_total: Point to Point traffic;
+ * - candriver_bus_errors_total{type}: CAN controller error conditions;
+ * - candriver_request_errors_total{reason}: request failures of every reason code;
+ * - candriver_bus_load_percent{window}: bus load of the 100ms, 1s and 10s windows;
+ * - candriver_clients, candriver_queued_requests, candriver_retry_requests: connected Clients and queues;
+ * - candriver_client_queue_depth{client}, candriver_client_requests_total{client},
+ *   candriver_client_drops_total{client}: Client counters;
+ * - candriver_p2p_latency_seconds{stage}: latency histograms of the transaction stages
+ *   (see the @ref latencyModule), with power of two buckets from 128us to 131ms;
+ *
+ * # RENDERING
+ *
+ * The answer is rendered with formatted writes into the pre-allocated
+ * metricsExporter::RENDER_SIZE buffer: a scrape doesn't allocate memory
+ * for the content. The content exceeding the buffer is truncated.
+ *
+ *  NOTE: the exporter runs in the Application main thread, as the CAN driver:
+ *  a scrape reads the counters and the histograms without locks.
+ *
+ */
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+
+/**
+ * @brief This class implements the metrics HTTP exporter
+ *
+ * \ingroup metricsModule
+ */
+class metricsExporter : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+
+    explicit metricsExporter(QString ipaddress, int port);
+    ~metricsExporter(){};
+
+    static const int RENDER_SIZE = 65536;   //!< Size of the render buffer
+    static const int HEADER_SIZE = 256;     //!< Size of the HTTP header buffer
+    static const int MAX_REQUEST = 4096;    //!< Max length of a HTTP request
+
+    bool Start(void); //!< Starts listening on the IP&Port
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override; //!< Incoming connection slot
+
+private slots:
+    void socketRxData(); //!< HTTP request received
+    void disconnected(); //!< Client disconnection
+
+private:
+    QHostAddress    localip;    //!< Address of the exporter
+    quint16         localport;  //!< Port of the exporter
+    char            renderBuffer[RENDER_SIZE];  //!< Metrics content buffer
+    char            headerBuffer[HEADER_SIZE];  //!< HTTP header buffer
+    int             renderLen;  //!< Content length in the render buffer
+
+    void render(void); //!< Renders all the metrics in the render buffer
+    void print(const char* format, ...); //!< Formatted write into the render buffer
+    void printCounter(const char* name, const char* help, const char* type, quint64 value); //!< Writes a single value metric
+};
+
+#endif // METRICS_H
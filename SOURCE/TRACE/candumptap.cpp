@@ -0,0 +1,118 @@
+#include "application.h"
+#include "candumptap.h"
+#include "logformat.h"
+#include <QDateTime>
+#include <cstring>
+
+/**
+ * @brief candumpTap class constructor
+ *
+ * @param ipaddress: IP where the tap will be bounded;
+ * @param port: bounding port
+ */
+candumpTap::candumpTap(QString ipaddress, int port):QTcpServer()
+{
+    localip = QHostAddress(ipaddress);
+    localport = port;
+    dropped = 0;
+    startNs = 0;
+    connect(&drainTimer, SIGNAL(timeout()), this, SLOT(drain()), Qt::UniqueConnection);
+}
+
+/**
+ * @brief This function starts listening the tap connections
+ *
+ * @return true in case of success
+ */
+bool candumpTap::Start(void)
+{
+    if (!this->listen(localip,localport)) {
+        qDebug() << "CANDUMP TAP: UNABLE TO LISTEN ON PORT " << localport;
+        return false;
+    }
+
+    qDebug() << "CANDUMP TAP LISTENING ON PORT " << localport;
+    return true;
+}
+
+void candumpTap::incomingConnection(qintptr socketDescriptor)
+{
+    QTcpSocket* socket = new QTcpSocket(this);
+    if(!socket->setSocketDescriptor(socketDescriptor)){
+        delete socket;
+        return;
+    }
+
+    connect(socket,SIGNAL(readyRead()), this, SLOT(socketRxData()),Qt::UniqueConnection);
+    connect(socket,SIGNAL(disconnected()),this, SLOT(disconnected()),Qt::UniqueConnection);
+    clients.append(socket);
+
+    // The first client subscribes the tap
+    if(clients.size() == 1){
+        startNs = QDateTime::currentMSecsSinceEpoch() * 1000000 - CAN->getTaps()->getTime();
+        CAN->getTaps()->subscribe(&tap);
+        drainTimer.start(DRAIN_MS);
+    }
+}
+
+void candumpTap::socketRxData()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    if(socket) socket->readAll();
+}
+
+void candumpTap::disconnected()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    if(!socket) return;
+    clients.removeOne(socket);
+    socket->deleteLater();
+
+    // The last client unsubscribes the tap: the queued frames are discarded
+    if(clients.isEmpty()){
+        CAN->getTaps()->unsubscribe(&tap);
+        drainTimer.stop();
+        tapFrame frames[256];
+        while(tap.read(frames, 256));
+    }
+}
+
+/**
+ * @brief This function sends the frames queued in the tap
+ */
+void candumpTap::drain()
+{
+    tapFrame frames[256];
+    uint n;
+    while((n = tap.read(frames, 256))){
+        for(uint i=0; i<n; i++) send(&frames[i]);
+    }
+}
+
+/**
+ * @brief This function formats a frame and sends it to the connected clients
+ *
+ * @param frame: the frame read from the tap
+ */
+void candumpTap::send(const tapFrame* frame){
+    captureRecord rec;
+    rec.timestamp = 0;
+    rec.id = frame->id;
+    rec.client = CAPTURE_NO_CLIENT;
+    rec.flags = frame->flags;
+    rec.dlc = frame->dlc;
+    rec.direction = (frame->direction == canTap::_TAP_TX) ? _CAPTURE_TX : _CAPTURE_RX;
+    rec.reserved = 0;
+    memcpy(rec.data, frame->data, 8);
+
+    char line[logFormat::MAX_LINE];
+    int len = logFormat::formatCandump(line, startNs + frame->time, "can0", &rec);
+
+    for(int i=0; i<clients.size(); i++){
+        if(clients[i]->bytesToWrite() > MAX_PENDING){
+            dropped++;
+            continue;
+        }
+        clients[i]->write(line, len);
+    }
+}
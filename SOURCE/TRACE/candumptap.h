@@ -0,0 +1,78 @@
+#ifndef CANDUMPTAP_H
+#define CANDUMPTAP_H
+
+/*!
+ * \addtogroup  captureModule
+ *
+ * # LIVE CANDUMP TAP
+ *
+ * The candumpTap class streams the bus traffic in candump log format (see logFormat)
+ * to the clients connected to a local TCP port, so that the standard tools
+ * can tap the bus (e.g. nc 127.0.0.1 port | canplayer, or a log viewer).
+ *
+ * The tap is enabled with the CANDUMP_TAP parameter of the configuration file
+ * (see canDriverConfiguration):
+ * - the first item is the IP address (default 127.0.0.1);
+ * - the second item is the port (default 0 = tap disabled);
+ *
+ * The tap observes the frames with a canTap (see the @ref cantapModule),
+ * subscribed only while at least a client is connected:
+ * - every candumpTap::DRAIN_MS ms the queued frames are formatted once in a stack buffer
+ *   and written to all the connected clients; the interface name is "can0";
+ * - a client not reading its data is not allowed to slow down the driver:
+ *   when more than candumpTap::MAX_PENDING bytes are waiting to be sent,
+ *   the lines for that client are discarded and counted.
+ *
+ * The data received from the clients are ignored.
+ */
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QTimer>
+#include <QList>
+#include "cantap.h"
+
+/**
+ * @brief This class implements the live candump TCP tap
+ *
+ * \ingroup captureModule
+ */
+class candumpTap : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+
+    explicit candumpTap(QString ipaddress, int port);
+    ~candumpTap(){};
+
+    static const qint64 MAX_PENDING = 1 << 20; //!< Max bytes waiting to be sent to a client
+    static const int DRAIN_MS = 10; //!< Period of the frame queue reading (ms)
+
+    bool Start(void); //!< Starts listening on the IP&Port
+
+    inline quint64 getDropped(void){return dropped + tap.getDropped();}
+    inline int getClients(void){return clients.size();}
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override; //!< Incoming connection slot
+
+private slots:
+    void socketRxData(); //!< Data received from a client (ignored)
+    void disconnected(); //!< Client disconnection
+    void drain(); //!< Sends the queued frames
+
+private:
+    QHostAddress        localip;    //!< Tap IP address
+    quint16             localport;  //!< Tap port
+    QList<QTcpSocket*>  clients;    //!< Connected clients
+    canTap              tap;        //!< Observer of the CAN frames
+    QTimer              drainTimer; //!< Frame queue reading timer
+    qint64              startNs;    //!< Wall clock time of the tap clock start (ns since epoch)
+    quint64             dropped;    //!< Lines discarded (slow clients)
+
+    void send(const tapFrame* frame); //!< Formats and sends a frame
+};
+
+#endif // CANDUMPTAP_H
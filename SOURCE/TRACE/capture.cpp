@@ -0,0 +1,261 @@
+#include "application.h"
+#include "capture.h"
+#include <QDateTime>
+#include <QDir>
+
+/**
+ * @brief captureRecorder class constructor
+ */
+captureRecorder::captureRecorder(){
+    running = false;
+    failed = false;
+    bitrate = 0;
+    startTime = 0;
+    fileIndex = 0;
+    total = 0;
+    dropped = 0;
+    current.file = nullptr;
+    current.map = nullptr;
+    current.indexFile = nullptr;
+    current.indexMap = nullptr;
+    next = current;
+    nextReady.store(false);
+    nextFailed.store(false);
+    worker = nullptr;
+}
+
+QString captureRecorder::fileName(uint index, const char* extension){
+    return QString("%1_%2%3").arg(baseName).arg(index, 4, 10, QChar('0')).arg(extension);
+}
+
+/**
+ * @brief This function creates, preallocates and maps a file
+ *
+ * @param name: the file name
+ * @param size: the preallocated size
+ * @param file: the created file (nullptr in case of error)
+ * @return the mapped content or nullptr in case of error
+ */
+static uchar* createMappedFile(const QString& name, qint64 size, QFile** file){
+    QFile* f = new QFile(name);
+    uchar* map = nullptr;
+
+    if((f->open(QIODevice::ReadWrite | QIODevice::Truncate)) && (f->resize(size))) map = f->map(0, size);
+    if(!map){
+        if(f->isOpen()) f->close();
+        delete f;
+        f = nullptr;
+    }
+
+    *file = f;
+    return map;
+}
+
+/**
+ * @brief This function creates, preallocates and maps a capture file and its index file
+ *
+ * @param f: the file descriptor to be filled
+ * @param index: the file index in the capture
+ * @return true in case of success
+ */
+bool captureRecorder::openFile(captureFile* f, uint index){
+    f->records = 0;
+    f->indexFile = nullptr;
+    f->indexMap = nullptr;
+    f->map = createMappedFile(fileName(index), sizeof(captureFileHeader) + FILE_RECORDS * sizeof(captureRecord), &f->file);
+    if(!f->map) return false;
+
+    f->indexMap = createMappedFile(fileName(index, CAPTURE_INDEX_EXTENSION), sizeof(captureIndexHeader) + (FILE_RECORDS / CAPTURE_INDEX_BLOCK) * sizeof(captureIndexBlock), &f->indexFile);
+    if(!f->indexMap){
+        QString name = f->file->fileName();
+        closeFile(f, false);
+        QFile::remove(name);
+        return false;
+    }
+
+    f->header = (captureFileHeader*) f->map;
+    f->base = (captureRecord*) (f->map + sizeof(captureFileHeader));
+
+    memset(f->header, 0, sizeof(captureFileHeader));
+    memcpy(f->header->magic, CAPTURE_MAGIC, 8);
+    f->header->version = CAPTURE_VERSION;
+    f->header->recordSize = sizeof(captureRecord);
+    f->header->startTime = startTime;
+    f->header->fileIndex = index;
+    f->header->bitrate = bitrate;
+    f->header->records = 0;
+
+    // The block entries are zero filled by the file preallocation
+    f->index = (captureIndexHeader*) f->indexMap;
+    f->blocks = (captureIndexBlock*) (f->indexMap + sizeof(captureIndexHeader));
+
+    memset(f->index, 0, sizeof(captureIndexHeader));
+    memcpy(f->index->magic, CAPTURE_INDEX_MAGIC, 8);
+    f->index->version = CAPTURE_VERSION;
+    f->index->blockRecords = CAPTURE_INDEX_BLOCK;
+    f->index->blocks = 0;
+    return true;
+}
+
+/**
+ * @brief This function unmaps and closes a capture file and its index file
+ *
+ * @param f: the file descriptor
+ * @param truncate: the files are truncated to the valid records
+ */
+void captureRecorder::closeFile(captureFile* f, bool truncate){
+    if(f->indexFile){
+        if(f->indexMap) f->indexFile->unmap(f->indexMap);
+        if(truncate) f->indexFile->resize(sizeof(captureIndexHeader) + ((f->records + CAPTURE_INDEX_BLOCK - 1) / CAPTURE_INDEX_BLOCK) * sizeof(captureIndexBlock));
+        f->indexFile->close();
+        delete f->indexFile;
+    }
+    f->indexFile = nullptr;
+    f->indexMap = nullptr;
+
+    if(!f->file) return;
+
+    if(f->map) f->file->unmap(f->map);
+    f->map = nullptr;
+    if(truncate) f->file->resize(sizeof(captureFileHeader) + f->records * sizeof(captureRecord));
+    f->file->close();
+    delete f->file;
+    f->file = nullptr;
+}
+
+/**
+ * @brief This function starts the worker thread
+ *
+ * The worker thread:
+ * - closes the full file;
+ * - removes the file exceeding the MAX_FILES rotation;
+ * - prepares the next file: in case of failure the preparation is tried again
+ *   up to PREPARE_ATTEMPTS times, then the failure is signaled to rotate();
+ *
+ * @param old: the full file to be closed (file = nullptr if not present)
+ * @param index: the index of the file to be prepared
+ */
+void captureRecorder::startWorker(captureFile old, uint index){
+    nextReady.store(false, std::memory_order_relaxed);
+    nextFailed.store(false, std::memory_order_relaxed);
+
+    worker = QThread::create([this, old, index](){
+        captureFile f = old;
+        closeFile(&f, false);
+        if(index >= MAX_FILES){
+            QFile::remove(fileName(index - MAX_FILES));
+            QFile::remove(fileName(index - MAX_FILES, CAPTURE_INDEX_EXTENSION));
+        }
+        for(uint attempt = 0; attempt < PREPARE_ATTEMPTS; attempt++){
+            if(attempt) QThread::msleep(PREPARE_RETRY_MS);
+            if(openFile(&next, index)){
+                nextReady.store(true, std::memory_order_release);
+                return;
+            }
+            qDebug() << "CAPTURE: UNABLE TO CREATE " << fileName(index) << " ATTEMPT " << attempt + 1;
+        }
+        nextFailed.store(true, std::memory_order_release);
+    });
+    worker->start();
+}
+
+void captureRecorder::waitWorker(void){
+    if(!worker) return;
+    worker->wait();
+    delete worker;
+    worker = nullptr;
+}
+
+/**
+ * @brief This function switches to the next file, prepared by the worker thread
+ *
+ * If the worker thread has failed to prepare the next file, the capture is stopped.
+ *
+ * @return true if the next file is ready
+ */
+bool captureRecorder::rotate(void){
+    if(nextFailed.load(std::memory_order_acquire)){
+        qDebug() << "CAPTURE: NEXT FILE NOT AVAILABLE, CAPTURE STOPPED";
+        failed = true;
+        stop();
+        return false;
+    }
+    if(!nextReady.load(std::memory_order_acquire)) return false;
+
+    // The worker thread has completed
+    worker->wait();
+    delete worker;
+    worker = nullptr;
+
+    captureFile old = current;
+    current = next;
+    next.file = nullptr;
+    next.indexFile = nullptr;
+    fileIndex++;
+
+    startWorker(old, fileIndex + 1);
+    return true;
+}
+
+/**
+ * @brief This function starts a new capture
+ *
+ * The first file is prepared immediately, the second file is prepared by the worker thread.
+ *
+ * @param name: the capture name: the files are created in CAPTURE_PATH
+ * @param bps: the bus bitrate
+ * @return true in case of success
+ */
+bool captureRecorder::start(QString name, uint bps){
+    stop();
+
+    QDir().mkpath(CAPTURE_PATH);
+    baseName = QString("%1%2").arg(CAPTURE_PATH).arg(name);
+    bitrate = bps;
+    startTime = QDateTime::currentMSecsSinceEpoch();
+    fileIndex = 0;
+    total = 0;
+    dropped = 0;
+    failed = false;
+
+    if(!openFile(&current, 0)){
+        qDebug() << "CAPTURE: UNABLE TO CREATE " << fileName(0);
+        return false;
+    }
+
+    captureFile none;
+    none.file = nullptr;
+    none.map = nullptr;
+    none.indexFile = nullptr;
+    none.indexMap = nullptr;
+    startWorker(none, 1);
+
+    clock.start();
+    running = true;
+    qDebug() << "CAPTURE STARTED: " << baseName;
+    return true;
+}
+
+/**
+ * @brief This function stops the capture
+ *
+ * The current file and its index are truncated to the valid records,
+ * the next file prepared by the worker thread is removed.
+ */
+void captureRecorder::stop(void){
+    if(!running) return;
+    running = false;
+
+    waitWorker();
+    closeFile(&current, true);
+
+    if(next.file){
+        QString unused = next.file->fileName();
+        QString unusedIndex = next.indexFile->fileName();
+        closeFile(&next, false);
+        QFile::remove(unused);
+        QFile::remove(unusedIndex);
+    }
+
+    qDebug() << "CAPTURE STOPPED: " << total << " RECORDS, " << dropped << " DROPPED";
+}
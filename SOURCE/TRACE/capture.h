@@ -0,0 +1,144 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+/*!
+ * \addtogroup  captureModule
+ *
+ * # CAPTURE RECORDER
+ *
+ * The CAN driver feeds the recorder with every frame received and sent on the bus
+ * (see captureRecorder::record()).
+ *
+ * The files are written through a memory mapping:
+ * - every file is preallocated with captureRecorder::FILE_RECORDS records and mapped in memory;
+ * - a record is a 24 bytes copy in the mapped memory, the update of the header records field
+ *   and the update of the block entry in the mapped index file: no system call is executed on the CAN path;
+ * - when a file is full, the recorder switches to the next file, already prepared
+ *   by a worker thread; the worker thread closes the full file and prepares the following one;
+ * - only the last captureRecorder::MAX_FILES files are kept (rotation);
+ * - when the capture stops, the last file is truncated to the valid records;
+ *
+ * If the next file is not ready when the current file is full, the frames are
+ * discarded and counted (see captureRecorder::getDropped()).
+ *
+ * If the worker thread cannot create the next file, the preparation is tried again
+ * up to captureRecorder::PREPARE_ATTEMPTS times: if it still fails, the capture is stopped
+ * when the current file is full and the failure is reported by the GetCaptureStatus command
+ * (see captureRecorder::isFailed()).
+ *
+ * The capture is started and stopped with the Interface commands StartCapture and StopCapture.
+ */
+
+#include <QObject>
+#include <QFile>
+#include <QString>
+#include <QElapsedTimer>
+#include <QThread>
+#include <atomic>
+#include <cstring>
+#include "capturefile.h"
+
+/**
+ * @brief This class implements the capture recorder
+ *
+ * \ingroup captureModule
+ */
+class captureRecorder: public QObject
+{
+    Q_OBJECT
+
+public:
+
+    captureRecorder();
+    ~captureRecorder(){stop();}
+
+    static const quint64 FILE_RECORDS = 1 << 21;    //!< Records of a capture file (48MB)
+    static const uint MAX_FILES = 20;               //!< Max number of files kept in a capture
+    static constexpr const char* CAPTURE_PATH = "C:/OEM/Gantry/Capture/"; //!< Directory of the capture files
+    static const uint PREPARE_ATTEMPTS = 3;         //!< Attempts to prepare the next file
+    static const uint PREPARE_RETRY_MS = 100;       //!< Delay between the preparation attempts
+
+    bool start(QString name, uint bitrate); //!< Starts a new capture
+    void stop(void); //!< Stops the capture
+
+    /// Records a frame
+    inline void record(uchar direction, ushort id, uchar flags, const uchar* data, uchar dlc, ushort client){
+        if(!running) return;
+        if(current.records >= FILE_RECORDS){
+            if(!rotate()){
+                if(running) dropped++;
+                return;
+            }
+        }
+
+        captureRecord* rec = &current.base[current.records];
+        rec->timestamp = clock.nsecsElapsed();
+        rec->id = id;
+        rec->client = client;
+        rec->flags = flags;
+        rec->dlc = dlc;
+        rec->direction = direction;
+        rec->reserved = 0;
+        memcpy(rec->data, data, 8);
+
+        // Sidecar index
+        captureIndexBlock* blk = &current.blocks[current.records / CAPTURE_INDEX_BLOCK];
+        if(!(current.records % CAPTURE_INDEX_BLOCK)){
+            blk->first = rec->timestamp;
+            current.index->blocks++;
+        }
+        blk->last = rec->timestamp;
+        blk->ids[(id >> 6) & 0x1F] |= ((quint64) 1) << (id & 0x3F);
+
+        current.records++;
+        current.header->records = current.records;
+        total++;
+    }
+
+    inline bool isRunning(void){return running;}
+    inline bool isFailed(void){return failed;} //!< The capture has been stopped because a file could not be created
+    inline quint64 getRecords(void){return total;}
+    inline quint64 getDropped(void){return dropped;}
+    inline uint getFiles(void){return fileIndex + 1;}
+    inline const QString& getName(void){return baseName;}
+
+private:
+
+    /// This is a mapped capture file
+    typedef struct{
+        QFile*              file;       //!< Capture file
+        uchar*              map;        //!< Mapped file content
+        captureFileHeader*  header;     //!< File header in the mapped content
+        captureRecord*      base;       //!< First record in the mapped content
+        quint64             records;    //!< Records written in the file
+        QFile*              indexFile;  //!< Sidecar index file
+        uchar*              indexMap;   //!< Mapped index content
+        captureIndexHeader* index;      //!< Index header in the mapped content
+        captureIndexBlock*  blocks;     //!< First block entry in the mapped content
+    }captureFile;
+
+    bool            running;
+    bool            failed;         //!< The capture has been stopped because a file could not be created
+    QString         baseName;       //!< Capture file base name (path included)
+    uint            bitrate;        //!< Bus bitrate
+    qint64          startTime;      //!< Wall clock time of the capture start (ms since epoch)
+    QElapsedTimer   clock;          //!< Time base of the records
+    uint            fileIndex;      //!< Index of the current file
+    quint64         total;          //!< Records of the capture
+    quint64         dropped;        //!< Frames discarded (next file not ready)
+
+    captureFile     current;        //!< File under recording
+    captureFile     next;           //!< Next file, prepared by the worker thread
+    std::atomic<bool> nextReady;    //!< The next file is ready
+    std::atomic<bool> nextFailed;   //!< The next file cannot be created
+    QThread*        worker;         //!< Worker thread preparing the next file
+
+    QString fileName(uint index, const char* extension = CAPTURE_EXTENSION); //!< Returns the name of a capture or index file
+    bool openFile(captureFile* f, uint index); //!< Creates, preallocates and maps a capture file
+    void closeFile(captureFile* f, bool truncate); //!< Unmaps and closes a capture file
+    bool rotate(void); //!< Switches to the next file
+    void startWorker(captureFile old, uint index); //!< Closes a full file and prepares the next one in the worker thread
+    void waitWorker(void); //!< Waits for the worker thread completion
+};
+
+#endif // CAPTURE_H
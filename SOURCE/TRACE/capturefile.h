@@ -0,0 +1,120 @@
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+/*!
+ * \defgroup  captureModule CAN Capture Module.
+ *
+ * This Module records the CAN bus traffic in compact binary capture files.
+ *
+ * # CAPTURE FILE FORMAT
+ *
+ * A capture is a sequence of files named basename_NNNN.cap (NNNN = file index).
+ *
+ * Every file starts with a 64 bytes header (see captureFileHeader) followed by
+ * fixed size 24 bytes records (see captureRecord):
+ * - the header records field is the number of valid records in the file;
+ * - the timestamps are in ns from the capture start (common to all the files of a capture);
+ * - the header startTime is the wall clock time of the capture start (ms since epoch).
+ * - the client field is set only in the Point to Point request frames (retries included)
+ *   and in the related device answers: the ISO-TP and Bulk segments and the frames
+ *   not related to a Client have the client field set to CAPTURE_NO_CLIENT.
+ *
+ * All the numeric fields are little endian.
+ *
+ * # INDEX FILE FORMAT
+ *
+ * Every capture file has a sidecar index file named basename_NNNN.idx, written while recording.
+ *
+ * The records of the capture file are grouped in blocks of CAPTURE_INDEX_BLOCK records.
+ * The index file starts with a 32 bytes header (see captureIndexHeader) followed by
+ * an entry for every block (see captureIndexBlock):
+ * - the timestamp of the first and of the last record of the block (sparse time index);
+ * - a 2048 bits bitmap of the canId present in the block;
+ *
+ * A reader can seek a timestamp with a binary search on the blocks and can
+ * iterate only the blocks containing a given canId (see captureReader).
+ *
+ */
+
+#include <QtGlobal>
+
+#define CAPTURE_MAGIC       "CANCAP01"  //!< Magic string of the capture files
+#define CAPTURE_VERSION     1           //!< Format version of the capture files
+#define CAPTURE_EXTENSION   ".cap"      //!< Extension of the capture files
+#define CAPTURE_INDEX_MAGIC "CANIDX01"  //!< Magic string of the index files
+#define CAPTURE_INDEX_EXTENSION ".idx"  //!< Extension of the index files
+#define CAPTURE_INDEX_BLOCK 4096        //!< Records of an index block
+
+/// This enumeration defines the direction of a captured frame
+typedef enum{
+    _CAPTURE_RX = 0,    //!< Frame received from the bus
+    _CAPTURE_TX         //!< Frame sent on the bus
+}_CaptureDirection;
+
+static const quint16 CAPTURE_NO_CLIENT = 0xFFFF; //!< Client field of the frames not related to a Client
+
+#define CAPTURE_FLAG_STANDARD   0x01    //!< Record flag: standard frame (VSCAN_FLAGS_STANDARD)
+#define CAPTURE_FLAG_REMOTE     0x04    //!< Record flag: remote frame (VSCAN_FLAGS_REMOTE)
+
+/**
+ * @brief This is the header of a capture file (64 bytes)
+ *
+ * \ingroup captureModule
+ */
+typedef struct{
+    char    magic[8];       //!< CAPTURE_MAGIC
+    quint32 version;        //!< CAPTURE_VERSION
+    quint32 recordSize;     //!< Size of a record
+    qint64  startTime;      //!< Wall clock time of the capture start (ms since epoch)
+    quint32 fileIndex;      //!< Index of the file in the capture
+    quint32 bitrate;        //!< Bus bitrate (bit/s)
+    quint64 records;        //!< Number of valid records in the file
+    quint8  reserved[24];
+}captureFileHeader;
+
+/**
+ * @brief This is the record of a captured frame (24 bytes)
+ *
+ * \ingroup captureModule
+ */
+typedef struct{
+    qint64  timestamp;  //!< Time in ns from the capture start
+    quint16 id;         //!< canId
+    quint16 client;     //!< Client related to the frame (CAPTURE_NO_CLIENT if not related)
+    quint8  flags;      //!< VSCAN frame flags
+    quint8  dlc;        //!< Frame length
+    quint8  direction;  //!< Frame direction (see _CaptureDirection)
+    quint8  reserved;
+    quint8  data[8];    //!< Frame content
+}captureRecord;
+
+/**
+ * @brief This is the header of an index file (32 bytes)
+ *
+ * \ingroup captureModule
+ */
+typedef struct{
+    char    magic[8];       //!< CAPTURE_INDEX_MAGIC
+    quint32 version;        //!< CAPTURE_VERSION
+    quint32 blockRecords;   //!< Records of a block (CAPTURE_INDEX_BLOCK)
+    quint64 blocks;         //!< Number of valid blocks
+    quint8  reserved[8];
+}captureIndexHeader;
+
+/**
+ * @brief This is the index entry of a block of records (272 bytes)
+ *
+ * \ingroup captureModule
+ */
+typedef struct{
+    qint64  first;          //!< Timestamp of the first record of the block
+    qint64  last;           //!< Timestamp of the last record of the block
+    quint64 ids[32];        //!< Bitmap of the canId present in the block (bit = canId)
+}captureIndexBlock;
+
+static_assert(sizeof(captureFileHeader) == 64, "Wrong capture header size");
+static_assert(sizeof(captureRecord) == 24, "Wrong capture record size");
+static_assert(sizeof(captureIndexHeader) == 32, "Wrong index header size");
+static_assert(sizeof(captureIndexBlock) == 272, "Wrong index block size");
+
+#endif // CAPTUREFILE_H
@@ -0,0 +1,202 @@
+#include "capturereader.h"
+#include <cstring>
+
+/**
+ * @brief captureReader class constructor
+ */
+captureReader::captureReader(){
+    file = nullptr;
+    indexFile = nullptr;
+    header = nullptr;
+    records = nullptr;
+    count = 0;
+    blocks = nullptr;
+    nBlocks = 0;
+}
+
+/**
+ * @brief This function unmaps and closes the files
+ */
+void captureReader::close(void){
+    if(indexFile){
+        indexFile->close();
+        delete indexFile;
+        indexFile = nullptr;
+    }
+
+    if(file){
+        file->close();
+        delete file;
+        file = nullptr;
+    }
+
+    builtIndex.clear();
+    header = nullptr;
+    records = nullptr;
+    count = 0;
+    blocks = nullptr;
+    nBlocks = 0;
+}
+
+/**
+ * @brief This function maps a capture file and its index
+ *
+ * The index file has the same name of the capture file with the
+ * CAPTURE_INDEX_EXTENSION extension: if it is not present or not valid,
+ * the index is built in memory.
+ *
+ * @param filename: the capture file
+ * @return true in case of success
+ */
+bool captureReader::open(const QString& filename){
+    close();
+
+    file = new QFile(filename);
+    if(!file->open(QIODevice::ReadOnly)){
+        close();
+        return false;
+    }
+
+    qint64 size = file->size();
+    uchar* map = (size >= (qint64) sizeof(captureFileHeader)) ? file->map(0, size) : nullptr;
+    header = (const captureFileHeader*) map;
+    if((!map) || (memcmp(header->magic, CAPTURE_MAGIC, 8)) || (header->version != CAPTURE_VERSION) || (header->recordSize != sizeof(captureRecord))){
+        close();
+        return false;
+    }
+
+    records = (const captureRecord*) (map + sizeof(captureFileHeader));
+    count = (size - sizeof(captureFileHeader)) / sizeof(captureRecord);
+    if(header->records < count) count = header->records;
+    nBlocks = (count + CAPTURE_INDEX_BLOCK - 1) / CAPTURE_INDEX_BLOCK;
+
+    QString indexName = filename;
+    if(indexName.endsWith(CAPTURE_EXTENSION)) indexName.chop(strlen(CAPTURE_EXTENSION));
+    indexName.append(CAPTURE_INDEX_EXTENSION);
+
+    if(!openIndex(indexName)) buildIndex();
+    return true;
+}
+
+/**
+ * @brief This function maps the index file
+ *
+ * @param filename: the index file
+ * @return true if the index file is valid and covers all the records
+ */
+bool captureReader::openIndex(const QString& filename){
+    indexFile = new QFile(filename);
+
+    qint64 size = 0;
+    uchar* map = nullptr;
+    if(indexFile->open(QIODevice::ReadOnly)){
+        size = indexFile->size();
+        if(size >= (qint64) sizeof(captureIndexHeader)) map = indexFile->map(0, size);
+    }
+
+    const captureIndexHeader* index = (const captureIndexHeader*) map;
+    if((!map) || (memcmp(index->magic, CAPTURE_INDEX_MAGIC, 8)) || (index->version != CAPTURE_VERSION) ||
+       (index->blockRecords != CAPTURE_INDEX_BLOCK) || (index->blocks < nBlocks) ||
+       ((quint64) size < sizeof(captureIndexHeader) + nBlocks * sizeof(captureIndexBlock))){
+        if(indexFile->isOpen()) indexFile->close();
+        delete indexFile;
+        indexFile = nullptr;
+        return false;
+    }
+
+    blocks = (const captureIndexBlock*) (map + sizeof(captureIndexHeader));
+    return true;
+}
+
+/**
+ * @brief This function builds the index in memory with a scan of the records
+ */
+void captureReader::buildIndex(void){
+    builtIndex = QByteArray(nBlocks * sizeof(captureIndexBlock), 0);
+    captureIndexBlock* blk = (captureIndexBlock*) builtIndex.data();
+
+    for(quint64 i=0; i<count; i++){
+        captureIndexBlock* b = &blk[i / CAPTURE_INDEX_BLOCK];
+        if(!(i % CAPTURE_INDEX_BLOCK)) b->first = records[i].timestamp;
+        b->last = records[i].timestamp;
+        b->ids[(records[i].id >> 6) & 0x1F] |= ((quint64) 1) << (records[i].id & 0x3F);
+    }
+
+    blocks = blk;
+}
+
+/**
+ * @brief This function returns the first record at or after a timestamp
+ *
+ * The block is found with a binary search on the block last timestamps,
+ * the record with a binary search inside the block.
+ *
+ * @param timestamp: the timestamp (ns from the capture start)
+ * @return the record position (getCount() if all the records are older)
+ */
+quint64 captureReader::seek(qint64 timestamp) const{
+    quint64 lo = 0, hi = nBlocks;
+    while(lo < hi){
+        quint64 mid = (lo + hi) / 2;
+        if(blocks[mid].last < timestamp) lo = mid + 1;
+        else hi = mid;
+    }
+    if(lo >= nBlocks) return count;
+
+    quint64 first = lo * CAPTURE_INDEX_BLOCK;
+    quint64 last = first + CAPTURE_INDEX_BLOCK;
+    if(last > count) last = count;
+
+    while(first < last){
+        quint64 mid = (first + last) / 2;
+        if(records[mid].timestamp < timestamp) first = mid + 1;
+        else last = mid;
+    }
+    return first;
+}
+
+/**
+ * @brief This function returns the next block containing a canId
+ *
+ * @param id: the canId
+ * @param block: the first block to be verified
+ * @return the block index (getBlocks() if not found)
+ */
+quint64 captureReader::nextBlock(quint16 id, quint64 block) const{
+    while((block < nBlocks) && (!blockContains(block, id))) block++;
+    return block;
+}
+
+/**
+ * @brief This function finds the next record of a canId
+ *
+ * Only the records of the blocks containing the canId are read.
+ *
+ * @param id: the canId
+ * @param pos: the first record to be verified; the position of the record found
+ * @return true if a record has been found
+ */
+bool captureReader::findNext(quint16 id, quint64* pos) const{
+    quint64 i = *pos;
+
+    while(i < count){
+        quint64 block = i / CAPTURE_INDEX_BLOCK;
+        if(!blockContains(block, id)){
+            block = nextBlock(id, block + 1);
+            if(block >= nBlocks) break;
+            i = block * CAPTURE_INDEX_BLOCK;
+        }
+
+        quint64 end = (block + 1) * CAPTURE_INDEX_BLOCK;
+        if(end > count) end = count;
+        for(; i < end; i++){
+            if(records[i].id == id){
+                *pos = i;
+                return true;
+            }
+        }
+    }
+
+    *pos = count;
+    return false;
+}
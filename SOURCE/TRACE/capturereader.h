@@ -0,0 +1,79 @@
+#ifndef CAPTUREREADER_H
+#define CAPTUREREADER_H
+
+/*!
+ * \addtogroup  captureModule
+ *
+ * # CAPTURE READER
+ *
+ * The captureReader class maps a capture file and its sidecar index file:
+ * - captureReader::seek() returns the first record at or after a timestamp
+ *   with a binary search on the index blocks and on the records of a single block;
+ * - captureReader::findNext() returns the next record of a given canId,
+ *   skipping the blocks whose bitmap doesn't contain the canId;
+ *
+ * If the index file is missing or not valid (capture recorded before the index
+ * introduction), the index is built in memory with a single scan of the file.
+ *
+ * Usage example (frames of canId 0x581 in the 10 seconds after a timestamp):
+ *
+ *      captureReader reader;
+ *      if(!reader.open(filename)) return;
+ *      quint64 pos = reader.seek(t);
+ *      while(reader.findNext(0x581, &pos)){
+ *          const captureRecord* rec = reader.getRecord(pos);
+ *          if(rec->timestamp > t + 10000000000) break;
+ *          ...
+ *          pos++;
+ *      }
+ */
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include "capturefile.h"
+
+/**
+ * @brief This class implements the indexed reader of a capture file
+ *
+ * \ingroup captureModule
+ */
+class captureReader
+{
+public:
+
+    captureReader();
+    ~captureReader(){close();}
+
+    bool open(const QString& filename); //!< Maps a capture file and its index
+    void close(void); //!< Unmaps the files
+
+    quint64 seek(qint64 timestamp) const; //!< Returns the first record at or after a timestamp
+    quint64 nextBlock(quint16 id, quint64 block) const; //!< Returns the next block containing a canId
+    bool findNext(quint16 id, quint64* pos) const; //!< Finds the next record of a canId
+
+    /// Returns true if the block contains the canId
+    inline bool blockContains(quint64 block, quint16 id) const {return (blocks[block].ids[(id >> 6) & 0x1F] >> (id & 0x3F)) & 1;}
+
+    inline const captureFileHeader* getHeader(void) const {return header;}
+    inline const captureRecord* getRecord(quint64 pos) const {return &records[pos];}
+    inline const captureIndexBlock* getBlock(quint64 block) const {return &blocks[block];}
+    inline quint64 getCount(void) const {return count;}
+    inline quint64 getBlocks(void) const {return nBlocks;}
+    inline bool isIndexFile(void) const {return (indexFile != nullptr);}
+
+private:
+    QFile*                      file;       //!< Capture file
+    QFile*                      indexFile;  //!< Index file (nullptr if the index is built in memory)
+    const captureFileHeader*    header;
+    const captureRecord*        records;    //!< First record in the mapped file
+    quint64                     count;      //!< Valid records
+    const captureIndexBlock*    blocks;     //!< First block entry (index file or built index)
+    quint64                     nBlocks;    //!< Valid blocks
+    QByteArray                  builtIndex; //!< Index built in memory
+
+    bool openIndex(const QString& filename); //!< Maps the index file
+    void buildIndex(void); //!< Builds the index in memory
+};
+
+#endif // CAPTUREREADER_H
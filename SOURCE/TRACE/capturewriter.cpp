@@ -0,0 +1,112 @@
+#include "capturewriter.h"
+#include <cstring>
+
+/**
+ * @brief captureWriter class constructor
+ */
+captureWriter::captureWriter(){
+    buffered = 0;
+    records = 0;
+    error = false;
+    memset(&header, 0, sizeof(header));
+}
+
+/**
+ * @brief This function creates the capture file
+ *
+ * @param filename: the capture file name; the index file has the CAPTURE_INDEX_EXTENSION extension
+ * @param startTime: the capture start (ms since epoch)
+ * @param bitrate: the bus bitrate (0 if not known)
+ * @return true in case of success
+ */
+bool captureWriter::open(const QString& filename, qint64 startTime, uint bitrate){
+    close();
+
+    file.setFileName(filename);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+    indexName = filename;
+    if(indexName.endsWith(CAPTURE_EXTENSION)) indexName.chop(strlen(CAPTURE_EXTENSION));
+    indexName.append(CAPTURE_INDEX_EXTENSION);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CAPTURE_MAGIC, 8);
+    header.version = CAPTURE_VERSION;
+    header.recordSize = sizeof(captureRecord);
+    header.startTime = startTime;
+    header.fileIndex = 0;
+    header.bitrate = bitrate;
+    header.records = 0;
+
+    buffered = 0;
+    records = 0;
+    index.clear();
+    error = (file.write((const char*) &header, sizeof(header)) != sizeof(header));
+    return !error;
+}
+
+/**
+ * @brief This function writes the current block and adds its index entry
+ *
+ * @return true in case of success
+ */
+bool captureWriter::flushBlock(void){
+    if(!buffered) return true;
+
+    captureIndexBlock blk;
+    memset(&blk, 0, sizeof(blk));
+    blk.first = buffer[0].timestamp;
+    blk.last = buffer[buffered - 1].timestamp;
+    for(uint i=0; i<buffered; i++) blk.ids[(buffer[i].id >> 6) & 0x1F] |= ((quint64) 1) << (buffer[i].id & 0x3F);
+    index.append((const char*) &blk, sizeof(blk));
+
+    qint64 size = buffered * sizeof(captureRecord);
+    if(file.write((const char*) buffer, size) != size) error = true;
+    buffered = 0;
+    return !error;
+}
+
+/**
+ * @brief This function appends a record
+ *
+ * @param rec: the record
+ * @return true in case of success
+ */
+bool captureWriter::write(const captureRecord* rec){
+    if(!file.isOpen()) return false;
+
+    buffer[buffered++] = *rec;
+    records++;
+    if(buffered >= CAPTURE_INDEX_BLOCK) return flushBlock();
+    return !error;
+}
+
+/**
+ * @brief This function writes the pending records, the header and the index file
+ *
+ * @return true in case of success
+ */
+bool captureWriter::close(void){
+    if(!file.isOpen()) return !error;
+
+    flushBlock();
+    header.records = records;
+    if((!file.seek(0)) || (file.write((const char*) &header, sizeof(header)) != sizeof(header))) error = true;
+    file.close();
+
+    QFile indexFile(indexName);
+    if(indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        captureIndexHeader idx;
+        memset(&idx, 0, sizeof(idx));
+        memcpy(idx.magic, CAPTURE_INDEX_MAGIC, 8);
+        idx.version = CAPTURE_VERSION;
+        idx.blockRecords = CAPTURE_INDEX_BLOCK;
+        idx.blocks = index.size() / sizeof(captureIndexBlock);
+        indexFile.write((const char*) &idx, sizeof(idx));
+        indexFile.write(index);
+        indexFile.close();
+    }else error = true;
+
+    index.clear();
+    return !error;
+}
@@ -0,0 +1,53 @@
+#ifndef CAPTUREWRITER_H
+#define CAPTUREWRITER_H
+
+/*!
+ * \addtogroup  captureModule
+ *
+ * # CAPTURE WRITER
+ *
+ * The captureWriter class writes a single capture file and its index file
+ * from records produced offline (e.g. the conversion of a candump or ASC trace).
+ *
+ * The records are collected in a block buffer (CAPTURE_INDEX_BLOCK records)
+ * and written with a single write per block; the index is built in memory
+ * and written when the file is closed.
+ */
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include "capturefile.h"
+
+/**
+ * @brief This class implements the offline writer of a capture file
+ *
+ * \ingroup captureModule
+ */
+class captureWriter
+{
+public:
+
+    captureWriter();
+    ~captureWriter(){close();}
+
+    bool open(const QString& filename, qint64 startTime, uint bitrate); //!< Creates the capture file
+    bool write(const captureRecord* rec); //!< Appends a record
+    bool close(void); //!< Writes the pending records, the header and the index file
+
+    inline quint64 getRecords(void){return records;}
+
+private:
+    QFile           file;
+    QString         indexName;      //!< Index file name
+    captureFileHeader header;
+    captureRecord   buffer[CAPTURE_INDEX_BLOCK]; //!< Records of the current block
+    uint            buffered;       //!< Records in the buffer
+    quint64         records;        //!< Records written
+    QByteArray      index;          //!< Block entries
+    bool            error;
+
+    bool flushBlock(void); //!< Writes the current block
+};
+
+#endif // CAPTUREWRITER_H
@@ -0,0 +1,141 @@
+#include "application.h"
+#include "flightrecorder.h"
+#include <QFile>
+#include <QDateTime>
+#include <csignal>
+
+// Dump request set by the operating system signal handler
+static std::atomic<bool> signalDumpRequest(false);
+
+static void dumpSignalHandler(int sig){
+    signalDumpRequest.store(true, std::memory_order_relaxed);
+    std::signal(sig, dumpSignalHandler);
+}
+
+/**
+ * @brief flightRecorder class constructor
+ *
+ * The ring and the dump buffer are allocated and cleared, the dump signal handler is installed.
+ */
+flightRecorder::flightRecorder(){
+    ring = new eventRecord[RING_SIZE];
+    memset(ring, 0, sizeof(eventRecord) * RING_SIZE);
+    snapshot = new eventRecord[RING_SIZE];
+    memset(snapshot, 0, sizeof(eventRecord) * RING_SIZE);
+    writer = nullptr;
+    writeIndex.store(0, std::memory_order_relaxed);
+
+    startTime = QDateTime::currentMSecsSinceEpoch();
+    clock.start();
+
+#ifdef SIGBREAK
+    std::signal(SIGBREAK, dumpSignalHandler);
+#else
+    std::signal(SIGUSR1, dumpSignalHandler);
+#endif
+
+    connect(&signalTimer, SIGNAL(timeout()), this, SLOT(signalPolling()), Qt::UniqueConnection);
+    signalTimer.start(SIGNAL_POLLING);
+}
+
+flightRecorder::~flightRecorder(){
+    signalTimer.stop();
+    if(writer){
+        writer->wait();
+        delete writer;
+    }
+    delete[] snapshot;
+    delete[] ring;
+}
+
+void flightRecorder::signalPolling(void){
+    if(!signalDumpRequest.exchange(false, std::memory_order_relaxed)) return;
+    dumpRequest();
+}
+
+/**
+ * @brief Dump request slot
+ *
+ * The dump is started: the flightRecorder::dumpCompleted() signal
+ * is emitted when the file has been written.
+ */
+void flightRecorder::dumpRequest(void){
+    dump();
+}
+
+/**
+ * @brief This function starts writing the ring content in a new dump file
+ *
+ * The records written up to the request are dumped by the dump thread
+ * (see writeDump()): the function returns immediately.
+ *
+ * @return the dump file name, or an empty string if a dump is in progress
+ */
+QString flightRecorder::dump(void){
+    if(writer){
+        if(writer->isRunning()){
+            qDebug() << "FLIGHT RECORDER: DUMP IN PROGRESS";
+            return QString();
+        }
+        delete writer;
+        writer = nullptr;
+    }
+
+    QString filename = QString("%1candriver_trace_%2.bin").arg(DUMP_PATH).arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss_zzz"));
+    quint64 last = writeIndex.load(std::memory_order_acquire);
+
+    writer = QThread::create([this, filename, last](){ writeDump(filename, last); });
+    writer->start(QThread::LowPriority);
+    return filename;
+}
+
+/**
+ * @brief This function copies the ring and writes the dump file
+ *
+ * The function is executed by the dump thread.
+ *
+ * The records are copied from the oldest to the newest, up to the
+ * record written before the dump request:
+ * a record is copied only if its sequence number is the expected one
+ * before and after the copy (a record overwritten during the copy is discarded).
+ *
+ * The recording continues during the dump.
+ *
+ * @param filename: the dump file name
+ * @param last: the write index at the dump request
+ */
+void flightRecorder::writeDump(const QString& filename, quint64 last){
+    QFile file(filename);
+    if(!file.open(QIODevice::WriteOnly)){
+        qDebug() << "FLIGHT RECORDER: UNABLE TO CREATE " << filename;
+        return;
+    }
+
+    quint64 first = (last > RING_SIZE) ? last - RING_SIZE : 0;
+
+    eventRecord* copy = snapshot;
+    quint32 n = 0;
+    for(quint64 idx = first; idx < last; idx++){
+        eventRecord* rec = &ring[idx & (RING_SIZE - 1)];
+        quint32 expected = (quint32) (idx + 1);
+
+        if(seqOf(rec)->load(std::memory_order_acquire) != expected) continue;
+        memcpy(&copy[n], rec, sizeof(eventRecord));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(seqOf(rec)->load(std::memory_order_relaxed) != expected) continue;
+        n++;
+    }
+
+    dumpHeader header;
+    memcpy(header.magic, "CANFR001", 8);
+    header.recordSize = sizeof(eventRecord);
+    header.records = n;
+    header.startTime = startTime;
+
+    file.write((const char*) &header, sizeof(header));
+    file.write((const char*) copy, (qint64) sizeof(eventRecord) * n);
+    file.close();
+
+    qDebug() << "FLIGHT RECORDER: " << n << " RECORDS DUMPED TO " << filename;
+    emit dumpCompleted(filename);
+}
@@ -0,0 +1,176 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+/*!
+ * \defgroup  flightrecorderModule Flight Recorder Module.
+ *
+ * This Module implements an always-on binary trace of the Application activity,
+ * to be dumped on demand when a glitch is observed on the field.
+ *
+ * # RECORDED EVENTS
+ *
+ * The following events are recorded (see flightRecorder::_EventType):
+ * - every frame received and sent on the bus;
+ * - the Point to Point transaction start, completion and timeout;
+ * - the Client connection and disconnection;
+ * - every scheduling tick of the CAN driver;
+ *
+ * # RING BUFFER
+ *
+ * The events are stored in a fixed-size ring of flightRecorder::RING_SIZE records,
+ * allocated at startup: when the ring is full, the oldest records are overwritten.
+ *
+ * The ring is lock-free:
+ * - a writer reserves a slot with an atomic increment of the write index;
+ * - the record is filled and then published writing its sequence number (release order);
+ * - the dump copies only the records whose sequence number is consistent,
+ *   so that a record overwritten during the dump is discarded.
+ *
+ * The record cost is a timestamp read, an atomic increment and a 32 bytes write.
+ *
+ * # DUMP
+ *
+ * The ring content is written to a binary file:
+ * - with the Interface command DumpFlightRecorder;
+ * - with the operating system signal SIGBREAK (Ctrl+Break) on Windows or SIGUSR1 on the other systems;
+ *
+ * The dump file is written in the flightRecorder::DUMP_PATH directory, with the format:
+ * - header (flightRecorder::dumpHeader): magic "CANFR001", record size, number of records,
+ *   wall clock time (ms since epoch) of the timestamp zero;
+ * - records (flightRecorder::eventRecord), from the oldest to the newest.
+ *
+ * All the numeric fields are little endian.
+ *
+ * The dump doesn't stall the CAN scheduling: the request only takes the current write index
+ * and starts the dump thread, copying the records in a buffer allocated at startup
+ * and writing the file. A new dump is refused while the previous one is in progress;
+ * the flightRecorder::dumpCompleted() signal is emitted when the file is written.
+ *
+ */
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <cstring>
+
+/**
+ * @brief This class implements the flight recorder trace ring
+ *
+ * \ingroup flightrecorderModule
+ */
+class flightRecorder: public QObject
+{
+    Q_OBJECT
+
+public:
+
+    flightRecorder();
+    ~flightRecorder();
+
+    static const uint RING_BITS = 18;                   //!< Ring size as a power of two
+    static const uint RING_SIZE = 1 << RING_BITS;       //!< Number of records in the ring
+    static const uint SIGNAL_POLLING = 100;             //!< Polling period in ms of the dump signal
+    static constexpr const char* DUMP_PATH = "C:/OEM/Gantry/Log/"; //!< Directory of the dump files
+
+    /// This enumeration defines the event types
+    typedef enum{
+        _FR_RX_FRAME = 1,       //!< Frame received: id, dlc, data
+        _FR_TX_FRAME,           //!< Frame sent: id, dlc, data
+        _FR_P2P_START,          //!< P2P request sent: id, client, value = attempt
+        _FR_P2P_COMPLETE,       //!< P2P answer received: id, client, value = answer time (us)
+        _FR_P2P_TIMEOUT,        //!< P2P answer timeout: id, client, value = attempt
+        _FR_CLIENT_CONNECT,     //!< Client connected: client
+        _FR_CLIENT_DISCONNECT,  //!< Client disconnected: client
+        _FR_TICK                //!< Scheduling tick: value = frames read
+    }_EventType;
+
+    /// This is the record of a single event (32 bytes)
+    typedef struct{
+        quint32 seq;        //!< Sequence number + 1 of the record, modulo 2^32 (0 = empty)
+        quint32 value;      //!< Event specific value
+        qint64  timestamp;  //!< Time in ns from the recorder start
+        quint16 id;         //!< canId
+        quint16 client;     //!< Client identifier
+        quint8  type;       //!< Event type (see _EventType)
+        quint8  dlc;        //!< Frame length
+        quint8  reserved[2];
+        quint8  data[8];    //!< Frame content
+    }eventRecord;
+
+    /// This is the header of the dump file
+    typedef struct{
+        char    magic[8];       //!< "CANFR001"
+        quint32 recordSize;     //!< Size of a record
+        quint32 records;        //!< Number of records in the file
+        qint64  startTime;      //!< Wall clock time (ms since epoch) of the timestamp zero
+    }dumpHeader;
+
+    /// Records an event
+    inline void record(uchar type, ushort id, ushort client, quint32 value){
+        quint64 idx;
+        eventRecord* rec = reserve(&idx);
+        rec->value = value;
+        rec->id = id;
+        rec->client = client;
+        rec->type = type;
+        rec->dlc = 0;
+        publish(rec, idx);
+    }
+
+    /// Records a frame event
+    inline void recordFrame(uchar type, ushort id, const uchar* data, uchar dlc){
+        quint64 idx;
+        eventRecord* rec = reserve(&idx);
+        rec->value = 0;
+        rec->id = id;
+        rec->client = 0;
+        rec->type = type;
+        rec->dlc = dlc;
+        memcpy(rec->data, data, 8);
+        publish(rec, idx);
+    }
+
+    QString dump(void); //!< Starts writing the ring content in a new dump file
+
+signals:
+    void dumpCompleted(QString filename); //!< Emitted when a dump file has been written
+
+public slots:
+    void dumpRequest(void); //!< Dump request slot
+
+private slots:
+    void signalPolling(void); //!< Polls the operating system dump signal
+
+private:
+    eventRecord*            ring;       //!< Ring buffer
+    eventRecord*            snapshot;   //!< Copy of the ring written by the dump thread
+    QThread*                writer;     //!< Dump thread (nullptr if no dump has been started)
+    std::atomic<quint64>    writeIndex; //!< Index of the next record
+    QElapsedTimer           clock;      //!< Time base of the records
+    qint64                  startTime;  //!< Wall clock time of the time base start (ms since epoch)
+    QTimer                  signalTimer; //!< Dump signal polling timer
+
+    void writeDump(const QString& filename, quint64 last); //!< Copies the ring and writes the dump file (dump thread)
+
+    static inline std::atomic<quint32>* seqOf(eventRecord* rec){return reinterpret_cast<std::atomic<quint32>*>(&rec->seq);}
+
+    /// Reserves the next record: the record is marked as under writing
+    inline eventRecord* reserve(quint64* idx){
+        *idx = writeIndex.fetch_add(1, std::memory_order_relaxed);
+        eventRecord* rec = &ring[*idx & (RING_SIZE - 1)];
+        seqOf(rec)->store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        rec->timestamp = clock.nsecsElapsed();
+        return rec;
+    }
+
+    /// Publishes a record filled by the writer
+    inline void publish(eventRecord* rec, quint64 idx){
+        seqOf(rec)->store((quint32) (idx + 1), std::memory_order_release);
+    }
+};
+
+#endif // FLIGHTRECORDER_H
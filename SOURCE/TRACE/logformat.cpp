@@ -0,0 +1,320 @@
+#include "logformat.h"
+#include <QDateTime>
+#include <cstring>
+#include <cstdio>
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+/**
+ * @brief This function returns the format of a name
+ *
+ * @param name: "candump" or "asc"
+ * @param format: the format
+ * @return true if the name is valid
+ */
+bool logFormat::getFormat(const QString& name, _Format* format){
+    if(name == "candump") *format = _FORMAT_CANDUMP;
+    else if(name == "asc") *format = _FORMAT_ASC;
+    else return false;
+    return true;
+}
+
+/**
+ * @brief This function formats a time as seconds.microseconds
+ *
+ * @param p: the output position
+ * @param ns: the time (ns), not negative
+ * @param width: min width of the seconds field (right aligned with spaces)
+ * @return the next output position
+ */
+char* logFormat::putTime(char* p, qint64 ns, int width){
+    if(ns < 0) ns = 0;
+    quint64 sec = ns / 1000000000;
+    uint us = (ns % 1000000000) / 1000;
+
+    char digits[20];
+    int n = 0;
+    do{
+        digits[n++] = '0' + (sec % 10);
+        sec /= 10;
+    }while(sec);
+
+    for(int i=n; i<width; i++) *p++ = ' ';
+    while(n) *p++ = digits[--n];
+
+    *p++ = '.';
+    for(int i=100000; i; i /= 10){
+        *p++ = '0' + (us / i);
+        us %= i;
+    }
+    return p;
+}
+
+char* logFormat::putHex(char* p, uint value, int digits){
+    for(int i=digits-1; i>=0; i--) *p++ = hexDigits[(value >> (i * 4)) & 0xF];
+    return p;
+}
+
+/**
+ * @brief This function formats a candump line
+ *
+ * Format: (seconds.microseconds) iface ID#DATA
+ *
+ * @param buf: the output buffer (at least MAX_LINE bytes)
+ * @param epochNs: the frame time (ns since epoch)
+ * @param iface: the interface name
+ * @param rec: the frame
+ * @return the line length (new line included)
+ */
+int logFormat::formatCandump(char* buf, qint64 epochNs, const char* iface, const captureRecord* rec){
+    char* p = buf;
+    *p++ = '(';
+    p = putTime(p, epochNs, 0);
+    *p++ = ')';
+    *p++ = ' ';
+    for(int i=0; iface[i] && (i < 16); i++) *p++ = iface[i];
+    *p++ = ' ';
+    p = putHex(p, rec->id & 0x7FF, 3);
+    *p++ = '#';
+
+    uchar dlc = (rec->dlc > 8) ? 8 : rec->dlc;
+    if(rec->flags & CAPTURE_FLAG_REMOTE){
+        *p++ = 'R';
+        if(dlc) *p++ = '0' + dlc;
+    }else{
+        for(uchar i=0; i<dlc; i++) p = putHex(p, rec->data[i], 2);
+    }
+
+    *p++ = '\n';
+    return (int) (p - buf);
+}
+
+/**
+ * @brief This function formats an ASC line
+ *
+ * Format: time 1  ID             Rx|Tx   d DLC XX XX ..
+ *
+ * @param buf: the output buffer (at least MAX_LINE bytes)
+ * @param timeNs: the frame time from the measurement start (ns)
+ * @param rec: the frame
+ * @return the line length (new line included)
+ */
+int logFormat::formatAsc(char* buf, qint64 timeNs, const captureRecord* rec){
+    char* p = buf;
+    p = putTime(p, timeNs, 4);
+    memcpy(p, " 1  ", 4);
+    p += 4;
+
+    char* id = p;
+    p = putHex(p, rec->id & 0x7FF, 3);
+    while(p - id < 16) *p++ = ' ';
+
+    memcpy(p, (rec->direction == _CAPTURE_TX) ? "Tx   " : "Rx   ", 5);
+    p += 5;
+
+    uchar dlc = (rec->dlc > 8) ? 8 : rec->dlc;
+    if(rec->flags & CAPTURE_FLAG_REMOTE){
+        *p++ = 'r';
+    }else{
+        *p++ = 'd';
+        *p++ = ' ';
+        *p++ = '0' + dlc;
+        for(uchar i=0; i<dlc; i++){
+            *p++ = ' ';
+            p = putHex(p, rec->data[i], 2);
+        }
+    }
+
+    *p++ = '\n';
+    return (int) (p - buf);
+}
+
+/**
+ * @brief This function formats the ASC header
+ *
+ * @param buf: the output buffer (at least MAX_HEADER bytes)
+ * @param epochMs: the measurement start (ms since epoch)
+ * @return the header length
+ */
+int logFormat::formatAscHeader(char* buf, qint64 epochMs){
+    QByteArray date = QDateTime::fromMSecsSinceEpoch(epochMs).toString("ddd MMM dd hh:mm:ss.zzz ap yyyy").toLatin1();
+    return snprintf(buf, MAX_HEADER,
+                    "date %s\nbase hex  timestamps absolute\nno internal events logged\n// version 9.0.0\n"
+                    "Begin Triggerblock %s\n   0.000000 Start of measurement\n", date.constData(), date.constData());
+}
+
+int logFormat::formatAscFooter(char* buf){
+    return snprintf(buf, MAX_HEADER, "End TriggerBlock\n");
+}
+
+void logFormat::skipSpaces(const char** p, const char* end){
+    while((*p < end) && ((**p == ' ') || (**p == '\t'))) (*p)++;
+}
+
+/**
+ * @brief This function parses a time in seconds[.fraction]
+ *
+ * @param p: the input position, moved after the time
+ * @param end: the end of the line
+ * @param ns: the time (ns)
+ * @return true if a valid time is present
+ */
+bool logFormat::getTime(const char** p, const char* end, qint64* ns){
+    const char* s = *p;
+    qint64 sec = 0;
+    qint64 frac = 0;
+    qint64 scale = 100000000;
+
+    if((s >= end) || (*s < '0') || (*s > '9')) return false;
+    while((s < end) && (*s >= '0') && (*s <= '9')) sec = sec * 10 + (*s++ - '0');
+
+    if((s < end) && (*s == '.')){
+        s++;
+        while((s < end) && (*s >= '0') && (*s <= '9')){
+            frac += (*s++ - '0') * scale;
+            scale /= 10;
+        }
+    }
+
+    *ns = sec * 1000000000 + frac;
+    *p = s;
+    return true;
+}
+
+bool logFormat::getHex(const char** p, const char* end, uint* value){
+    const char* s = *p;
+    uint v = 0;
+    int n = 0;
+
+    for(; s < end; s++, n++){
+        char c = *s;
+        if((c >= '0') && (c <= '9')) v = (v << 4) | (c - '0');
+        else if((c >= 'A') && (c <= 'F')) v = (v << 4) | (c - 'A' + 10);
+        else if((c >= 'a') && (c <= 'f')) v = (v << 4) | (c - 'a' + 10);
+        else break;
+        if(n >= 8) return false;
+    }
+
+    if(!n) return false;
+    *value = v;
+    *p = s;
+    return true;
+}
+
+/**
+ * @brief This function parses a candump line
+ *
+ * The direction of the frame is RX, the client field is CAPTURE_NO_CLIENT.
+ * The extended frames and the CAN FD frames are not accepted.
+ *
+ * @param line: the line start
+ * @param end: the line end (new line excluded)
+ * @param epochNs: the frame time (ns since epoch)
+ * @param rec: the parsed frame (timestamp not set)
+ * @return true if the line is a valid frame
+ */
+bool logFormat::parseCandump(const char* line, const char* end, qint64* epochNs, captureRecord* rec){
+    const char* p = line;
+    skipSpaces(&p, end);
+    if((p >= end) || (*p++ != '(')) return false;
+    if(!getTime(&p, end, epochNs)) return false;
+    if((p >= end) || (*p++ != ')')) return false;
+
+    // Interface name
+    skipSpaces(&p, end);
+    while((p < end) && (*p != ' ') && (*p != '\t')) p++;
+    skipSpaces(&p, end);
+
+    const char* idStart = p;
+    uint id;
+    if(!getHex(&p, end, &id)) return false;
+    if((p - idStart > 3) || (id > 0x7FF)) return false;
+    if((p >= end) || (*p++ != '#')) return false;
+
+    memset(rec, 0, sizeof(captureRecord));
+    rec->id = id;
+    rec->client = CAPTURE_NO_CLIENT;
+    rec->flags = CAPTURE_FLAG_STANDARD;
+    rec->direction = _CAPTURE_RX;
+
+    if((p < end) && ((*p == 'R') || (*p == 'r'))){
+        p++;
+        rec->flags |= CAPTURE_FLAG_REMOTE;
+        if((p < end) && (*p >= '0') && (*p <= '8')) rec->dlc = *p - '0';
+        return true;
+    }
+
+    uchar dlc = 0;
+    while((p + 1 < end) && (dlc < 8)){
+        if(*p == '.'){
+            p++;
+            continue;
+        }
+        const char* byteEnd = p + 2;
+        uint value;
+        if((!getHex(&p, byteEnd, &value)) || (p != byteEnd)) return false;
+        rec->data[dlc++] = value;
+    }
+    rec->dlc = dlc;
+    return true;
+}
+
+/**
+ * @brief This function parses an ASC line
+ *
+ * Only the classic CAN data and remote frames with a standard identifier are accepted:
+ * the header, the comments and the events return false.
+ *
+ * @param line: the line start
+ * @param end: the line end (new line excluded)
+ * @param timeNs: the frame time from the measurement start (ns)
+ * @param rec: the parsed frame (timestamp not set)
+ * @return true if the line is a valid frame
+ */
+bool logFormat::parseAsc(const char* line, const char* end, qint64* timeNs, captureRecord* rec){
+    const char* p = line;
+    skipSpaces(&p, end);
+    if(!getTime(&p, end, timeNs)) return false;
+
+    // Channel
+    skipSpaces(&p, end);
+    if((p >= end) || (*p < '0') || (*p > '9')) return false;
+    while((p < end) && (*p >= '0') && (*p <= '9')) p++;
+
+    skipSpaces(&p, end);
+    uint id;
+    if(!getHex(&p, end, &id)) return false;
+    if((id > 0x7FF) || ((p < end) && (*p != ' ') && (*p != '\t'))) return false;
+
+    memset(rec, 0, sizeof(captureRecord));
+    rec->id = id;
+    rec->client = CAPTURE_NO_CLIENT;
+    rec->flags = CAPTURE_FLAG_STANDARD;
+
+    skipSpaces(&p, end);
+    if(end - p < 2) return false;
+    if(((p[0] == 'R') || (p[0] == 'r')) && ((p[1] == 'x') || (p[1] == 'X'))) rec->direction = _CAPTURE_RX;
+    else if(((p[0] == 'T') || (p[0] == 't')) && ((p[1] == 'x') || (p[1] == 'X'))) rec->direction = _CAPTURE_TX;
+    else return false;
+    p += 2;
+
+    skipSpaces(&p, end);
+    if(p >= end) return false;
+    if(*p == 'r'){
+        rec->flags |= CAPTURE_FLAG_REMOTE;
+        return true;
+    }
+    if(*p++ != 'd') return false;
+
+    skipSpaces(&p, end);
+    if((p >= end) || (*p < '0') || (*p > '8')) return false;
+    rec->dlc = *p++ - '0';
+
+    for(uchar i=0; i<rec->dlc; i++){
+        skipSpaces(&p, end);
+        uint value;
+        if(!getHex(&p, end, &value) || (value > 0xFF)) return false;
+        rec->data[i] = value;
+    }
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+/*!
+ * \addtogroup  captureModule
+ *
+ * # STANDARD LOG FORMATS
+ *
+ * The logFormat class converts the capture records from/to the text formats
+ * of the standard CAN tools:
+ * - candump (SocketCAN candump -l): "(1690000000.123456) can0 123#11223344";
+ * - ASC (Vector): "   1.234567 1  123             Rx   d 4 11 22 33 44";
+ *
+ * The numbers are formatted and parsed with dedicated routines working on
+ * caller buffers: no memory is allocated for a line, so that the conversion
+ * of a large trace is limited only by the I/O.
+ *
+ * The remote frames are "123#R" (candump) and "... Rx   r" (ASC).
+ * The candump format has no direction: the imported frames are RX frames.
+ */
+
+#include <QtGlobal>
+#include <QString>
+#include "capturefile.h"
+
+/**
+ * @brief This class implements the candump and ASC line formatting and parsing
+ *
+ * \ingroup captureModule
+ */
+class logFormat
+{
+public:
+
+    static const int MAX_LINE = 128;    //!< Max length of a formatted line
+    static const int MAX_HEADER = 512;  //!< Max length of the ASC header
+
+    /// This enumeration defines the text formats
+    typedef enum{
+        _FORMAT_CANDUMP = 0,    //!< SocketCAN candump log
+        _FORMAT_ASC             //!< Vector ASC
+    }_Format;
+
+    static bool getFormat(const QString& name, _Format* format); //!< Returns the format of a name (candump or asc)
+
+    static int formatCandump(char* buf, qint64 epochNs, const char* iface, const captureRecord* rec); //!< Formats a candump line
+    static int formatAsc(char* buf, qint64 timeNs, const captureRecord* rec); //!< Formats an ASC line
+    static int formatAscHeader(char* buf, qint64 epochMs); //!< Formats the ASC header
+    static int formatAscFooter(char* buf); //!< Formats the ASC footer
+
+    static bool parseCandump(const char* line, const char* end, qint64* epochNs, captureRecord* rec); //!< Parses a candump line
+    static bool parseAsc(const char* line, const char* end, qint64* timeNs, captureRecord* rec); //!< Parses an ASC line
+
+private:
+    static char* putTime(char* p, qint64 ns, int width); //!< Formats seconds.microseconds
+    static char* putHex(char* p, uint value, int digits); //!< Formats a fixed width hex value
+    static bool getTime(const char** p, const char* end, qint64* ns); //!< Parses seconds[.fraction]
+    static bool getHex(const char** p, const char* end, uint* value); //!< Parses a hex value
+    static void skipSpaces(const char** p, const char* end);
+};
+
+#endif // LOGFORMAT_H
@@ -0,0 +1,252 @@
+#include "trafficmodel.h"
+#include <QString>
+#include <QVariant>
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief This function formats the data bytes of a frame
+ *
+ * @param data: the data bytes
+ * @param dlc: the data length (max 8)
+ * @return the hex bytes separated by a space
+ */
+static QString formatData(const uchar* data, uchar dlc){
+    static const char hexDigits[] = "0123456789ABCDEF";
+    char buf[24];
+    char* p = buf;
+
+    for(uchar i=0; i<dlc; i++){
+        if(i) *p++ = ' ';
+        *p++ = hexDigits[data[i] >> 4];
+        *p++ = hexDigits[data[i] & 0xF];
+    }
+    return QString::fromLatin1(buf, p - buf);
+}
+
+/**
+ * @brief canTrafficModel class constructor
+ *
+ * @param parent: the parent object
+ */
+canTrafficModel::canTrafficModel(QObject* parent) : QAbstractTableModel(parent){
+    written = 0;
+    first = 0;
+    shown = 0;
+}
+
+/**
+ * @brief This function stores a frame
+ *
+ * The frame is copied in the ring and shown at the next refresh().
+ * When the ring is full the oldest frame is overwritten: that row is removed
+ * from the view at the next refresh().
+ *
+ * @param frame: the frame read from the tap
+ */
+void canTrafficModel::push(const tapFrame* frame){
+    ring[written % CAPACITY] = *frame;
+    written++;
+}
+
+/**
+ * @brief This function shows the frames stored since the last refresh
+ *
+ * The rows overwritten in the ring are removed from the top and the new rows
+ * are appended at the bottom with a single notification each.
+ */
+void canTrafficModel::refresh(void){
+    quint64 end = written;
+    if(end == shown) return;
+
+    quint64 newFirst = (end > (quint64) CAPACITY) ? end - CAPACITY : 0;
+
+    // All the rows have been overwritten
+    if(newFirst >= shown){
+        beginResetModel();
+        first = newFirst;
+        shown = end;
+        endResetModel();
+        return;
+    }
+
+    if(newFirst > first){
+        beginRemoveRows(QModelIndex(), 0, (int) (newFirst - first - 1));
+        first = newFirst;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), (int) (shown - first), (int) (end - first - 1));
+    shown = end;
+    endInsertRows();
+}
+
+/**
+ * @brief This function removes all the frames
+ */
+void canTrafficModel::clear(void){
+    beginResetModel();
+    written = 0;
+    first = 0;
+    shown = 0;
+    endResetModel();
+}
+
+int canTrafficModel::rowCount(const QModelIndex& parent) const{
+    if(parent.isValid()) return 0;
+    return (int) (shown - first);
+}
+
+int canTrafficModel::columnCount(const QModelIndex& parent) const{
+    if(parent.isValid()) return 0;
+    return _COL_NUM;
+}
+
+/**
+ * @brief This function formats a cell of the model
+ *
+ * The function is called by the view only for the visible rows.
+ */
+QVariant canTrafficModel::data(const QModelIndex& index, int role) const{
+    if((role != Qt::DisplayRole) || (!index.isValid())) return QVariant();
+    if((index.row() < 0) || ((quint64) index.row() >= shown - first)) return QVariant();
+
+    const tapFrame* entry = &ring[(first + index.row()) % CAPACITY];
+    switch(index.column()){
+    case _COL_TIME: return QString::number((double) entry->time / 1000000000.0, 'f', 6);
+    case _COL_DIR: return QString((entry->direction == canTap::_TAP_TX) ? "TX" : "RX");
+    case _COL_ID: return QString("0x%1").arg(entry->id, 3, 16, QChar('0'));
+    case _COL_DLC: return QVariant((uint) entry->dlc);
+    case _COL_DATA: return formatData(entry->data, entry->dlc);
+    }
+    return QVariant();
+}
+
+QVariant canTrafficModel::headerData(int section, Qt::Orientation orientation, int role) const{
+    if((role != Qt::DisplayRole) || (orientation != Qt::Horizontal)) return QVariant();
+
+    switch(section){
+    case _COL_TIME: return QString("TIME(s)");
+    case _COL_DIR: return QString("DIR");
+    case _COL_ID: return QString("CANID");
+    case _COL_DLC: return QString("DLC");
+    case _COL_DATA: return QString("DATA");
+    }
+    return QVariant();
+}
+
+/**
+ * @brief canIdModel class constructor
+ *
+ * @param parent: the parent object
+ */
+canIdModel::canIdModel(QObject* parent) : QAbstractTableModel(parent){
+    memset(ids, 0, sizeof(ids));
+    newIds = false;
+    rateTimer.start();
+}
+
+/**
+ * @brief This function counts a frame
+ *
+ * @param frame: the frame read from the tap
+ */
+void canIdModel::push(const tapFrame* frame){
+    idEntry* entry = &ids[frame->id & (MAX_ID - 1)];
+    if(!entry->shown) newIds = true;
+    entry->count++;
+    entry->direction = frame->direction;
+    entry->dlc = frame->dlc;
+    memcpy(entry->data, frame->data, 8);
+}
+
+/**
+ * @brief This function inserts the new identifiers and updates the rows
+ *
+ * The rates are updated every RATE_PERIOD ms; the content of all the rows
+ * is notified with a single dataChanged().
+ */
+void canIdModel::refresh(void){
+    if(newIds){
+        newIds = false;
+        for(int id=0; id<MAX_ID; id++){
+            if((!ids[id].count) || (ids[id].shown)) continue;
+
+            int row = (int) (std::lower_bound(rows.begin(), rows.end(), (ushort) id) - rows.begin());
+            beginInsertRows(QModelIndex(), row, row);
+            rows.insert(row, (ushort) id);
+            ids[id].shown = true;
+            endInsertRows();
+        }
+    }
+
+    if(rows.isEmpty()) return;
+
+    qint64 elapsed = rateTimer.elapsed();
+    if(elapsed >= RATE_PERIOD){
+        rateTimer.start();
+        for(int i=0; i<rows.size(); i++){
+            idEntry* entry = &ids[rows[i]];
+            entry->rate = (double) (entry->count - entry->rateCount) * 1000.0 / elapsed;
+            entry->rateCount = entry->count;
+        }
+    }
+
+    emit dataChanged(index(0, 0), index(rows.size() - 1, _COL_NUM - 1));
+}
+
+/**
+ * @brief This function removes all the identifiers
+ */
+void canIdModel::clear(void){
+    beginResetModel();
+    memset(ids, 0, sizeof(ids));
+    rows.clear();
+    newIds = false;
+    rateTimer.start();
+    endResetModel();
+}
+
+int canIdModel::rowCount(const QModelIndex& parent) const{
+    if(parent.isValid()) return 0;
+    return rows.size();
+}
+
+int canIdModel::columnCount(const QModelIndex& parent) const{
+    if(parent.isValid()) return 0;
+    return _COL_NUM;
+}
+
+/**
+ * @brief This function formats a cell of the model
+ *
+ * The function is called by the view only for the visible rows.
+ */
+QVariant canIdModel::data(const QModelIndex& index, int role) const{
+    if((role != Qt::DisplayRole) || (!index.isValid())) return QVariant();
+    if((index.row() < 0) || (index.row() >= rows.size())) return QVariant();
+
+    ushort id = rows.at(index.row());
+    const idEntry* entry = &ids[id];
+    switch(index.column()){
+    case _COL_ID: return QString("0x%1").arg(id, 3, 16, QChar('0'));
+    case _COL_DIR: return QString((entry->direction == canTap::_TAP_TX) ? "TX" : "RX");
+    case _COL_COUNT: return QVariant(entry->count);
+    case _COL_RATE: return QString::number(entry->rate, 'f', 1);
+    case _COL_DATA: return formatData(entry->data, entry->dlc);
+    }
+    return QVariant();
+}
+
+QVariant canIdModel::headerData(int section, Qt::Orientation orientation, int role) const{
+    if((role != Qt::DisplayRole) || (orientation != Qt::Horizontal)) return QVariant();
+
+    switch(section){
+    case _COL_ID: return QString("CANID");
+    case _COL_DIR: return QString("DIR");
+    case _COL_COUNT: return QString("COUNT");
+    case _COL_RATE: return QString("RATE(fr/s)");
+    case _COL_DATA: return QString("LAST DATA");
+    }
+    return QVariant();
+}
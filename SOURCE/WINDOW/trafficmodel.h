@@ -0,0 +1,132 @@
+#ifndef TRAFFICMODEL_H
+#define TRAFFICMODEL_H
+
+/*!
+ * \addtogroup  windowModule
+ *
+ * # CAN TRAFFIC VIEW
+ *
+ * The CAN traffic is shown in two table views of the debug window:
+ * - FRAMES: the last canTrafficModel::CAPACITY frames, one row per frame;
+ * - PER ID: one row per CAN identifier with the frame count, the rate and the last data,
+ *   like a bus monitor (see canIdModel).
+ *
+ * The GUI cost does not depend on the bus load:
+ * - the frames are read from a canTap (see the @ref cantapModule) and only copied
+ *   in a fixed size ring: no string is formatted and no memory is allocated;
+ * - the views are refreshed in batches every canTrafficModel::REFRESH_MS
+ *   with a single insert/remove notification;
+ * - the table views are virtualized: only the visible rows are formatted.
+ *
+ * When more than canTrafficModel::CAPACITY frames are received in a refresh period,
+ * the oldest ones are never shown.
+ */
+
+#include <QAbstractTableModel>
+#include <QElapsedTimer>
+#include <QList>
+#include "cantap.h"
+
+/**
+ * @brief This class implements the ring buffer model of the CAN frames
+ *
+ * \ingroup windowModule
+ */
+class canTrafficModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+
+    explicit canTrafficModel(QObject* parent = nullptr);
+
+    static const int CAPACITY = 10000;  //!< Max rows of the model
+    static const int REFRESH_MS = 100;  //!< Refresh period of the views (ms)
+
+    /// This enumeration defines the columns of the model
+    typedef enum{
+        _COL_TIME = 0,  //!< Time from the driver start (s)
+        _COL_DIR,       //!< Direction
+        _COL_ID,        //!< CAN identifier
+        _COL_DLC,       //!< Data length
+        _COL_DATA,      //!< Data bytes
+        _COL_NUM
+    }_Column;
+
+    void push(const tapFrame* frame); //!< Stores a frame (not shown until the next refresh)
+    void refresh(void); //!< Shows the frames stored since the last refresh
+    void clear(void); //!< Removes all the frames
+
+    inline quint64 getFrames(void){return written;}
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+
+    tapFrame        ring[CAPACITY]; //!< Frame ring
+    quint64         written;        //!< Frames stored (absolute index of the next frame)
+    quint64         first;          //!< Absolute index of the first row
+    quint64         shown;          //!< Absolute index after the last row
+};
+
+/**
+ * @brief This class implements the per identifier aggregated model of the CAN frames
+ *
+ * The rows are sorted by identifier; a new identifier is inserted at the next refresh.
+ * The rate is updated every canIdModel::RATE_PERIOD ms.
+ *
+ * \ingroup windowModule
+ */
+class canIdModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+
+    explicit canIdModel(QObject* parent = nullptr);
+
+    static const int MAX_ID = 0x800;        //!< Number of standard identifiers
+    static const int RATE_PERIOD = 1000;    //!< Rate measurement period (ms)
+
+    /// This enumeration defines the columns of the model
+    typedef enum{
+        _COL_ID = 0,    //!< CAN identifier
+        _COL_DIR,       //!< Direction of the last frame
+        _COL_COUNT,     //!< Frames counted
+        _COL_RATE,      //!< Frames per second
+        _COL_DATA,      //!< Data bytes of the last frame
+        _COL_NUM
+    }_Column;
+
+    void push(const tapFrame* frame); //!< Counts a frame
+    void refresh(void); //!< Inserts the new identifiers and updates the rows
+    void clear(void); //!< Removes all the identifiers
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+
+    /// This is the status of an identifier
+    typedef struct{
+        quint64 count;      //!< Frames counted
+        quint64 rateCount;  //!< Frames counted at the last rate update
+        double  rate;       //!< Frames per second
+        bool    shown;      //!< The identifier has a row
+        uchar   direction;  //!< Direction of the last frame
+        uchar   dlc;        //!< Data length of the last frame
+        uchar   data[8];    //!< Data bytes of the last frame
+    }idEntry;
+
+    idEntry         ids[MAX_ID];    //!< Identifier table
+    QList<ushort>   rows;           //!< Identifiers shown, sorted
+    bool            newIds;         //!< An identifier not shown has been counted
+    QElapsedTimer   rateTimer;      //!< Rate measurement period
+};
+
+#endif // TRAFFICMODEL_H
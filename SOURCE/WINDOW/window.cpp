@@ -1,5 +1,6 @@
 #include "application.h"
 #include "ui_window.h"
+#include <QScrollBar>
 
 
 
@@ -18,6 +19,18 @@ debugWindow::debugWindow(QWidget *parent)
 
     // Set the View to handle the rotation
 
+    // CAN traffic views: fixed row height so that the views only format the visible rows
+    traffic = new canTrafficModel(this);
+    idTraffic = new canIdModel(this);
+    ui->canTable->setModel(traffic);
+    ui->canIdTable->setModel(idTraffic);
+    QTableView* views[] = {ui->canTable, ui->canIdTable};
+    for(QTableView* view : views){
+        view->verticalHeader()->setVisible(false);
+        view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+        view->verticalHeader()->setDefaultSectionSize(16);
+        view->horizontalHeader()->setStretchLastSection(true);
+    }
 
     connect(ui->logClearButton, SIGNAL(pressed()), this, SLOT(onLogClearButton()), Qt::UniqueConnection);
     connect(ui->debugClearButton, SIGNAL(pressed()), this, SLOT(onDebugClearButton()), Qt::UniqueConnection);
@@ -27,11 +40,13 @@ debugWindow::debugWindow(QWidget *parent)
 
 
     pollingTimer  = startTimer(500);
+    refreshTimer = startTimer(canTrafficModel::REFRESH_MS);
 
 }
 
 debugWindow::~debugWindow()
 {
+    if(CAN) CAN->getTaps()->unsubscribe(&tap);
     delete ui;
 }
 
@@ -45,6 +60,7 @@ void debugWindow::exitWindow(void)
 {
 
     if(pollingTimer)    killTimer(pollingTimer);
+    if(refreshTimer)    killTimer(refreshTimer);
 
 }
 
@@ -57,6 +73,27 @@ void debugWindow::timerEvent(QTimerEvent* ev)
         return;
     }
 
+    // Batch refresh of the traffic views: the FRAMES view follows the last frame
+    // only if it is already scrolled to the bottom
+    if(ev->timerId() == refreshTimer)
+    {
+        tapFrame frames[256];
+        uint n;
+        while((n = tap.read(frames, 256))){
+            for(uint i=0; i<n; i++){
+                traffic->push(&frames[i]);
+                idTraffic->push(&frames[i]);
+            }
+        }
+
+        QScrollBar* bar = ui->canTable->verticalScrollBar();
+        bool follow = (bar->value() == bar->maximum());
+        traffic->refresh();
+        idTraffic->refresh();
+        if(follow) ui->canTable->scrollToBottom();
+        return;
+    }
+
 
 }
 
@@ -64,8 +101,8 @@ void debugWindow::timerEvent(QTimerEvent* ev)
  * @brief This function clears the content of the Can frame data logging
  */
 void debugWindow::onLogClearButton(void){
-    ui->canText->appendPlainText("");
-    ui->canText->clear();
+    traffic->clear();
+    idTraffic->clear();
 }
 
 /**
@@ -78,91 +115,58 @@ void debugWindow::onDebugClearButton(void){
 
 
 /**
- * @brief This function receives the data coming from the CAN network.
- *
- * The Data packet received from the CAN network is displayed with the message number in the proper panel.
- *
- *
- * @param canId: this is the canId of the can message
- * @param data: this is the data content of the frame
- */
-void debugWindow::receivedCanFrame(ushort canId, QByteArray data){
-
-    QString stringa = QString("%1> FROM CANID:0x%3 - ").arg(((double) clock())/CLOCKS_PER_SEC).arg(canId,1,16);
-    for(int i=0; i< 8;i++){
-        stringa.append(QString(" 0x%1").arg((uchar) data[i],1,16));
-    }
-    ui->canText->appendPlainText(stringa);
-
-}
-
-/**
- * @brief This function is activated whenever the Client data are forwarded to the CAN network.
- *
- * The data content is Logged in the Can Data traffic panel
+ * @brief This function subscribes the tap with the enabled directions
  *
- * @param canId: this is the canId of the can message
- * @param data: this is the data content of the frame
+ * The tap is unsubscribed when both the directions are disabled:
+ * in that case the driver does not copy any frame for the window.
  */
-void debugWindow::sendToCan(ushort canId, QByteArray data){
+void debugWindow::updateTap(void){
+    uint directions = 0;
+    if(ui->logEnableCheck->isChecked()) directions |= canTap::DIR_RX;
+    if(ui->logEnableEthCheck->isChecked()) directions |= canTap::DIR_TX;
 
-    QString stringa = QString("%1> TO CANID:0x%3 - ").arg(((double) clock())/CLOCKS_PER_SEC).arg(canId,1,16);
-    for(int i=0; i< data.size();i++){
-        stringa.append(QString(" 0x%1").arg((uchar) data[i],1,16));
+    if(!directions){
+        CAN->getTaps()->unsubscribe(&tap);
+        return;
     }
-    ui->canText->appendPlainText(stringa);
 
+    tap.setFilter(0, 0, directions);
+    CAN->getTaps()->subscribe(&tap);
 }
 
-
 /**
- * @brief This function enables/disables the Can Data loggin
- *
- * The Check box vconnects or disconnects the debugWindow::receivedCanFrame() \n
- * from the CAN signal.
+ * @brief This function enables/disables the logging of the frames received from the CAN bus
  *
  * @param arg1
  */
 void debugWindow::on_logEnableCheck_stateChanged(int arg1)
 {
-
-    static bool connected = false;
-    if(arg1){
-        if(!connected) connect(CAN,SIGNAL(receivedCanFrame(ushort , QByteArray )), WINDOW, SLOT(receivedCanFrame(ushort , QByteArray)),Qt::QueuedConnection);
-        connected = true;
-    }else{
-        disconnect(CAN,SIGNAL(receivedCanFrame(ushort , QByteArray )), WINDOW, SLOT(receivedCanFrame(ushort , QByteArray)));
-        connected = false;
-
-    }
-
+    updateTap();
 }
 
 /**
- * @brief This function enables/disables the Can Data loggin
- *
- * The Check box vconnects or disconnects the debugWindow::receivedCanFrame() \n
- * from the CAN signal.
+ * @brief This function enables/disables the logging of the frames sent to the CAN bus
  *
  * @param arg1
  */
 void debugWindow::on_logEnableEthCheck_stateChanged(int arg1)
 {
-
-    static bool connected = false;
-    if(arg1){
-        if(!connected) connect(CAN,SIGNAL(transmittedCanFrame(ushort , QByteArray )), WINDOW, SLOT(sendToCan(ushort , QByteArray)),Qt::QueuedConnection);
-        connected = true;
-    }else{
-        disconnect(CAN,SIGNAL(transmittedCanFrame(ushort , QByteArray )), WINDOW, SLOT(sendToCan(ushort , QByteArray)));
-        connected = false;
-
-    }
-
+    updateTap();
 }
 
+/**
+ * @brief This function shows a debug message in the debug panel
+ *
+ * The function is called by the logger thread (see the @ref asynclogModule):
+ * the message is appended in the GUI thread.
+ *
+ * @param type: the message type
+ * @param msg: the message
+ */
 void debugWindow::debugMessageHandler(QtMsgType type, QString msg){
     if(!debugWindow::instance) return;
-    if(debugWindow::instance->ui->debugEnable->isChecked())   debugWindow::instance->ui->debugText->appendPlainText(msg);
+    QMetaObject::invokeMethod(debugWindow::instance, [msg](){
+        if(debugWindow::instance->ui->debugEnable->isChecked())   debugWindow::instance->ui->debugText->appendPlainText(msg);
+    }, Qt::QueuedConnection);
 }
 
@@ -9,7 +9,7 @@
  * When the application is launched with the -win option,\n
  * the application generates a GUI Window interface in order to:
  *
- * - Logs the CAN frames data traffic;
+ * - Logs the CAN frames data traffic (see the CAN TRAFFIC VIEW section);
  * - Logs the internal debug strings;
  * - Provides Debug functions to interact with the BUS actors.
  *
@@ -17,6 +17,7 @@
  */
 
 #include <QWidget>
+#include "trafficmodel.h"
 
 
 
@@ -55,8 +56,6 @@ public slots:
 
     void onLogClearButton(void);
     void onDebugClearButton(void);
-    void receivedCanFrame(ushort canId, QByteArray data);
-    void sendToCan(ushort canId, QByteArray data );
 
 
     void timerEvent(QTimerEvent* ev);
@@ -71,6 +70,13 @@ private:
    int pollingTimer;
    int polling;
 
+   canTap tap;                  //!< Observer of the CAN frames
+   canTrafficModel* traffic;    //!< Model of the FRAMES view
+   canIdModel* idTraffic;       //!< Model of the PER ID view
+   int refreshTimer;            //!< Refresh timer of the traffic views
+
+   void updateTap(void); //!< Subscribes the tap with the enabled directions
+
 };
 
 
@@ -33,11 +33,20 @@
  *
  * - -win: allows to run the application with a graphical window to \n
  *      provide manual interaction with the Can Driver. The Debug strings will be
- *      redirect into the Window panel.
+ *      redirect into the Window panel (not available in the headless build).
  * - -log: the Application redirects the debug messages to a file:
  *      C:/OEM/Gantry/candriver.log
  * - -canLoopback: the can driver operates in loopback mode.
+ * - -replay capture [-replaySpeed factor]: the can driver replays a recorded capture \n
+ *      on a simulated bus instead of opening the device (see @ref replayModule).
 
+ * # BUILD TARGETS
+ *
+ * - PROJECT/MCPU_CANDRIVER: the application with the optional debug window (QtWidgets);
+ * - PROJECT/MCPU_CANDRIVER_HEADLESS: the production application, built with the HEADLESS define:
+ *      it runs with a QCoreApplication and it does not link QtGui/QtWidgets nor the debug window;
+ * - PROJECT/CAN_ANALYZER: the offline capture analyzer (see @ref analyzerModule).
+ *
  * # DEPENDENCIES AND CONFIGURATION FILES
  *
  *  The application requires the vsCan Driver installed into the Operating System.
@@ -53,6 +62,12 @@
  * - @ref candriverModule : implements the communication with the can driver.
  * - @ref interfaceModule : implements the communication with Clients over Local Host.
  * - @ref windowModule : this is an optional Windows interface used for Service/Debug;
+ * - @ref metricsModule : optional HTTP endpoint exporting the metrics (see configuration.h);
+ * - @ref flightrecorderModule : always-on binary trace of the last events, dumped on demand;
+ * - @ref captureModule : binary capture of the bus traffic, started and stopped by the Interface;
+ * - @ref replayModule : simulated CAN backend replaying a capture;
+ * - @ref cantapModule : lock-free observers of the CAN frames (debug window, candump tap);
+ * - @ref asynclogModule : asynchronous leveled logger writing the debug messages;
  *
  * # SOFTWARE LICENCING
  *
@@ -70,7 +85,11 @@
  */
 
 
+#ifdef HEADLESS
+#include <QCoreApplication>
+#else
 #include <QApplication>
+#endif
 #include <QObject>
 #include <QTimer>
 
@@ -78,9 +97,16 @@
 
 #include "can_driver.h"
 #include "server.h"
+#ifndef HEADLESS
 #include "window.h"
+#endif
 #include "interface.h"
 #include "sysconfig.h"
+#include "metrics.h"
+#include "flightrecorder.h"
+#include "capture.h"
+#include "candumptap.h"
+#include "asynclog.h"
 
 
 #define SYSCONFIG       pSysConfig
@@ -89,21 +115,37 @@
 #define SERVER          pServer
 #define CAN             pCanDriver
 #define INTERFACE       pInterface
+#define METRICS         pMetrics
+#define TRACE           pTrace
+#define CAPTURE         pCapture
+#define CANDUMP         pCandump
 
 // Global definitions
 #ifdef MAIN_CPP
     Server*   pServer;
     canDriver*   pCanDriver;
+#ifndef HEADLESS
     debugWindow* pWindow;
+#endif
     Interface*                  INTERFACE;
     sysConfig*                  SYSCONFIG;
+    metricsExporter*            METRICS;
+    flightRecorder*             TRACE;
+    captureRecorder*            CAPTURE;
+    candumpTap*                 CANDUMP;
 
 #else
     extern  Server*      SERVER;
     extern  canDriver*   CAN;
+#ifndef HEADLESS
     extern  debugWindow* WINDOW ;
+#endif
     extern Interface*    INTERFACE;
     extern sysConfig*    SYSCONFIG;
+    extern metricsExporter* METRICS;
+    extern flightRecorder* TRACE;
+    extern captureRecorder* CAPTURE;
+    extern candumpTap* CANDUMP;
 #endif
 
 
@@ -8,13 +8,15 @@ class canDriverConfiguration:  public configFile
     public:
 
 
-    #define REVISION     1  // This is the revision code
+    #define REVISION     3  // This is the revision code
     #define CONFIG_FILENAME     "/OEM/Gantry/candriver.ini" // This is the configuration file name and path
 
     // This section defines labels helping the param identification along the application
     #define VIRTUAL_COM         "VIRTUAL_COM"
     #define INTERFACE_ADDRESS   "INTERFACE_ADDRESS"
     #define CAN_SETUP           "CAN_SETUP"
+    #define METRICS_EXPORTER    "METRICS_EXPORTER"
+    #define CANDUMP_TAP         "CANDUMP_TAP"
 
 
 
@@ -24,6 +26,8 @@ class canDriverConfiguration:  public configFile
         {{
             { INTERFACE_ADDRESS,        {{"127.0.0.1", "10001"}},  "ADDRESS OF THE TCP/IP INTERFACE"},
             { CAN_SETUP,                {{"1000", "STANDARD"}},     "Baudrate, STANDARD/LOOPBACK mode"},
+            { METRICS_EXPORTER,         {{"127.0.0.1", "0"}},       "ADDRESS OF THE METRICS HTTP EXPORTER (PORT 0 = DISABLED)"},
+            { CANDUMP_TAP,              {{"127.0.0.1", "0"}},       "ADDRESS OF THE LIVE CANDUMP TAP (PORT 0 = DISABLED)"},
         }}
     })
     {
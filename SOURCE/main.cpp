@@ -2,38 +2,94 @@
 
 #include "application.h"
 #include "applog.h"
+#include "configuration.h"
 
 #include <QFile>
+#include <QElapsedTimer>
 
 
+#ifdef HEADLESS
+/**
+ * @brief Debug message handler of the headless build: there is no window panel
+ */
+static void noWindowHandler(QtMsgType type, QString msg){
+    Q_UNUSED(type);
+    Q_UNUSED(msg);
+}
+#endif
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startup;
+    startup.start();
+
+#ifdef HEADLESS
+    QCoreApplication a(argc, argv);
+    appLog(argc, argv, "C:/OEM/Gantry/Log/mcpu_candriver.log", noWindowHandler);
+    asyncLog::start(); // The appLog output is written by the logger thread
+    if(appLog::isWindow) qDebug() << "-win OPTION NOT AVAILABLE IN THE HEADLESS BUILD";
+#else
     QApplication a(argc, argv);
     appLog(argc, argv, "C:/OEM/Gantry/Log/mcpu_candriver.log", debugWindow::debugMessageHandler);
+    asyncLog::start(); // The appLog output is written by the logger thread
 
     // Create the Window Log if necessary
     if(appLog::isWindow){
         WINDOW = new debugWindow();
         WINDOW->show();
     }
+#endif
 
     SYSCONFIG = new sysConfig(configFile::_CFG_READONLY);
     if(!SYSCONFIG->isFormatCorrect()) {
         qDebug() << " WRONG CONFIGURATION FILE FORMAT!";
+        asyncLog::stop(); // Writes the message before the exit
         exit(1);
     }
 
+    TRACE = new flightRecorder();
+    CAPTURE = new captureRecorder();
     SERVER = new Server(SYSCONFIG->getParam<QString>(SYS_CAN_PROCESS_PARAM,SYS_CAN_IP),SYSCONFIG->getParam<uint>(SYS_CAN_PROCESS_PARAM,SYS_CAN_PORT));
+    SERVER->setStartupReference(startup.msecsSinceReference());
     INTERFACE = new Interface();
 
     bool loopback = false ;
     CAN = new canDriver();
     if(appLog::options.contains("-loopback")) loopback = true;
-    CAN->driverOpen(Application::CAN_BAUDRATE, loopback);
-
 
+    // The Clients can connect while the device is opening:
+    // their requests are queued until the device is ready
     INTERFACE->Start();
     SERVER->Start();
-    return a.exec();
+
+    // Replay mode: -replay capture [-replaySpeed factor]
+    QStringList args = a.arguments();
+    int replayArg = args.indexOf("-replay");
+    if((replayArg > 0) && (replayArg + 1 < args.size())){
+        double speed = 1.0;
+        int speedArg = args.indexOf("-replaySpeed");
+        if((speedArg > 0) && (speedArg + 1 < args.size())) speed = args.at(speedArg + 1).toDouble();
+        CAN->replayOpen(Application::CAN_BAUDRATE, args.at(replayArg + 1), speed);
+    }else CAN->driverOpenAsync(Application::CAN_BAUDRATE, loopback);
+
+    // Optional metrics exporter: disabled with port 0
+    METRICS = nullptr;
+    canDriverConfiguration config;
+    uint metricsPort = config.getParam<uint>(METRICS_EXPORTER, 1);
+    if(metricsPort){
+        METRICS = new metricsExporter(config.getParam<QString>(METRICS_EXPORTER, 0), metricsPort);
+        METRICS->Start();
+    }
+
+    // Optional live candump tap: disabled with port 0
+    CANDUMP = nullptr;
+    uint tapPort = config.getParam<uint>(CANDUMP_TAP, 1);
+    if(tapPort){
+        CANDUMP = new candumpTap(config.getParam<QString>(CANDUMP_TAP, 0), tapPort);
+        CANDUMP->Start();
+    }
+
+    int ret = a.exec();
+    asyncLog::stop();
+    return ret;
 }